@@ -0,0 +1,65 @@
+#ifndef BITOPS_H
+#define BITOPS_H
+#include <cstdint>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+/*
++ Bit tricks on 64-bit words that the bitmaps, filters and hash tables need: counting set bits, finding the lowest set
+bit, and the high half of a 64 by 64 bit multiply. GCC and Clang have builtins for these and MSVC has intrinsics for
+the last two on x64; anywhere else there's a plain C++ version, so every compiler can build the library.
+
++ NOTE: MSVC's __popcnt64 needs a CPU with the POPCNT instruction, which isn't checked for at runtime, so MSVC uses the
+plain version of countBits (it compiles to a handful of shifts and adds).
+*/
+
+// Number of bits that are set in a word
+inline int countBits(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Position of the lowest set bit in a word, which mustn't be 0
+inline int countTrailingZeros(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long position;
+	_BitScanForward64(&position, word);
+	return static_cast<int>(position);
+#else
+	int position = 0;
+	while ((word & 1) == 0) {
+		word >>= 1;
+		position += 1;
+	}
+	return position;
+#endif
+}
+
+// High 64 bits of the 128-bit product of two words
+inline uint64_t multiplyHigh(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+	return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	return __umulh(a, b);
+#else
+	// Schoolbook multiply on 32-bit halves
+	uint64_t aLow = a & 0xFFFFFFFFULL, aHigh = a >> 32;
+	uint64_t bLow = b & 0xFFFFFFFFULL, bHigh = b >> 32;
+	uint64_t lowLow = aLow * bLow;
+	uint64_t highLow = aHigh * bLow;
+	uint64_t lowHigh = aLow * bHigh;
+	uint64_t middle = (lowLow >> 32) + (highLow & 0xFFFFFFFFULL) + lowHigh;
+	return aHigh * bHigh + (highLow >> 32) + (middle >> 32);
+#endif
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+#include <vector>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "LibraryMetrics.h"
+#include "BitOps.h"
+
+/*
++ Blocked Bloom filter, used in front of a lookup so that most lookups for keys that don't exist are answered without
+touching the real structure. A "no" from the filter is always right; a "maybe" means the key is probably there, but
+might not be (a false positive), so the caller still has to look.
+
++ The filter is split into 64-byte blocks, one cache line each. A key only ever touches one block: its hash picks the
+block, and then sets (or checks) one bit in each of the block's eight 64-bit words. So a check is one cache miss, and
+the eight words can be checked at once with SIMD: with AVX2 (e.g. -mavx2 or -march=native) that's done with two
+256-bit registers, and otherwise it's a plain loop over the words.
+
++ NOTE: Keys can't be taken back out of a Bloom filter, so when a key is deleted it's just counted as stale, and stale
+keys and keys added past the capacity both make false positives more likely. The filter keeps track of how often its
+"maybe"s turn out wrong (callers report those with recordFalsePositive), and isDegraded() says when it's time for the
+owner to rebuild it from the keys that are actually there.
+*/
+class BloomFilter {
+private:
+	static const int wordsPerBlock = 8;
+	struct alignas(64) Block {
+		uint64_t words[wordsPerBlock];
+	};
+
+	std::vector<Block> blocks;
+	long long capacity = 0; // keys the filter was sized for
+	double bitsPerKey = 0;
+	long long numKeys = 0; // keys added since the filter was built, including ones that were deleted since
+	long long numStaleKeys = 0; // keys that were deleted since the filter was built
+	long long numQueries = 0; // checks since the filter was built
+	long long numNegatives = 0; // checks answered with a "no"
+	long long numFalsePositives = 0; // "maybe"s that turned out to be wrong
+	long long numRebuilds = 0;
+
+	// Odd constants that spread one 32-bit hash into a different bit for each word of a block
+	static const uint32_t* salts() {
+		static const uint32_t values[wordsPerBlock] = {
+			0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+		};
+		return values;
+	}
+
+	// Remixes the caller's hash (the splitmix64 finalizer), since the block and the bits in it come from different
+	// halves of it, and hashes like FNV-1a don't make the two halves independent enough
+	static uint64_t mix(uint64_t keyHash) {
+		keyHash = (keyHash ^ (keyHash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		keyHash = (keyHash ^ (keyHash >> 27)) * 0x94D049BB133111EBULL;
+		return keyHash ^ (keyHash >> 31);
+	}
+
+	// Block that a key's hash goes into; uses the top 32 bits of the hash so it's independent of the bits in the block
+	const Block& blockFor(uint64_t keyHash) const {
+		return blocks[((keyHash >> 32) * blocks.size()) >> 32];
+	}
+
+	// Bit that a key's hash sets in word i of its block
+	static uint64_t bitMask(uint32_t lowHash, int i) {
+		return uint64_t(1) << ((lowHash * salts()[i]) >> 26);
+	}
+
+public:
+	// Makes a filter for about expectedKeys keys at the given bits per key; 10 bits per key gives roughly a 1% false
+	// positive rate
+	BloomFilter(long long expectedKeys = 0, double _bitsPerKey = 10) {
+		reset(expectedKeys, _bitsPerKey);
+	}
+
+	// Empties the filter and sizes it for a new number of keys; the owner then adds the keys it actually has
+	void reset(long long expectedKeys, double _bitsPerKey = 10) {
+		if (expectedKeys < 64) {
+			expectedKeys = 64;
+		}
+		capacity = expectedKeys;
+		bitsPerKey = _bitsPerKey;
+		long long numBlocks = static_cast<long long>(expectedKeys * bitsPerKey / (64 * wordsPerBlock)) + 1;
+		blocks.assign(numBlocks, Block());
+		numKeys = 0;
+		numStaleKeys = 0;
+		numQueries = 0;
+		numNegatives = 0;
+		numFalsePositives = 0;
+	}
+
+	// Same as reset, but counted as a rebuild in the stats
+	void rebuild(long long expectedKeys) {
+		reset(expectedKeys, bitsPerKey);
+		numRebuilds += 1;
+	}
+
+	void add(uint64_t keyHash) {
+		keyHash = mix(keyHash);
+		Block& block = const_cast<Block&>(blockFor(keyHash));
+		uint32_t lowHash = static_cast<uint32_t>(keyHash);
+		for (int i = 0; i < wordsPerBlock; i++) {
+			block.words[i] |= bitMask(lowHash, i);
+		}
+		numKeys += 1;
+	}
+
+	// Returns false if the key is definitely not there, or true if it might be
+	bool mightContain(uint64_t keyHash) {
+		keyHash = mix(keyHash);
+		const Block& block = blockFor(keyHash);
+		uint32_t lowHash = static_cast<uint32_t>(keyHash);
+		bool found;
+#ifdef __AVX2__
+		const __m256i saltsLow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(salts()));
+		__m256i bitIndexes = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(lowHash)), saltsLow), 26);
+		__m256i one = _mm256_set1_epi64x(1);
+		__m256i masksLow = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bitIndexes)));
+		__m256i masksHigh = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bitIndexes, 1)));
+		__m256i wordsLow = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words));
+		__m256i wordsHigh = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words + 4));
+		// testc is 1 when every bit of the mask is set in the words
+		found = _mm256_testc_si256(wordsLow, masksLow) && _mm256_testc_si256(wordsHigh, masksHigh);
+#else
+		uint64_t missing = 0;
+		for (int i = 0; i < wordsPerBlock; i++) {
+			uint64_t mask = bitMask(lowHash, i);
+			missing |= mask & ~block.words[i];
+		}
+		found = missing == 0;
+#endif
+		numQueries += 1;
+		if (!found) {
+			numNegatives += 1;
+		}
+		return found;
+	}
+
+	// Called by the owner when a "maybe" turned out to be a key that isn't there
+	void recordFalsePositive() {
+		numFalsePositives += 1;
+	}
+
+	// Called by the owner when a key that was added gets deleted
+	void recordRemoval() {
+		numStaleKeys += 1;
+	}
+
+	// Fraction of checks for keys that aren't there that still got a "maybe"
+	double getObservedFalsePositiveRate() {
+		long long absentChecks = numNegatives + numFalsePositives;
+		return absentChecks > 0 ? static_cast<double>(numFalsePositives) / absentChecks : 0.0;
+	}
+
+	// False positive rate we'd expect from how full the filter is: a key that isn't there gets a "maybe" when all
+	// eight of its bits happen to be set, which is about (fraction of bits set)^8
+	double getEstimatedFalsePositiveRate() {
+		uint64_t setBits = 0;
+		for (size_t b = 0; b < blocks.size(); b++) {
+			for (int i = 0; i < wordsPerBlock; i++) {
+				setBits += countBits(blocks[b].words[i]);
+			}
+		}
+		double fill = blocks.empty() ? 0.0 : static_cast<double>(setBits) / (blocks.size() * wordsPerBlock * 64);
+		double rate = 1.0;
+		for (int i = 0; i < wordsPerBlock; i++) {
+			rate *= fill;
+		}
+		return rate;
+	}
+
+	// Whether the filter should be rebuilt: it has more keys than it was sized for, too many of its keys have been
+	// deleted, or (once there have been enough checks to tell) its false positives are well above what it should get
+	bool isDegraded() {
+		if (numKeys > capacity || numStaleKeys > capacity / 4) {
+			return true;
+		}
+		long long absentChecks = numNegatives + numFalsePositives;
+		return absentChecks >= 1000 && getObservedFalsePositiveRate() > 0.05;
+	}
+
+	BloomFilterStats getStats() {
+		BloomFilterStats stats;
+		stats.capacity = capacity;
+		stats.bits = static_cast<long long>(blocks.size()) * wordsPerBlock * 64;
+		stats.keys = numKeys;
+		stats.staleKeys = numStaleKeys;
+		stats.queries = numQueries;
+		stats.negatives = numNegatives;
+		stats.falsePositives = numFalsePositives;
+		stats.observedFalsePositiveRate = getObservedFalsePositiveRate();
+		stats.estimatedFalsePositiveRate = getEstimatedFalsePositiveRate();
+		stats.rebuilds = numRebuilds;
+		return stats;
+	}
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef BOOK_H
 #define BOOK_H
-#include<string>
+#include <iostream>
+#include <string>
 
 // File for the Book Struct
 struct Book {
@@ -9,28 +10,29 @@ struct Book {
 	std::string ISBN;
 	int numPages;
 	bool isAvailable = true; // when added, books are by default available since they were just added
+	int bookID = -1; // small number the library gives each book it holds, used by its indexes; -1 until it's added
 	// Overloading the comparison operators so it lexicographically compares the titles of the Book objects
-	bool operator>(Book& other) {
+	bool operator>(const Book& other) const {
 		return title > other.title;
 	}
-	bool operator>=(Book& other) {
+	bool operator>=(const Book& other) const {
 		return title >= other.title;
 	}
-	bool operator<(Book& other) {
+	bool operator<(const Book& other) const {
 		return title < other.title;
 	}
-	bool operator<=(Book& other) {
+	bool operator<=(const Book& other) const {
 		return title <= other.title;
 	}
 	// Checks if two books are the same essentially; we assume that all of them have their own unique ISBN number
 	// NOTE: This shouldn't be lumped in with the other comparison operator overloading, which is mainly for sorting purposes
-	bool operator==(Book& other) {
+	bool operator==(const Book& other) const {
 		return ISBN == other.ISBN;
 	}
 };
 
 // Overloading output stream for book class
-std::ostream& operator<<(std::ostream& os, Book book) {
+std::ostream& operator<<(std::ostream& os, const Book& book) {
 	os << "("
 		<< book.title << ", "
 		<< book.author << ", "
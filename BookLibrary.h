@@ -1,6 +1,7 @@
 #ifndef BookLibrary_H
 #define BookLibrary_H
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <vector>
 #include "Student.h"
@@ -8,6 +9,28 @@
 #include "HashTable.h"
 #include "linkedList.h"
 #include "utilities.h"
+#include "LibraryMetrics.h"
+#include "RoaringBitmap.h"
+#include "PerfectHashTable.h"
+#include "BloomFilter.h"
+#include "HotTitleCache.h"
+#include "CatalogImage.h"
+#include "TimingWheel.h"
+#include "HoldQueues.h"
+#include "CirculationAnalytics.h"
+#include "CatalogExport.h"
+#include "OperationTrace.h"
+#include "PersistentVector.h"
+#include "TaskScheduler.h"
+#include "LazyCatalog.h"
+#include "CatalogSync.h"
+#include <map>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <algorithm>
 
 // Struct representing issued book entry, which 
 // contains the book that was issued, and who issued the book.
@@ -16,148 +39,1611 @@
 struct issuedBookEntry {
 	Book issuedBook;
 	Student issuedStudent;
+	long long checkoutTime = 0; // when the book was issued, in seconds since the epoch (from the library's clock)
+	long long dueTime = 0; // when it's due back; renewing moves it
+	int loanID = -1; // small number the library gives each loan, used by its due date wheel
 
 	// When overloading the comparison operators foor issuedBookEntry objects, we want to be sorting alphabetically by titles of the books since we are 
 	// kind of more focusing on the books, rather than the students
-	bool operator<(issuedBookEntry& other) {
+	bool operator<(const issuedBookEntry& other) const {
 		return issuedBook < other.issuedBook;
 	}
-	bool operator<=(issuedBookEntry& other) {
+	bool operator<=(const issuedBookEntry& other) const {
 		return issuedBook <= other.issuedBook;
 	}
-	bool operator>(issuedBookEntry& other) {
+	bool operator>(const issuedBookEntry& other) const {
 		return issuedBook > other.issuedBook;
 	}
-	bool operator>=(issuedBookEntry& other) {
+	bool operator>=(const issuedBookEntry& other) const {
 		return issuedBook >= other.issuedBook;
 	}
 
 	// Operator for checking when two issuedBookEntry objects are equal
 	// NOTE: The above overloaded operators are more for sorting purposes, in contrast to this one.
-	bool operator==(issuedBookEntry& other) {
+	bool operator==(const issuedBookEntry& other) const {
 		return (issuedBook == other.issuedBook) && (issuedStudent == other.issuedStudent);
 	}
 };
 
 // Overloading output stream for book class
-std::ostream& operator<<(std::ostream& os, issuedBookEntry bookEntry) {
+std::ostream& operator<<(std::ostream& os, const issuedBookEntry& bookEntry) {
 	os << "('"
 		<< bookEntry.issuedBook.title << "' by "
 		<< bookEntry.issuedBook.author << " - Issued to: "
 		<< bookEntry.issuedStudent.getName() << ", student ID#: "
-		<< bookEntry.issuedStudent.getStudentID() << ")";
+		<< bookEntry.issuedStudent.getStudentID() << ", due: "
+		<< formatDate(bookEntry.dueTime) << ")";
 	return os;
 }
 
+// A loan as the library keeps it. The book is referred to by its book ID, which stays the same for as long as the
+// book is in the library (an issued book can't be deleted), so editing the book can't leave the loan with stale
+// details; issuedBookEntry is the same loan with a copy of the book filled in, for handing out.
+struct LibraryLoan {
+	int bookID = -1;
+	Student issuedStudent;
+	long long checkoutTime = 0;
+	long long dueTime = 0;
+	int loanID = -1;
+};
+
+// Filters for finding books with the library's indexes; the default matches every book
+struct BookQuery {
+	int minPages = 0;
+	int maxPages = INT_MAX;
+	bool onlyAvailable = false;
+};
+
+// What happened to a batch of issues or returns: either every item was applied, or none were and failedItem is the
+// position of the first item that couldn't be, with the reason
+struct BatchResult {
+	bool applied = false;
+	int failedItem = -1;
+	std::string reason;
+};
+
+/*
++ Point-in-time view of a library's books, loans and students, from BookLibrary::takeSnapshot. It never changes once
+it's taken, whatever happens to the library afterwards, so a long report can go through it at its own pace (even on
+another thread) while the desk keeps issuing and returning books.
+
++ The library keeps its books (by book ID) and loans (by loan ID) in persistent vectors of immutable records as well as
+in its own structures, and a snapshot is a copy of those, which is O(1). A change to a book or loan after that swaps in
+a new record and copies only the few tree nodes on its path that the snapshot shares. A loan's record has its book's
+ID rather than a copy of the book, so editing an issued book only swaps in the book's record. Records and nodes that no
+snapshot needs any more are freed when the last snapshot that had them goes away.
+
++ NOTE: Students change rarely, so they're shared as one whole list instead: the first snapshot after a student is
+added or deleted copies the list, and later snapshots share that copy until the next change.
+*/
+class LibrarySnapshot {
+private:
+	PersistentVector<std::shared_ptr<const Book>> books; // by book ID; nullptr for IDs that aren't in use
+	PersistentVector<std::shared_ptr<const LibraryLoan>> loans; // by loan ID; nullptr for IDs that aren't in use
+	std::shared_ptr<const std::vector<Student>> students; // sorted by name
+	int numBooks = 0;
+	int numLoans = 0;
+	long long version = 0; // how many changes the library had made when the snapshot was taken
+
+	friend class BookLibrary;
+
+public:
+	LibrarySnapshot() {}
+
+	// Calls visit(book) for every book, in book ID order
+	template <class Visitor>
+	void forEachBook(Visitor visit) const {
+		books.forEach([&visit](size_t, const std::shared_ptr<const Book>& book) {
+			if (book) {
+				visit(*book);
+			}
+		});
+	}
+
+	// Calls visit(entry) for every loan, in loan ID order; each entry's book is the snapshot's version of it
+	template <class Visitor>
+	void forEachLoan(Visitor visit) const {
+		loans.forEach([this, &visit](size_t, const std::shared_ptr<const LibraryLoan>& loan) {
+			if (loan) {
+				issuedBookEntry entry{ *books.get(loan->bookID), loan->issuedStudent };
+				entry.checkoutTime = loan->checkoutTime;
+				entry.dueTime = loan->dueTime;
+				entry.loanID = loan->loanID;
+				visit(entry);
+			}
+		});
+	}
+
+	// Every book, sorted by title like BookLibrary::getAllBooks
+	std::vector<Book> getAllBooks() const {
+		std::vector<Book> allBooks;
+		allBooks.reserve(numBooks);
+		forEachBook([&allBooks](const Book& book) {
+			allBooks.push_back(book);
+		});
+		mergeSortInPlace(allBooks, true);
+		return allBooks;
+	}
+
+	// Every loan, sorted by title like BookLibrary::getAllIssuedBookEntries
+	std::vector<issuedBookEntry> getAllIssuedBookEntries() const {
+		std::vector<issuedBookEntry> allEntries;
+		allEntries.reserve(numLoans);
+		forEachLoan([&allEntries](const issuedBookEntry& entry) {
+			allEntries.push_back(entry);
+		});
+		mergeSortInPlace(allEntries);
+		return allEntries;
+	}
+
+	const std::vector<Student>& getLibraryStudents() const {
+		static const std::vector<Student> noStudents;
+		return students ? *students : noStudents;
+	}
+
+	int getNumBooks() const {
+		return numBooks;
+	}
+
+	int getNumLoans() const {
+		return numLoans;
+	}
+
+	long long getVersion() const {
+		return version;
+	}
+};
+
 // BookLibrary class for managing books in the hash table, such as 
 // modifying the books, book/library related error messages, issuing books, and 
 // other things that we think of 
 // Book Library class
 class BookLibrary {
 private:
-	HashTable<Book> bookMap; // Hash table containing the 
-	std::vector<issuedBookEntry> issuedBookList; // list of objects that contain an issued book and the student the book was issued to
+	// NOTE: Titles in a series share most of their letters, which the default sum of characters hash piles into a few
+	// buckets, so the library's tables use FNV-1a with power of two buckets
+	HashTable<Book, std::string, FNV1aHash, PowerOfTwoBucketCount> bookMap; // Hash table containing the 
+	std::vector<LibraryLoan> issuedBookList; // list of loans, each with the ID of the issued book and the student the book was issued to
 	std::vector<Student> libraryStudents; // list of students 'registered' into the library
+	bool verbose = true; // whether the library prints a message after each add/delete/issue/return
+	static const int listingPageSize = 20; // number of rows the prompts show at a time
+
+	/*
+	+ Secondary indexes: every book gets a small ID when it's added (IDs of deleted books are reused so they stay dense),
+	and the indexes are sets of IDs stored as compressed bitmaps. Filters like "available books with 100 to 300 pages"
+	then become bitmap ANDs instead of scanning the whole hash table.
+	*/
+	std::vector<Book*> booksByID; // book stored in bookMap for each ID; nullptr for IDs that aren't in use
+	std::vector<int> freeBookIDs; // IDs of deleted books, to hand out again
+	RoaringBitmap allBookIDs; // IDs of every book in the library
+	RoaringBitmap availableBooks; // IDs of the books that are on the shelf
+	std::map<int, RoaringBitmap> booksByPages; // IDs of the books with each number of pages, ordered by pages
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> isbnIndex; // ID of the book with each ISBN; if two books share an ISBN, the first one added
+	HashTable<std::vector<int>, std::string, FNV1aHash, PowerOfTwoBucketCount> sharedISBNs; // IDs of the other books with an ISBN that's shared, in the order they were added
+
+	/*
+	+ Due dates: every loan gets a due date from the library's clock (which tests and simulations can replace with
+	setClock), and a timing wheel keyed by loan ID keeps track of which loans have come due, so the overdue and due
+	soon reports only look at those loans instead of the whole issued list. The wheel counts in minutes, so a loan
+	shows up as overdue within a minute of its due time.
+	*/
+	std::function<long long()> clock = []() {
+		return static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+	};
+	long long loanPeriodSeconds = 14LL * 24 * 60 * 60;
+	static const long long dueTickSeconds = 60;
+	TimingWheel dueDates; // loan IDs by the tick they become overdue in
+	std::vector<int> loanPositions; // position in issuedBookList of each loan ID; -1 for IDs that aren't in use
+	std::vector<int> freeLoanIDs; // IDs of returned loans, to hand out again
+
+	// Tick a loan with the given due time becomes overdue in: the first one that starts after the due time
+	static long long overdueTick(long long dueTime) {
+		return dueTime / dueTickSeconds + 1;
+	}
+
+	// Moves the due date wheel up to the clock's current time, so loans that have come due since are marked overdue
+	void updateDueDates() {
+		dueDates.advance(clock() / dueTickSeconds, [](int) {});
+	}
+
+	// Hands out an ID for a new loan
+	int allocateLoanID() {
+		if (!freeLoanIDs.empty()) {
+			int loanID = freeLoanIDs.back();
+			freeLoanIDs.pop_back();
+			return loanID;
+		}
+		loanPositions.push_back(-1);
+		return static_cast<int>(loanPositions.size()) - 1;
+	}
+
+	// Records where each loan from position "from" onwards is in issuedBookList, after they've moved
+	void updateLoanPositions(size_t from) {
+		for (size_t i = from; i < issuedBookList.size(); i++) {
+			loanPositions[issuedBookList[i].loanID] = static_cast<int>(i);
+		}
+	}
+
+	// Sorts issuedBookList by title, keeping track of where each loan went
+	void sortIssuedBookList() {
+		std::stable_sort(issuedBookList.begin(), issuedBookList.end(), [this](const LibraryLoan& first, const LibraryLoan& second) {
+			return *booksByID[first.bookID] < *booksByID[second.bookID];
+		});
+		updateLoanPositions(0);
+	}
+
+	// A loan with a copy of its book as it is now, for handing out
+	issuedBookEntry makeIssuedEntry(const LibraryLoan& loan) {
+		issuedBookEntry entry{ *booksByID[loan.bookID], loan.issuedStudent };
+		entry.checkoutTime = loan.checkoutTime;
+		entry.dueTime = loan.dueTime;
+		entry.loanID = loan.loanID;
+		return entry;
+	}
+
+	// Stored book with a title, or failing that with an ISBN, or nullptr if there's neither
+	Book* findStoredBookByTitleOrISBN(const std::string& item) {
+		Book* storedBook = findStoredBookByTitle(item);
+		if (storedBook != nullptr) {
+			return storedBook;
+		}
+		if (useBloomFilters && !isbnFilter.mightContain(FNV1aHash::hash(item))) {
+			return nullptr;
+		}
+		int* bookID = isbnIndex.findValue(item);
+		return bookID != nullptr ? booksByID[*bookID] : nullptr;
+	}
+
+	// Finds the stored book for every item of a batch, checking that none of them is in the batch twice; returns
+	// false and fills in the result if one can't be found
+	bool findBatchBooks(const std::vector<std::string>& items, std::vector<Book*>& batchBooks, BatchResult& result) {
+		batchBooks.reserve(items.size());
+		for (size_t i = 0; i < items.size(); i++) {
+			Book* storedBook = findStoredBookByTitleOrISBN(items[i]);
+			result.failedItem = static_cast<int>(i);
+			if (storedBook == nullptr) {
+				result.reason = "'" + items[i] + "' isn't in the library";
+				return false;
+			}
+			for (size_t j = 0; j < batchBooks.size(); j++) {
+				if (batchBooks[j] == storedBook) {
+					result.reason = "'" + storedBook->title + "' is in the batch more than once";
+					return false;
+				}
+			}
+			batchBooks.push_back(storedBook);
+		}
+		result.failedItem = -1;
+		return true;
+	}
+
+	// Closes an export's file and reports how it went
+	bool finishExport(BufferedFileWriter& writer, const std::string& fileName, size_t numRows, const char* what) {
+		if (!writer.close()) {
+			std::cout << "Book Library: Could not finish writing the " << what << " to '" << fileName << "'!" << std::endl;
+			return false;
+		}
+		if (verbose) std::cout << "Book Library: Exported " << numRows << " " << what << " to '" << fileName << "' (" << writer.getBytesWritten() << " bytes)!" << std::endl;
+		return true;
+	}
+
+	// Position in issuedBookList of the entry for a book and the student it's issued to, or -1 if there isn't one. A
+	// copy of a stored book is matched by its ID, so it still finds the loan after the book has been edited; a book
+	// that was never added is matched by ISBN.
+	int findIssuedEntry(const Book& book, const Student& student) {
+		for (size_t i = 0; i < issuedBookList.size(); i++) {
+			bool sameBook = book.bookID >= 0 ? issuedBookList[i].bookID == book.bookID : *booksByID[issuedBookList[i].bookID] == book;
+			if (sameBook && issuedBookList[i].issuedStudent == student) {
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+
+	/*
+	+ Holds: students can get in line for a book that's issued. The waitlists are HoldQueues over book IDs, and each
+	student with holds gets a small holder ID, so the queues don't keep copies of students. When a book with holds is
+	returned, it's issued straight to the student at the front of its queue.
+	*/
+	HoldQueues holdQueues;
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> holderIDs; // holder ID of each student (by ID) with holds
+	std::vector<Student> holders; // student for each holder ID
+	std::vector<int> freeHolderIDs; // holder IDs of students with no holds left, to hand out again
+
+	// Holder ID of the student with the given ID, or -1 if they have no holds
+	int findHolderID(const std::string& studentID) {
+		int* holderID = holderIDs.findValue(studentID);
+		return holderID == nullptr ? -1 : *holderID;
+	}
+
+	// Holder ID for a student, handing out a new one if they don't have one yet
+	int acquireHolderID(const Student& student) {
+		int holderID = findHolderID(student.getStudentID());
+		if (holderID >= 0) {
+			return holderID;
+		}
+		if (!freeHolderIDs.empty()) {
+			holderID = freeHolderIDs.back();
+			freeHolderIDs.pop_back();
+			holders[holderID] = student;
+		} else {
+			holderID = static_cast<int>(holders.size());
+			holders.push_back(student);
+		}
+		holderIDs.insertPair(student.getStudentID(), holderID);
+		return holderID;
+	}
+
+	// Frees a holder ID once its student has no holds left
+	void releaseHolderIDIfUnused(int holderID) {
+		if (holdQueues.getNumHoldsOf(holderID) == 0) {
+			holderIDs.deletePair(holders[holderID].getStudentID());
+			freeHolderIDs.push_back(holderID);
+		}
+	}
+
+	// Counts of the most borrowed titles, most active students and authors, fed by every issue and return
+	CirculationAnalytics circulation;
+
+	/*
+	+ Frozen catalog: freezeCatalog() builds a minimal perfect hash over the titles in bookMap, pointing at the books
+	stored there, so looking up a title checks exactly one slot. It's for collections that are loaded once and then only
+	read. Writes after freezing still go to bookMap: a deleted title's slot is set to nullptr, and once a book is added
+	the frozen table no longer has every title, so titles it doesn't have are looked up in bookMap as well.
+	*/
+	PerfectHashTable<Book*> frozenTitles;
+	bool frozenHasAllTitles = false; // whether every title in bookMap is in frozenTitles
+
+	/*
+	+ Optional Bloom filters in front of the title, ISBN and student ID lookups (see enableBloomFilters), so lookups
+	for things that aren't in the library, like mistyped titles or the duplicate checks when adding, are mostly answered
+	without walking a chain or the student list. Each filter is rebuilt from the library's current keys when it degrades.
+	*/
+	bool useBloomFilters = false;
+	BloomFilter titleFilter;
+	BloomFilter isbnFilter;
+	BloomFilter studentIDFilter;
+
+	// Rebuilds each filter from scratch with room for twice as many keys as there are now
+	void rebuildTitleFilter() {
+		titleFilter.rebuild(2LL * bookMap.getNumPairs());
+		bookMap.forEachPair([this](const std::string& key, Book&) { titleFilter.add(FNV1aHash::hash(key)); });
+	}
+	void rebuildISBNFilter() {
+		isbnFilter.rebuild(2LL * isbnIndex.getNumPairs());
+		isbnIndex.forEachPair([this](const std::string& ISBN, int) { isbnFilter.add(FNV1aHash::hash(ISBN)); });
+	}
+	void rebuildStudentIDFilter() {
+		studentIDFilter.rebuild(2LL * libraryStudents.size());
+		for (size_t i = 0; i < libraryStudents.size(); i++) {
+			studentIDFilter.add(FNV1aHash::hash(libraryStudents[i].getStudentID()));
+		}
+	}
+
+	// Returns the stored book with the given (lower cased) title, or a nullptr if there isn't one. While the catalog is
+	// still loading, a title that isn't in yet is loaded on the spot.
+	Book* findStoredBook(const std::string& key) {
+		Book* storedBook = findLoadedBook(key);
+		if (storedBook == nullptr && lazyBooks && loadPendingTitle(key)) {
+			storedBook = findLoadedBook(key);
+		}
+		return storedBook;
+	}
+
+	// Same as findStoredBook, only looking at the books that have been loaded
+	Book* findLoadedBook(const std::string& key) {
+		if (useBloomFilters && !titleFilter.mightContain(FNV1aHash::hash(key))) {
+			return nullptr;
+		}
+		Book* storedBook = findStoredBookUnfiltered(key);
+		if (storedBook == nullptr && useBloomFilters) {
+			titleFilter.recordFalsePositive();
+			if (titleFilter.isDegraded()) {
+				rebuildTitleFilter();
+			}
+		}
+		return storedBook;
+	}
+
+	/*
+	+ Hot title cache: the most looked up titles, exactly as they were typed, mapped to their stored books, so looking
+	one up again skips lower casing, hashing and the chain walk. It's on unless enableTitleCache(false) is called.
+	Entries are pointers, so changes to a book (like being issued) show through; a book's entries are invalidated
+	before it's deleted.
+	*/
+	bool useTitleCache = true;
+	HotTitleCache<Book> titleCache;
+
+	// Returns the stored book with the given title (in any case), going through the hot title cache
+	Book* findStoredBookByTitle(const std::string& title) {
+		if (useTitleCache) {
+			Book* cachedBook = titleCache.find(title);
+			if (cachedBook != nullptr) {
+				return cachedBook;
+			}
+		}
+		Book* storedBook = findStoredBook(lowerCaseString(title));
+		if (storedBook != nullptr && useTitleCache) {
+			titleCache.insert(title, storedBook);
+		}
+		return storedBook;
+	}
+
+	// Same as findStoredBook, without asking the title filter first
+	Book* findStoredBookUnfiltered(const std::string& key) {
+		if (frozenTitles.isBuilt()) {
+			// Check the title of the book in the slot rather than the frozen table's copy of the key, since we're
+			// about to look at that book anyway
+			Book** frozenBook = frozenTitles.findCandidateValue(key);
+			if (frozenBook != nullptr && *frozenBook != nullptr && equalsIgnoringCase((*frozenBook)->title, key)) {
+				return *frozenBook;
+			}
+			if (frozenHasAllTitles) {
+				return nullptr;
+			}
+		}
+		return bookMap.findValue(key);
+	}
+
+	// Hands out an ID for a new book
+	int allocateBookID() {
+		if (!freeBookIDs.empty()) {
+			int bookID = freeBookIDs.back();
+			freeBookIDs.pop_back();
+			return bookID;
+		}
+		booksByID.push_back(nullptr);
+		return static_cast<int>(booksByID.size()) - 1;
+	}
+
+	// Adds a stored book to the ISBN index; returns whether no other book has its ISBN. If one does, the book waits in
+	// sharedISBNs so it can take over the ISBN if that book is deleted or given a different one.
+	bool indexISBN(const Book& book) {
+		if (isbnIndex.insertPair(book.ISBN, book.bookID)) {
+			return true;
+		}
+		std::vector<int>* waiting = sharedISBNs.findValue(book.ISBN);
+		if (waiting == nullptr) {
+			waiting = sharedISBNs.insertPairAndFind(book.ISBN, std::vector<int>());
+		}
+		waiting->push_back(book.bookID);
+		return false;
+	}
+
+	// Takes a stored book out of the ISBN index, handing its ISBN to the next book with the same one, if there is one
+	void unindexISBN(const Book& book) {
+		int* isbnEntry = isbnIndex.findValue(book.ISBN);
+		if (isbnEntry == nullptr) {
+			return;
+		}
+		std::vector<int>* waiting = sharedISBNs.findValue(book.ISBN);
+		if (*isbnEntry == book.bookID) {
+			if (waiting == nullptr) {
+				isbnIndex.deletePair(book.ISBN);
+				if (useBloomFilters) {
+					isbnFilter.recordRemoval();
+				}
+				return;
+			}
+			*isbnEntry = waiting->front();
+			waiting->erase(waiting->begin());
+		} else if (waiting != nullptr) {
+			waiting->erase(std::find(waiting->begin(), waiting->end(), book.bookID));
+		}
+		if (waiting != nullptr && waiting->empty()) {
+			sharedISBNs.deletePair(book.ISBN);
+		}
+	}
+
+	// Takes a book out of the secondary indexes and frees its ID
+	void removeFromIndexes(const Book& book) {
+		allBookIDs.remove(book.bookID);
+		availableBooks.remove(book.bookID);
+		std::map<int, RoaringBitmap>::iterator pagesEntry = booksByPages.find(book.numPages);
+		if (pagesEntry != booksByPages.end()) {
+			pagesEntry->second.remove(book.bookID);
+			if (pagesEntry->second.isEmpty()) {
+				booksByPages.erase(pagesEntry);
+			}
+		}
+		unindexISBN(book);
+		titleCache.invalidate(booksByID[book.bookID]);
+		booksByID[book.bookID] = nullptr;
+		publishBook(book.bookID);
+		freeBookIDs.push_back(book.bookID);
+	}
+#ifdef BOOKLIBRARY_METRICS
+	LibraryMetrics metrics; // operation counts and latencies
+#endif
+	std::unique_ptr<OperationTraceWriter> traceWriter; // set while a trace is being recorded
+
+	// Versioned copies of the books and loans that snapshots are taken from, kept up to date while snapshots are on
+	bool useSnapshots = false;
+	LibrarySnapshot liveView;
+
+	// Publishes the current state of a book (or that its ID is no longer in use) to the versioned view
+	void publishBook(int bookID) {
+		if (!useSnapshots) {
+			return;
+		}
+		Book* storedBook = booksByID[bookID];
+		liveView.books.set(bookID, storedBook != nullptr ? std::make_shared<const Book>(*storedBook) : nullptr);
+		liveView.version += 1;
+	}
+
+	// Publishes the current state of a loan (or that it's over) to the versioned view
+	void publishLoan(int loanID) {
+		if (!useSnapshots) {
+			return;
+		}
+		int position = loanPositions[loanID];
+		liveView.loans.set(loanID, position >= 0 ? std::make_shared<const LibraryLoan>(issuedBookList[position]) : nullptr);
+		liveView.version += 1;
+	}
+
+	/*
+	+ Serve-while-loading: with startLoadingBooks, bookData.txt is only indexed up front (see LazyCatalog.h), and its
+	books come in as they're needed. A lookup by title or ISBN that misses loads just the record it wants; listings and
+	anything else that looks at every book finish the load first (finishLoadingBooks); and continueLoadingBooks fills in
+	the rest whenever the caller has time. Students don't come from the catalog file, so nothing about them waits.
+	*/
+	std::unique_ptr<LazyBookCatalog> lazyBooks; // set while books are still coming in from the catalog
+	bool addingCatalogBook = false; // so adding a book from the catalog doesn't go looking in the catalog
+
+	// Adds a book handed out by the catalog, the way loadBookData would have: quietly, and not as its own traced
+	// operation (a replay loads the same file itself)
+	void addCatalogBook(Book& book) {
+		bool wasVerbose = verbose;
+		std::unique_ptr<OperationTraceWriter> writer = std::move(traceWriter);
+		verbose = false;
+		addingCatalogBook = true;
+		addBook(std::move(book.title), std::move(book.author), std::move(book.ISBN), book.numPages);
+		addingCatalogBook = false;
+		verbose = wasVerbose;
+		traceWriter = std::move(writer);
+	}
+
+	// Drops the catalog once everything in it has been added
+	void checkCatalogDone() {
+		if (lazyBooks && lazyBooks->isDone()) {
+			lazyBooks.reset();
+		}
+	}
+
+	// Loads the first pending record with a (lower cased) title, as a full load would have; the later records with the
+	// title are dropped, since a full load would turn them away as duplicates. Returns whether there was one.
+	bool loadPendingTitle(const std::string& key) {
+		bool loaded = false;
+		lazyBooks->forEachPendingMatch(LazyBookCatalog::TITLE_FIELD, key, [this, &loaded](size_t record, Book& book) {
+			lazyBooks->markHandedOut(record);
+			if (!loaded) {
+				addCatalogBook(book);
+				loaded = true;
+			}
+			return true;
+		});
+		return loaded;
+	}
+
+	// Drops the pending records with a (lower cased) title, once the book with that title has been deleted; a full load
+	// would already have turned them away
+	void dropPendingTitle(const std::string& key) {
+		lazyBooks->forEachPendingMatch(LazyBookCatalog::TITLE_FIELD, key, [this](size_t record, Book&) {
+			lazyBooks->markHandedOut(record);
+			return true;
+		});
+	}
+
+	// Loads the book a full load would have put under an ISBN, if it's still pending. Returns whether it loaded one.
+	bool loadPendingISBN(const std::string& ISBN) {
+		bool loaded = false;
+		lazyBooks->forEachPendingMatch(LazyBookCatalog::ISBN_FIELD, ISBN, [this, &loaded, &ISBN](size_t record, Book& book) {
+			if (!lazyBooks->isPending(record)) {
+				return true;
+			}
+			// The record only counts if its title gets in: an earlier record with the same title wins
+			std::string key = lowerCaseString(book.title);
+			if (findLoadedBook(key) != nullptr) {
+				lazyBooks->markHandedOut(record);
+				return true;
+			}
+			loadPendingTitle(key);
+			loaded = isbnIndex.findValue(ISBN) != nullptr;
+			return !loaded;
+		});
+		return loaded;
+	}
+
+	// Fingerprint of each stored book by book ID (0 for IDs that aren't in use), for syncBooks, worked out in chunks on
+	// the background scheduler. The books are only read, and nothing changes them until the jobs are done.
+	std::vector<uint64_t> fingerprintBooks() {
+		static const size_t booksPerJob = 16384;
+		std::vector<uint64_t> fingerprints(booksByID.size(), 0);
+		std::vector<TaskHandle<void>> jobs;
+		Book* const* books = booksByID.data();
+		uint64_t* output = fingerprints.data();
+		for (size_t first = 0; first < booksByID.size(); first += booksPerJob) {
+			size_t last = std::min(booksByID.size(), first + booksPerJob);
+			jobs.push_back(runInBackground(backgroundScheduler, [books, output, first, last]() {
+				for (size_t i = first; i < last; i++) {
+					if (books[i] != nullptr) {
+						output[i] = bookFingerprint(*books[i]);
+					}
+				}
+			}));
+		}
+		for (size_t i = 0; i < jobs.size(); i++) {
+			jobs[i].wait();
+		}
+		return fingerprints;
+	}
+
+	/*
+	+ Editing a book in place (editBook, and syncBooks for a changed record): the book stays where it's stored, with the
+	same ID, so its holds, its loan (which refers to it by ID) and the hot title cache's pointers to it stay good. A new
+	title relinks its node under the new key in the title table instead of copying the book, and the other indexes are
+	moved from the old details to the new ones.
+	*/
+
+	// Why a stored book can't be given newDetails, or an empty string if it can
+	std::string checkBookEdit(const Book& storedBook, const Book& newDetails) {
+		std::string newKey = lowerCaseString(newDetails.title);
+		if (!equalsIgnoringCase(storedBook.title, newKey) && findStoredBook(newKey) != nullptr) {
+			return "'" + newDetails.title + "' is already another book's title";
+		}
+		return "";
+	}
+
+	// Moves a stored book from the key it's stored under to a new key that no other book has, in the title table and
+	// everything that looks books up by title. Returns false (changing nothing) if the new key is taken.
+	bool rekeyStoredBook(Book* storedBook, const std::string& storedKey, const std::string& newKey) {
+		if (bookMap.rekeyPair(storedKey, newKey) == nullptr) {
+			return false;
+		}
+		titleCache.invalidate(storedBook);
+		Book** frozenBook = frozenTitles.findValue(storedKey);
+		if (frozenBook != nullptr) {
+			*frozenBook = nullptr;
+		}
+		frozenHasAllTitles = false;
+		if (useBloomFilters) {
+			titleFilter.recordRemoval();
+			titleFilter.add(FNV1aHash::hash(newKey));
+			if (titleFilter.isDegraded()) {
+				rebuildTitleFilter();
+			}
+		}
+		return true;
+	}
+
+	// Gives a stored book the title, author, ISBN and pages of newDetails (which checkBookEdit has allowed), keeping
+	// every index up to date. storedKey is the key the book is stored under, normally its lower cased title.
+	void updateStoredBook(Book* storedBook, Book& newDetails, const std::string& storedKey) {
+		std::string newKey = lowerCaseString(newDetails.title);
+		if (newKey != storedKey) {
+			rekeyStoredBook(storedBook, storedKey, newKey);
+		}
+		storedBook->title = std::move(newDetails.title);
+		storedBook->author = std::move(newDetails.author);
+		if (newDetails.ISBN != storedBook->ISBN) {
+			unindexISBN(*storedBook);
+			storedBook->ISBN = std::move(newDetails.ISBN);
+			if (indexISBN(*storedBook) && useBloomFilters) {
+				isbnFilter.add(FNV1aHash::hash(storedBook->ISBN));
+			}
+			if (useBloomFilters && isbnFilter.isDegraded()) {
+				rebuildISBNFilter();
+			}
+		}
+		if (newDetails.numPages != storedBook->numPages) {
+			std::map<int, RoaringBitmap>::iterator pagesEntry = booksByPages.find(storedBook->numPages);
+			pagesEntry->second.remove(storedBook->bookID);
+			if (pagesEntry->second.isEmpty()) {
+				booksByPages.erase(pagesEntry);
+			}
+			storedBook->numPages = newDetails.numPages;
+			booksByPages[storedBook->numPages].add(storedBook->bookID);
+		}
+		publishBook(storedBook->bookID);
+	}
+
+	/*
+	+ Applies a sync's changed records (record number and book ID of each) to their books. A record that renames its
+	book is checked against the titles the books will have once every record is applied, not the ones they have now,
+	so renames along a chain (B to Z, then A to B) or around a cycle (a swap) work in any order in the file. A new title
+	can only be taken if the book that has it is giving it up, and if two records want the same one, the first wins;
+	each rejection can take back a title that another rename was counting on, so the checks go round until nothing
+	more is rejected.
+
+	+ Renames are then made in an order that frees each title before it's taken: a rename waits for the one giving up
+	its new title, and in a cycle one book is parked under a temporary key to break it.
+	*/
+	void applySyncUpdates(SyncSourceFile& source, const std::vector<std::pair<size_t, int>>& updates, SyncReport& report) {
+		std::vector<Book> records(updates.size());
+		std::vector<std::string> newKeys(updates.size());
+		std::vector<std::string> storedKeys(updates.size());
+		std::vector<std::string> reasons(updates.size());
+		std::vector<int> renameOfBook(booksByID.size(), -1); // update that renames each book, while it's accepted
+		std::vector<size_t> renames;
+		for (size_t i = 0; i < updates.size(); i++) {
+			records[i] = source.getBook(updates[i].first);
+			newKeys[i] = lowerCaseString(records[i].title);
+			storedKeys[i] = lowerCaseString(booksByID[updates[i].second]->title);
+			if (newKeys[i] != storedKeys[i]) {
+				renameOfBook[updates[i].second] = static_cast<int>(i);
+				renames.push_back(i);
+			}
+		}
+		bool rejectedAny = true;
+		while (rejectedAny) {
+			rejectedAny = false;
+			HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> claims;
+			for (size_t i = 0; i < renames.size(); i++) {
+				size_t update = renames[i];
+				if (!reasons[update].empty()) {
+					continue;
+				}
+				Book* holder = findLoadedBook(newKeys[update]);
+				if (holder != nullptr && renameOfBook[holder->bookID] < 0) {
+					reasons[update] = "'" + records[update].title + "' is already another book's title";
+				} else if (!claims.insertPair(newKeys[update], static_cast<int>(update))) {
+					reasons[update] = "'" + records[update].title + "' is another record's new title";
+				} else {
+					continue;
+				}
+				renameOfBook[updates[update].second] = -1;
+				rejectedAny = true;
+			}
+		}
+		// 0 is waiting, 1 is waiting for the book that has its new title, 2 is applied
+		std::vector<char> states(updates.size(), 0);
+		std::vector<size_t> waiting;
+		for (size_t i = 0; i < updates.size(); i++) {
+			if (states[i] != 0 || !reasons[i].empty()) {
+				continue;
+			}
+			states[i] = 1;
+			waiting.push_back(i);
+			while (!waiting.empty()) {
+				size_t update = waiting.back();
+				Book* storedBook = booksByID[updates[update].second];
+				if (newKeys[update] != storedKeys[update]) {
+					Book* holder = findLoadedBook(newKeys[update]);
+					int holderUpdate = holder != nullptr ? renameOfBook[holder->bookID] : -1;
+					if (holderUpdate >= 0 && states[holderUpdate] == 0) {
+						states[holderUpdate] = 1;
+						waiting.push_back(static_cast<size_t>(holderUpdate));
+						continue;
+					}
+					if (holderUpdate >= 0 && states[holderUpdate] == 1) {
+						// The renames go round in a cycle; the book this one is waiting on gets out of the way
+						parkStoredBook(holder, storedKeys[holderUpdate]);
+					}
+				}
+				updateStoredBook(storedBook, records[update], storedKeys[update]);
+				report.record(CHANGE_UPDATED, *storedBook);
+				states[update] = 2;
+				waiting.pop_back();
+			}
+		}
+		for (size_t i = 0; i < updates.size(); i++) {
+			if (!reasons[i].empty()) {
+				report.record(CHANGE_REJECTED, records[i], reasons[i]);
+			}
+		}
+	}
+
+	// Moves a stored book to a temporary key that no title can clash with, updating storedKey to it
+	void parkStoredBook(Book* storedBook, std::string& storedKey) {
+		std::string parkingKey = std::string(1, '\0') + "sync " + std::to_string(storedBook->bookID);
+		while (!rekeyStoredBook(storedBook, storedKey, parkingKey)) {
+			parkingKey += '\0';
+		}
+		storedKey = parkingKey;
+	}
+
+	// Where background jobs run; nullptr runs them on the calling thread
+	TaskScheduler* backgroundScheduler = nullptr;
+
+	// Writes one part of a snapshot to a file, the same way the exports below write the live library; the loans come
+	// out in loan ID order. Says nothing, since it runs on a background worker; the job's result says how it went.
+	static bool writeSnapshotExport(const LibrarySnapshot& snapshot, ExportContents contents, const std::string& fileName, ExportFormat format) {
+		BufferedFileWriter writer;
+		if (!writer.open(fileName)) {
+			return false;
+		}
+		if (contents == EXPORT_BOOKS) {
+			snapshot.forEachBook([&writer, format](const Book& book) {
+				writeBookRow(writer, book, format);
+			});
+		} else if (contents == EXPORT_STUDENTS) {
+			const std::vector<Student>& students = snapshot.getLibraryStudents();
+			for (size_t i = 0; i < students.size(); i++) {
+				writeStudentRow(writer, students[i], format);
+			}
+		} else {
+			writeLoanExportHeader(writer, format);
+			snapshot.forEachLoan([&writer, format](const issuedBookEntry& entry) {
+				writeLoanRow(writer, entry.issuedBook, entry.issuedStudent, entry.checkoutTime, entry.dueTime, format);
+			});
+		}
+		return writer.close();
+	}
+
+	// Marks the versioned view's student list as out of date; the next snapshot copies the list again
+	void publishStudents() {
+		if (useSnapshots) {
+			liveView.students.reset();
+			liveView.version += 1;
+		}
+	}
 public:
 	BookLibrary() {}
 	~BookLibrary() {}
 
+	// Turns the library's status messages on or off; benchmarks and bulk loads turn them off
+	// so that we measure the operation itself rather than the time spent printing to the console
+	void setVerbose(bool _verbose) {
+		verbose = _verbose;
+	}
+
 	// Function will clear the book library and reset it back to a blank state 
 	void destroyBookLibrary() {
+		lazyBooks.reset();
 		// First clear the bookMap hash table
 		bookMap.destroyHashTable();
+		// Then the secondary indexes, which only refer to books in the hash table
+		booksByID.clear();
+		freeBookIDs.clear();
+		allBookIDs.clear();
+		availableBooks.clear();
+		booksByPages.clear();
+		isbnIndex.destroyHashTable();
+		sharedISBNs.destroyHashTable();
+		frozenTitles.clear();
+		frozenHasAllTitles = false;
+		titleCache.clear();
 		// Now clear the list for the issued books and library students
 		issuedBookList.clear();
+		dueDates.clear();
+		loanPositions.clear();
+		freeLoanIDs.clear();
+		holdQueues.clear();
+		liveView = LibrarySnapshot();
+		circulation.clear();
+		holderIDs.destroyHashTable();
+		holders.clear();
+		freeHolderIDs.clear();
 		libraryStudents.clear();
+		if (useBloomFilters) {
+			rebuildTitleFilter();
+			rebuildISBNFilter();
+			rebuildStudentIDFilter();
+		}
 	}
 
 	// Given the attributes of a book object 
+	// NOTE: The strings are taken by value and moved into the new book, so callers passing temporaries (like the
+	// fields from splitLine) don't pay for a copy
 	void addBook(std::string title, std::string author, std::string ISBN, int numPages) {
-		Book newBook = {title, author, ISBN, numPages};
+		LIBRARY_TIME_OPERATION(metrics, OP_ADD_BOOK);
+		TracedOperation traced(traceWriter.get(), TRACE_ADD_BOOK, clock, title, author, ISBN, static_cast<long long>(numPages));
 		// When adding a book, we lower case the title. This is to make it more forgiving for input validation
 		// as when the user types in a title, we will lower case their input as well, so that the corresponding book
 		// will show up regardless whether or not they 
-		bool result = bookMap.insertPair(lowerCaseString(newBook.title), newBook);
-		if (result) {
-			std::cout << "Book Library: Successfully added '" << newBook.title << "' to the library!" << std::endl;
+		std::string key = lowerCaseString(title);
+		// A title that's still waiting in the catalog was there first
+		if (lazyBooks && !addingCatalogBook) {
+			loadPendingTitle(key);
+		}
+		Book newBook = {std::move(title), std::move(author), std::move(ISBN), numPages};
+		newBook.bookID = allocateBookID();
+		// If the title filter says the title isn't in the library, it definitely isn't, so the duplicate check
+		// can be skipped (which is most of the time during a bulk load)
+		uint64_t titleHash = 0;
+		bool knownNewTitle = false;
+		if (useBloomFilters) {
+			titleHash = FNV1aHash::hash(key);
+			knownNewTitle = !titleFilter.mightContain(titleHash);
+		}
+		Book* storedBook;
+		if (knownNewTitle) {
+			storedBook = bookMap.insertNewPair(key, std::move(newBook));
 		} else {
-			std::cout << "Book Library: Could not add '" << newBook.title << "' since it is a duplicate title!" << std::endl;
+			storedBook = bookMap.insertPairAndFind(key, std::move(newBook));
+			if (storedBook != nullptr && useBloomFilters) {
+				titleFilter.recordFalsePositive();
+			}
+		}
+		if (storedBook == nullptr) {
+			freeBookIDs.push_back(newBook.bookID);
+			if (verbose) std::cout << "Book Library: Could not add '" << newBook.title << "' since it is a duplicate title!" << std::endl;
+			return;
 		}
+		// Point the ID at the copy stored in the table, and add it to the secondary indexes
+		booksByID[storedBook->bookID] = storedBook;
+		publishBook(storedBook->bookID);
+		allBookIDs.add(storedBook->bookID);
+		availableBooks.add(storedBook->bookID);
+		booksByPages[storedBook->numPages].add(storedBook->bookID);
+		bool newISBN = indexISBN(*storedBook);
+		frozenHasAllTitles = false;
+		if (useBloomFilters) {
+			titleFilter.add(titleHash);
+			if (newISBN) {
+				isbnFilter.add(FNV1aHash::hash(storedBook->ISBN));
+			}
+			if (titleFilter.isDegraded()) {
+				rebuildTitleFilter();
+			}
+			if (isbnFilter.isDegraded()) {
+				rebuildISBNFilter();
+			}
+		}
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Successfully added '" << storedBook->title << "' to the library!" << std::endl;
 	}
 
 	// Function which allows us to delete a book given the book's info
-	void deleteBook(std::string title) {
-		// Get the book based on its title
-		Book targetBook = getBook(title);
+	void deleteBook(const std::string& title) {
+		LIBRARY_TIME_OPERATION(metrics, OP_DELETE_BOOK);
+		TracedOperation traced(traceWriter.get(), TRACE_DELETE_BOOK, clock, title);
+		// Get the book based on its title; we look at the stored book rather than a copy
+		std::string key = lowerCaseString(title);
+		Book* storedBook = findStoredBook(key);
 		// Check if the book title they entered was valid and returned an actual book
-		if (targetBook.ISBN == "") {
-			std::cout << "Book Library: Could not remove '" << title << "' since it wasn't found in the library!" << std::endl;
+		if (storedBook == nullptr) {
+			if (verbose) std::cout << "Book Library: Could not remove '" << title << "' since it wasn't found in the library!" << std::endl;
 			return;
 		}
 		// Check if the book has been checked out, if it has been checked out, then we also can't delete it
-		if (targetBook.isAvailable == false) {
-			std::cout << "Book Library: This book is currently issued/checked out, so it can't be deleted from the library!" << std::endl;
+		if (storedBook->isAvailable == false) {
+			if (verbose) std::cout << "Book Library: This book is currently issued/checked out, so it can't be deleted from the library!" << std::endl;
 			return;
 		}
 		// At this point, the book they entered exists, and it's available to be deleted, so call the function to delete it from the hash table
 		// lowercase the title so it can be matched with the lowercased keys on the hash table.
-		bookMap.deletePair(lowerCaseString(title));
-		std::cout << "Book Library: Successfully removed '" << title << "' from library!" << std::endl;
+		while (holdQueues.frontHold(storedBook->bookID) >= 0) {
+			int hold = holdQueues.frontHold(storedBook->bookID);
+			int holderID = holdQueues.getHolder(hold);
+			holdQueues.removeHold(hold);
+			releaseHolderIDIfUnused(holderID);
+		}
+		removeFromIndexes(*storedBook);
+		Book** frozenBook = frozenTitles.findValue(key);
+		if (frozenBook != nullptr) {
+			*frozenBook = nullptr;
+		}
+		bookMap.deletePair(key);
+		if (lazyBooks) {
+			dropPendingTitle(key);
+		}
+		if (useBloomFilters) {
+			titleFilter.recordRemoval();
+			if (titleFilter.isDegraded()) {
+				rebuildTitleFilter();
+			}
+			if (isbnFilter.isDegraded()) {
+				rebuildISBNFilter();
+			}
+		}
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Successfully removed '" << title << "' from library!" << std::endl;
+	}
+
+	// Gives the book with a title a new title, author, ISBN and number of pages, in place (see updateStoredBook), so
+	// an issued book stays issued and its holds stay with it. Returns whether the book was changed; it isn't if it
+	// wasn't found or the new title is another book's.
+	// NOTE: The circulation counts keep the book's old title and author, since they're sketches that can't move a
+	// count from one key to another
+	bool editBook(const std::string& title, std::string newTitle, std::string newAuthor, std::string newISBN, int newNumPages) {
+		LIBRARY_TIME_OPERATION(metrics, OP_EDIT_BOOK);
+		TracedOperation traced(traceWriter.get(), TRACE_EDIT_BOOK, clock, title, newTitle, newAuthor, newISBN, static_cast<long long>(newNumPages));
+		Book* storedBook = findStoredBookByTitle(title);
+		if (storedBook == nullptr) {
+			if (verbose) std::cout << "Book Library: Could not edit '" << title << "' since it wasn't found in the library!" << std::endl;
+			return false;
+		}
+		Book newDetails = {std::move(newTitle), std::move(newAuthor), std::move(newISBN), newNumPages};
+		// A book still waiting in the catalog with the new ISBN would have had it first
+		if (lazyBooks && isbnIndex.findValue(newDetails.ISBN) == nullptr) {
+			loadPendingISBN(newDetails.ISBN);
+		}
+		std::string reason = checkBookEdit(*storedBook, newDetails);
+		if (!reason.empty()) {
+			if (verbose) std::cout << "Book Library: Could not edit '" << storedBook->title << "' since " << reason << "!" << std::endl;
+			return false;
+		}
+		// Records with the old title were turned away by the book we're renaming, and a full load wouldn't bring them back
+		if (lazyBooks && !equalsIgnoringCase(storedBook->title, lowerCaseString(newDetails.title))) {
+			dropPendingTitle(lowerCaseString(storedBook->title));
+		}
+		updateStoredBook(storedBook, newDetails, lowerCaseString(storedBook->title));
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Successfully edited '" << title << "', which is now " << *storedBook << "!" << std::endl;
+		return true;
+	}
+
+	// Returns a book based on its title; if book wasn't found we return a default book object
+	// Then after we should be able to follow up with either editing, checking out, etc.
+	Book getBook(const std::string& title) {
+		LIBRARY_TIME_OPERATION(metrics, OP_GET_BOOK);
+		TracedOperation traced(traceWriter.get(), TRACE_GET_BOOK, clock, title);
+		// Lowercasing the key, our title, since we are accessing and messing with the hash table (unless it's a hot title)
+		Book* storedBook = findStoredBookByTitle(title);
+		if (storedBook == nullptr) {
+			return Book();
+		}
+		traced.succeeded();
+		return *storedBook;
+	}
+
+	// Returns the book with the given ISBN; if there isn't one we return a default book object, like getBook
+	Book getBookByISBN(const std::string& ISBN) {
+		TracedOperation traced(traceWriter.get(), TRACE_GET_BOOK_BY_ISBN, clock, ISBN);
+		if (lazyBooks && isbnIndex.findValue(ISBN) == nullptr) {
+			loadPendingISBN(ISBN);
+		}
+		if (useBloomFilters && !isbnFilter.mightContain(FNV1aHash::hash(ISBN))) {
+			return Book();
+		}
+		int* bookID = isbnIndex.findValue(ISBN);
+		if (bookID == nullptr) {
+			if (useBloomFilters) {
+				isbnFilter.recordFalsePositive();
+				if (isbnFilter.isDegraded()) {
+					rebuildISBNFilter();
+				}
+			}
+			return Book();
+		}
+		traced.succeeded();
+		return *booksByID[*bookID];
+	}
+
+	// Returns every book by an author, ignoring case, in no particular order. There's no index on authors,
+	// so this looks at every book, but it only copies the ones that match.
+	std::vector<Book> findBooksByAuthor(const std::string& author) {
+		finishLoadingBooks();
+		std::vector<Book> matches;
+		std::string targetAuthor = lowerCaseString(author);
+		bookMap.forEachValue([&matches, &targetAuthor](Book& book) {
+			if (book.author.length() == targetAuthor.length() && lowerCaseString(book.author) == targetAuthor) {
+				matches.push_back(book);
+			}
+		});
+		return matches;
+	}
+
+	// Builds the frozen title index over every book currently in the library, using up to numThreads threads
+	// (0 means one per core). Returns the bits per title that the perfect hash function takes.
+	double freezeCatalog(int numThreads = 0) {
+		finishLoadingBooks();
+		if (numThreads <= 0) {
+			numThreads = static_cast<int>(std::thread::hardware_concurrency());
+		}
+		std::vector<std::string> keys;
+		std::vector<Book*> books;
+		keys.reserve(bookMap.getNumPairs());
+		books.reserve(bookMap.getNumPairs());
+		bookMap.forEachPair([&keys, &books](const std::string& key, Book& book) {
+			keys.push_back(key);
+			books.push_back(&book);
+		});
+		frozenTitles.build(keys, books, numThreads);
+		frozenHasAllTitles = true;
+		if (verbose) std::cout << "Book Library: Froze the catalog of " << keys.size() << " titles (" << frozenTitles.getBitsPerKey() << " bits per title)!" << std::endl;
+		return frozenTitles.getBitsPerKey();
+	}
+
+	// Writes every book to a catalog image that read-only processes can memory map (see CatalogImage.h), swapping it in
+	// over any image already at fileName. Returns whether it worked.
+	bool exportCatalogImage(const std::string& fileName) {
+		finishLoadingBooks();
+		std::vector<Book> books;
+		books.reserve(bookMap.getNumPairs());
+		bookMap.forEachValue([&books](Book& book) {
+			books.push_back(book);
+		});
+		if (!writeCatalogImage(books, fileName)) {
+			std::cout << "Book Library: Could not write the catalog image '" << fileName << "'!" << std::endl;
+			return false;
+		}
+		if (verbose) std::cout << "Book Library: Published a catalog image of " << books.size() << " books to '" << fileName << "'!" << std::endl;
+		return true;
+	}
+
+	// Starts serving books from a data file (in loadBookData's format) before it's loaded: indexes the file, and hands
+	// parsing to the background scheduler. Returns false if the file can't be read.
+	bool startLoadingBooks(const std::string& fileName, char delimiter) {
+		finishLoadingBooks();
+		lazyBooks.reset(new LazyBookCatalog());
+		if (!lazyBooks->open(fileName, delimiter, backgroundScheduler)) {
+			lazyBooks.reset();
+			std::cout << "Book Library: Could not open '" << fileName << "' to load the books!" << std::endl;
+			return false;
+		}
+		checkCatalogDone();
+		return true;
+	}
+
+	// Adds books from the catalog for up to the given time; returns whether there are still some to come
+	bool continueLoadingBooks(std::chrono::steady_clock::duration budget) {
+		if (!lazyBooks) {
+			return false;
+		}
+		auto deadline = std::chrono::steady_clock::now() + budget;
+		Book book;
+		for (int added = 1; lazyBooks->nextBook(book); added++) {
+			addCatalogBook(book);
+			// Checking the clock costs about as much as adding a book, so only every so often
+			if (added % 64 == 0 && std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+		}
+		checkCatalogDone();
+		return lazyBooks != nullptr;
+	}
+
+	// Adds the rest of the catalog's books, if it's still loading
+	void finishLoadingBooks() {
+		if (!lazyBooks) {
+			return;
+		}
+		Book book;
+		while (lazyBooks->nextBook(book)) {
+			addCatalogBook(book);
+		}
+		lazyBooks.reset();
+	}
+
+	bool isLoadingBooks() {
+		return lazyBooks != nullptr;
+	}
+
+	/*
+	+ Brings the books in line with a fresh book data file (in loadBookData's format) without reloading them, matching
+	records to books by ISBN (see CatalogSync.h). Only what changed is applied: books whose ISBNs are gone from the
+	file are removed first, then changed records are applied to their books in place (see applySyncUpdates), then new
+	ISBNs are added, so a title given up by one book, removed or renamed, can be taken by another. Loans, holds and book IDs are untouched, and a book that's gone
+	from the file but issued stays until a later sync finds it returned. Returns a report of every change.
+
+	+ NOTE: The first record with an ISBN is the one that counts, and later ones are rejected. A book that shares its
+	ISBN with the one the ISBN index points at is left alone while that one is in the file. Like loading the catalog,
+	a sync isn't recorded in a trace.
+	*/
+	SyncReport syncBooks(const std::string& fileName, char delimiter) {
+		finishLoadingBooks();
+		SyncReport report;
+		SyncSourceFile source;
+		if (!source.read(fileName, delimiter, backgroundScheduler)) {
+			std::cout << "Book Library: Could not open '" << fileName << "' to sync the books!" << std::endl;
+			return report;
+		}
+		std::vector<uint64_t> fingerprints = fingerprintBooks();
+		report.applied = true;
+		report.numRecords = static_cast<int>(source.getNumRecords());
+		// Match the records to the books by ISBN
+		std::vector<bool> inFile(booksByID.size(), false);
+		std::vector<std::pair<size_t, int>> updates; // record number and book ID of each changed record
+		std::vector<size_t> additions; // record numbers of the new ISBNs
+		HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> newISBNs;
+		for (size_t i = 0; i < source.getNumRecords(); i++) {
+			if (!source.isBook(i)) {
+				report.record(CHANGE_REJECTED, Book(), "record " + std::to_string(i + 1) + " isn't a book");
+				continue;
+			}
+			int* bookID = isbnIndex.findValue(source.getISBN(i));
+			if (bookID != nullptr ? inFile[*bookID] : !newISBNs.insertPair(source.getISBN(i), 0)) {
+				report.record(CHANGE_REJECTED, source.getBook(i), "its ISBN is in the file more than once");
+			} else if (bookID == nullptr) {
+				additions.push_back(i);
+			} else {
+				inFile[*bookID] = true;
+				if (fingerprints[*bookID] == source.getFingerprint(i)) {
+					report.numUnchanged += 1;
+				} else {
+					updates.push_back(std::make_pair(i, *bookID));
+				}
+			}
+		}
+		std::vector<int> removals;
+		for (size_t bookID = 0; bookID < inFile.size(); bookID++) {
+			Book* storedBook = booksByID[bookID];
+			if (storedBook == nullptr || inFile[bookID]) {
+				continue;
+			}
+			int* isbnOwner = isbnIndex.findValue(storedBook->ISBN);
+			if (isbnOwner == nullptr || !inFile[*isbnOwner]) {
+				removals.push_back(static_cast<int>(bookID));
+			}
+		}
+		// The changes go through the usual add and delete, without a message or trace record for each one
+		bool wasVerbose = verbose;
+		std::unique_ptr<OperationTraceWriter> writer = std::move(traceWriter);
+		verbose = false;
+		for (size_t i = 0; i < removals.size(); i++) {
+			Book* storedBook = booksByID[removals[i]];
+			if (!storedBook->isAvailable) {
+				report.record(CHANGE_KEPT_ON_LOAN, *storedBook);
+				continue;
+			}
+			report.record(CHANGE_REMOVED, *storedBook);
+			std::string title = storedBook->title;
+			deleteBook(title);
+		}
+		applySyncUpdates(source, updates, report);
+		for (size_t i = 0; i < additions.size(); i++) {
+			Book record = source.getBook(additions[i]);
+			if (findLoadedBook(lowerCaseString(record.title)) != nullptr) {
+				report.record(CHANGE_REJECTED, record, "'" + record.title + "' is already another book's title");
+				continue;
+			}
+			report.record(CHANGE_ADDED, record);
+			addBook(std::move(record.title), std::move(record.author), std::move(record.ISBN), record.numPages);
+		}
+		verbose = wasVerbose;
+		traceWriter = std::move(writer);
+		if (verbose) std::cout << "Book Library: Synced the books with '" << fileName << "': " << report.numAdded << " added, " << report.numUpdated << " updated, "
+			<< report.numRemoved << " removed, " << report.numUnchanged << " unchanged (" << report.numKeptOnLoan << " kept since they're issued, "
+			<< report.numRejected << " rejected)!" << std::endl;
+		return report;
+	}
+
+	/*
+	+ Background jobs. Each takes a snapshot of the library on the calling thread (O(1), see takeSnapshot) and hands
+	the slow part to the background scheduler, so the caller only pays for the hand-off and the library can keep
+	changing while the job runs. The handle gives the job's result and how long it waited and ran, and can cancel it
+	before it starts. With no scheduler set, the job runs before the call returns.
+
+	+ NOTE: Keeping the hash tables or the Bloom filters up to date can't be handed off like this, since the desk reads
+	and changes them on every operation and BookLibrary has no locks; those still happen inline.
+	*/
+
+	// Hands background jobs to a scheduler, which can be shared by several libraries (nullptr runs them inline). The
+	// scheduler has to outlive the library's jobs.
+	void setBackgroundScheduler(TaskScheduler* scheduler) {
+		backgroundScheduler = scheduler;
+	}
+
+	TaskScheduler* getBackgroundScheduler() {
+		return backgroundScheduler;
+	}
+
+	// Exports the books, students or loans as they are now to a file, as a background job; the job's result is whether
+	// the file was written
+	TaskHandle<bool> exportInBackground(ExportContents contents, const std::string& fileName, ExportFormat format = EXPORT_CSV, TaskPriority priority = PRIORITY_LOW) {
+		LibrarySnapshot snapshot = takeSnapshot();
+		return runInBackground(backgroundScheduler, [snapshot, contents, fileName, format]() {
+			return writeSnapshotExport(snapshot, contents, fileName, format);
+		}, priority);
+	}
+
+	// Publishes a catalog image of the books as they are now (see exportCatalogImage), as a background job
+	TaskHandle<bool> exportCatalogImageInBackground(const std::string& fileName, TaskPriority priority = PRIORITY_LOW) {
+		LibrarySnapshot snapshot = takeSnapshot();
+		return runInBackground(backgroundScheduler, [snapshot, fileName]() {
+			std::vector<Book> books;
+			books.reserve(snapshot.getNumBooks());
+			snapshot.forEachBook([&books](const Book& book) {
+				books.push_back(book);
+			});
+			return writeCatalogImage(books, fileName);
+		}, priority);
+	}
+
+	// Sorts every book by title, as a background job (the same list getAllBooks returns)
+	TaskHandle<std::vector<Book>> sortBooksInBackground(TaskPriority priority = PRIORITY_NORMAL) {
+		LibrarySnapshot snapshot = takeSnapshot();
+		return runInBackground(backgroundScheduler, [snapshot]() {
+			return snapshot.getAllBooks();
+		}, priority);
+	}
+
+	// Sorts every loan by title, as a background job (the same list getAllIssuedBookEntries returns)
+	TaskHandle<std::vector<issuedBookEntry>> sortLoansInBackground(TaskPriority priority = PRIORITY_NORMAL) {
+		LibrarySnapshot snapshot = takeSnapshot();
+		return runInBackground(backgroundScheduler, [snapshot]() {
+			return snapshot.getAllIssuedBookEntries();
+		}, priority);
+	}
+
+	// Writes every book to a file, as CSV (which loadBookData can read back in) or JSON Lines, in book ID order. The
+	// rows are written straight from the stored books through the export writer's buffers.
+	// NOTE: The books are walked through booksByID rather than the table's buckets, since IDs follow the order the books
+	// were added (and so roughly where they were allocated) while the buckets jump all over memory
+	bool exportBooks(const std::string& fileName, ExportFormat format = EXPORT_CSV) {
+		finishLoadingBooks();
+		BufferedFileWriter writer;
+		if (!writer.open(fileName)) {
+			std::cout << "Book Library: Could not open '" << fileName << "' to export the books!" << std::endl;
+			return false;
+		}
+		for (size_t i = 0; i < booksByID.size(); i++) {
+			if (booksByID[i] != nullptr) {
+				writeBookRow(writer, *booksByID[i], format);
+			}
+		}
+		return finishExport(writer, fileName, bookMap.getNumPairs(), "books");
+	}
+
+	// Writes every student to a file, as CSV (which loadStudentData can read back in) or JSON Lines, in name order
+	bool exportStudents(const std::string& fileName, ExportFormat format = EXPORT_CSV) {
+		BufferedFileWriter writer;
+		if (!writer.open(fileName)) {
+			std::cout << "Book Library: Could not open '" << fileName << "' to export the students!" << std::endl;
+			return false;
+		}
+		for (size_t i = 0; i < libraryStudents.size(); i++) {
+			writeStudentRow(writer, libraryStudents[i], format);
+		}
+		return finishExport(writer, fileName, libraryStudents.size(), "students");
+	}
+
+	// Writes every active loan to a file, as CSV with a header row or JSON Lines, in title order
+	bool exportLoans(const std::string& fileName, ExportFormat format = EXPORT_CSV) {
+		BufferedFileWriter writer;
+		if (!writer.open(fileName)) {
+			std::cout << "Book Library: Could not open '" << fileName << "' to export the loans!" << std::endl;
+			return false;
+		}
+		writeLoanExportHeader(writer, format);
+		for (size_t i = 0; i < issuedBookList.size(); i++) {
+			const LibraryLoan& loan = issuedBookList[i];
+			writeLoanRow(writer, *booksByID[loan.bookID], loan.issuedStudent, loan.checkoutTime, loan.dueTime, format);
+		}
+		return finishExport(writer, fileName, issuedBookList.size(), "loans");
+	}
+
+	// Drops the frozen title index, so every lookup goes to the hash table again
+	void unfreezeCatalog() {
+		frozenTitles.clear();
+		frozenHasAllTitles = false;
+	}
+
+	bool isCatalogFrozen() {
+		return frozenTitles.isBuilt();
+	}
+
+	// Returns the number of books in the library
+	int getNumBooks() {
+		finishLoadingBooks();
+		return bookMap.getNumPairs();
 	}
 
-	// Returns a book based on its title; if book wasn't found we return a default book object
-	// Then after we should be able to follow up with either editing, checking out, etc.
-	Book getBook(std::string title) {
-		// Lowercasing the key, our title, since we are accessing and messing with the hash table
-		Book targetBook = bookMap.getValue(lowerCaseString(title));
-		return targetBook;
+	// Returns the number of students registered in the library
+	int getNumStudents() {
+		return static_cast<int>(libraryStudents.size());
+	}
+
+	// Returns the number of books that are issued right now
+	int getNumIssuedBooks() {
+		return static_cast<int>(issuedBookList.size());
+	}
+
+	// Whether a book is issued to a student right now
+	bool isIssuedTo(const Book& book, const Student& student) {
+		return findIssuedEntry(book, student) >= 0;
 	}
 
 	// Issues a book to student and updates the issuedBookEntry vector
-	void issueBook(Book book, Student student) {
+	void issueBook(const Book& book, const Student& student) {
+		LIBRARY_TIME_OPERATION(metrics, OP_ISSUE_BOOK);
+		TracedOperation traced(traceWriter.get(), TRACE_ISSUE_BOOK, clock, book.title, student.getFirstName(), student.getLastName(), student.getStudentID());
+		// NOTE: We lower case the title since we're expecting the user to get a book object that's stored in the program
+		// In this case, Book object being added by addBook, will have its title not lowercased, so we have to lowercase
+		// it so it correctly indexes in the hash table to the right position, and it correctly matches the node. 
+		// We work on the stored book itself, so its availability is up to date even if the caller's copy isn't.
+		Book* storedBook = findStoredBookByTitle(book.title);
+		if (storedBook == nullptr) {
+			if (verbose) std::cout << "Book Library: Cannot issue '" << book.title << "' since it isn't in the library!" << std::endl;
+			return;
+		}
 		// If the book is already unavailable, then we aren't allowed to check it out or issue it
 		// NOTE: This should have already been checked in promptIssueBook, but we have the check here if we 
 		// we want to use a separate function
-		if (book.isAvailable == false) { 
-			std::cout << "Book Library: Cannot issue '" << book.title << "' by " << book.author << " since it has already been issued!" << std::endl;
+		if (storedBook->isAvailable == false) { 
+			if (verbose) std::cout << "Book Library: Cannot issue '" << book.title << "' by " << book.author << " since it has already been issued!" << std::endl;
 			return;
 		}
 		// Else the book is available so take steps to issue the book to said student
-		book.isAvailable = false; // Make the book now not available since it's being issued to someone
-		issuedBookEntry currentEntry = { book, student }; // Create new issuedBookEntry object with the book being issued and student that the book's being issued to
-		issuedBookList.push_back(currentEntry); // Now update the book in the bookMap so that it's marked as unavailable
-		// NOTE: We lower case the title since we're expecting the user to get a book object that's stored in the program
-		// In this case, Book object being added by addBook, will have its title not lowercased, so we have to lowercase
-		// it so it correctly indexes in the hash table to the right position, and it correctly matches the node. 
-		bookMap.updatePair(lowerCaseString(book.title), book); // Show a message from the library that tells the user that the book has been issued
-		std::cout << "Book Library: Successfully issued '" << book.title << "' to " << student << "!" << std::endl;
+		storedBook->isAvailable = false; // Make the book now not available since it's being issued to someone
+		availableBooks.remove(storedBook->bookID);
+		// Record the issued book along with the student it's issued to, and when it's due back
+		updateDueDates();
+		LibraryLoan newLoan{ storedBook->bookID, student };
+		newLoan.checkoutTime = clock();
+		newLoan.dueTime = newLoan.checkoutTime + loanPeriodSeconds;
+		newLoan.loanID = allocateLoanID();
+		loanPositions[newLoan.loanID] = static_cast<int>(issuedBookList.size());
+		dueDates.schedule(newLoan.loanID, overdueTick(newLoan.dueTime));
+		issuedBookList.push_back(newLoan);
+		publishBook(storedBook->bookID);
+		publishLoan(newLoan.loanID);
+		circulation.recordIssue(*storedBook, student);
+		traced.succeeded();
+		// Show a message from the library that tells the user that the book has been issued
+		if (verbose) std::cout << "Book Library: Successfully issued '" << book.title << "' to " << student << "!" << std::endl;
 	}
 
-	// Returns an issued book given a book and a student object
-	void returnBook(Book book, Student student) {
-		bool found = false;
-		issuedBookEntry tempEntry = { book, student };
+	/*
+	+ Issues a stack of books to a student at once. Each item is a title or an ISBN. Every book is looked up once and
+	checked before anything changes, so either all of them are issued or, if any is missing, already issued or listed
+	twice, none are. The books are then issued straight from those lookups (one clock reading and due date update for
+	the whole batch) rather than going through getBook and issueBook for each one.
+
+	+ NOTE: BookLibrary has no locks of its own; in a LibraryFederation the whole batch runs as one task on the branch's
+	worker, so it takes the branch's mutex once.
+	*/
+	BatchResult issueBooks(const Student& student, const std::vector<std::string>& items) {
+		TracedOperation traced(traceWriter.get(), TRACE_ISSUE_BOOKS, clock, student.getFirstName(), student.getLastName(), student.getStudentID(), items);
+		BatchResult result;
+		std::vector<Book*> batchBooks;
+		if (!findBatchBooks(items, batchBooks, result)) {
+			if (verbose) std::cout << "Book Library: Couldn't issue the books to " << student << " since " << result.reason << "!" << std::endl;
+			return result;
+		}
+		for (size_t i = 0; i < batchBooks.size(); i++) {
+			if (!batchBooks[i]->isAvailable) {
+				result.failedItem = static_cast<int>(i);
+				result.reason = "'" + batchBooks[i]->title + "' has already been issued";
+				if (verbose) std::cout << "Book Library: Couldn't issue the books to " << student << " since " << result.reason << "!" << std::endl;
+				return result;
+			}
+		}
+		// Everything checks out, so nothing below can fail part way; the list is grown first so it can't either (at
+		// least doubling, as push_back would, so a run of batches doesn't copy the list every time)
+		if (issuedBookList.capacity() < issuedBookList.size() + batchBooks.size()) {
+			issuedBookList.reserve(std::max(issuedBookList.size() + batchBooks.size(), 2 * issuedBookList.capacity()));
+		}
+		updateDueDates();
+		long long checkoutTime = clock();
+		for (size_t i = 0; i < batchBooks.size(); i++) {
+			Book* storedBook = batchBooks[i];
+			storedBook->isAvailable = false;
+			availableBooks.remove(storedBook->bookID);
+			LibraryLoan newLoan{ storedBook->bookID, student };
+			newLoan.checkoutTime = checkoutTime;
+			newLoan.dueTime = checkoutTime + loanPeriodSeconds;
+			newLoan.loanID = allocateLoanID();
+			loanPositions[newLoan.loanID] = static_cast<int>(issuedBookList.size());
+			dueDates.schedule(newLoan.loanID, overdueTick(newLoan.dueTime));
+			issuedBookList.push_back(newLoan);
+			publishBook(storedBook->bookID);
+			publishLoan(newLoan.loanID);
+			circulation.recordIssue(*storedBook, student);
+		}
+		result.applied = true;
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Successfully issued " << batchBooks.size() << " books to " << student << "!" << std::endl;
+		return result;
+	}
+
+	// Returns a stack of books from a student at once, all or nothing like issueBooks: every item has to be a book
+	// that's issued to the student. The student's loans are found in one pass over the issued list and removed in
+	// another, instead of a search and an erase for each book. Books someone is waiting for then go to the next
+	// student in line, as with returnBook.
+	BatchResult returnBooks(const Student& student, const std::vector<std::string>& items) {
+		TracedOperation traced(traceWriter.get(), TRACE_RETURN_BOOKS, clock, student.getFirstName(), student.getLastName(), student.getStudentID(), items);
+		BatchResult result;
+		std::vector<Book*> batchBooks;
+		if (!findBatchBooks(items, batchBooks, result)) {
+			if (verbose) std::cout << "Book Library: Couldn't return the books from " << student << " since " << result.reason << "!" << std::endl;
+			return result;
+		}
+		// Position in issuedBookList of each book's loan to the student
+		std::vector<int> positions(batchBooks.size(), -1);
 		for (size_t i = 0; i < issuedBookList.size(); i++) {
-			// If the entry matches, then our book and student matches one in the record
-			// Now we know it exists, we can delete
-			if (tempEntry == issuedBookList[i]) {
-				// Delete the issuedBookEntry object from the vector
-				issuedBookList.erase(issuedBookList.begin() + i);
-				found = true;
-				break;
+			if (!(issuedBookList[i].issuedStudent == student)) {
+				continue;
+			}
+			for (size_t j = 0; j < batchBooks.size(); j++) {
+				if (positions[j] < 0 && issuedBookList[i].bookID == batchBooks[j]->bookID) {
+					positions[j] = static_cast<int>(i);
+					break;
+				}
+			}
+		}
+		for (size_t j = 0; j < batchBooks.size(); j++) {
+			if (positions[j] < 0) {
+				result.failedItem = static_cast<int>(j);
+				result.reason = "'" + batchBooks[j]->title + "' isn't issued to them";
+				if (verbose) std::cout << "Book Library: Couldn't return the books from " << student << " since " << result.reason << "!" << std::endl;
+				return result;
+			}
+		}
+		// Finish each loan, then close the gaps they leave in the issued list in one pass
+		long long returnTime = clock();
+		std::vector<bool> returning(issuedBookList.size(), false);
+		size_t firstRemoved = issuedBookList.size();
+		for (size_t j = 0; j < batchBooks.size(); j++) {
+			LibraryLoan& entry = issuedBookList[positions[j]];
+			circulation.recordReturn(returnTime - entry.checkoutTime);
+			dueDates.cancel(entry.loanID);
+			loanPositions[entry.loanID] = -1;
+			publishLoan(entry.loanID);
+			freeLoanIDs.push_back(entry.loanID);
+			returning[positions[j]] = true;
+			firstRemoved = std::min(firstRemoved, static_cast<size_t>(positions[j]));
+			batchBooks[j]->isAvailable = true;
+			availableBooks.add(batchBooks[j]->bookID);
+			publishBook(batchBooks[j]->bookID);
+		}
+		size_t kept = firstRemoved;
+		for (size_t i = firstRemoved; i < issuedBookList.size(); i++) {
+			if (!returning[i]) {
+				issuedBookList[kept] = std::move(issuedBookList[i]);
+				kept += 1;
 			}
 		}
+		issuedBookList.resize(kept);
+		updateLoanPositions(firstRemoved);
+		result.applied = true;
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Successfully returned " << batchBooks.size() << " books from " << student << "!" << std::endl;
+		// Hand the books with waitlists to whoever is first in line for each
+		for (size_t j = 0; j < batchBooks.size(); j++) {
+			int nextHold = holdQueues.frontHold(batchBooks[j]->bookID);
+			if (nextHold >= 0) {
+				int holderID = holdQueues.getHolder(nextHold);
+				Student nextStudent = holders[holderID];
+				holdQueues.removeHold(nextHold);
+				releaseHolderIDIfUnused(holderID);
+				if (verbose) std::cout << "Book Library: '" << batchBooks[j]->title << "' goes to the next student on its waitlist, " << nextStudent << "!" << std::endl;
+				issueBook(*batchBooks[j], nextStudent);
+			}
+		}
+		return result;
+	}
+
+	// Returns an issued book given a book and a student object
+	void returnBook(const Book& book, const Student& student) {
+		LIBRARY_TIME_OPERATION(metrics, OP_RETURN_BOOK);
+		// If an entry matches, then our book and student matches one in the record
+		// NOTE: The trace gets the loaned book's title as it is now, since the caller's copy may be from before an edit
+		// and a replay looks the book up by the title it was given
+		int position = findIssuedEntry(book, student);
+		const std::string& tracedTitle = position >= 0 ? booksByID[issuedBookList[position].bookID]->title : book.title;
+		TracedOperation traced(traceWriter.get(), TRACE_RETURN_BOOK, clock, tracedTitle, student.getFirstName(), student.getLastName(), student.getStudentID());
+		bool found = false;
+		Book* storedBook = nullptr;
+		// Now we know it exists, we can delete it, along with its due date
+		if (position >= 0) {
+			int loanID = issuedBookList[position].loanID;
+			storedBook = booksByID[issuedBookList[position].bookID];
+			circulation.recordReturn(clock() - issuedBookList[position].checkoutTime);
+			dueDates.cancel(loanID);
+			loanPositions[loanID] = -1;
+			publishLoan(loanID);
+			freeLoanIDs.push_back(loanID);
+			// Delete the issuedBookEntry object from the vector
+			issuedBookList.erase(issuedBookList.begin() + position);
+			updateLoanPositions(position);
+			found = true;
+			traced.succeeded();
+		}
 		// If we found a mathcing tempEntry object update the bookMap to show that the book is now available
 		// Then show the user that it was successfully returned
 		if (found) {
-			// Now update the book in the bookMap by first making it available and updating the pair
-			Book returnedBook = tempEntry.issuedBook;
-			returnedBook.isAvailable = true;
-			bookMap.updatePair(lowerCaseString(returnedBook.title), returnedBook);
-			std::cout << "Book Library: Successfully returned '" << book.title << "' from " << student << "!" << std::endl;
+			// Now make the book in the bookMap available again, in place; the loan says which book it is, even if the
+			// caller's copy has an old title
+			storedBook->isAvailable = true;
+			availableBooks.add(storedBook->bookID);
+			publishBook(storedBook->bookID);
+			if (verbose) std::cout << "Book Library: Successfully returned '" << storedBook->title << "' from " << student << "!" << std::endl;
+			// If anyone is waiting for the book, it goes straight to whoever is first in line
+			int nextHold = holdQueues.frontHold(storedBook->bookID);
+			if (nextHold >= 0) {
+				int holderID = holdQueues.getHolder(nextHold);
+				Student nextStudent = holders[holderID];
+				holdQueues.removeHold(nextHold);
+				releaseHolderIDIfUnused(holderID);
+				if (verbose) std::cout << "Book Library: '" << storedBook->title << "' goes to the next student on its waitlist, " << nextStudent << "!" << std::endl;
+				issueBook(*storedBook, nextStudent);
+			}
 		} else {
 			// Else tell the user that we couldn't return their book
-			std::cout << "Book Library: Couldn't return '" << book.title << "' from " << student << "!" << std::endl;
+			if (verbose) std::cout << "Book Library: Couldn't return '" << book.title << "' from " << student << "!" << std::endl;
 		}
 	}
 
@@ -188,7 +1674,7 @@ public:
 	// book from the library.
 	void promptDeleteBook() {
 		// If there are no books, then we can't delete any books
-		if ((getAllBooks()).size() == 0) {
+		if (bookMap.getNumPairs() == 0 && !lazyBooks) {
 			std::cout << "Book Library: No books stored in library to delete!" << std::endl;
 			return;
 		}
@@ -199,19 +1685,75 @@ public:
 		deleteBook(inputTitle);
 	}
 
+	// Prompts input for editing a book; leaving a detail blank keeps the book's current one
+	void promptEditBook() {
+		if (bookMap.getNumPairs() == 0 && !lazyBooks) {
+			std::cout << "Book Library: No books stored in library to edit!" << std::endl;
+			return;
+		}
+		std::string inputTitle;
+		std::cout << "Enter book title: ";
+		std::getline(std::cin, inputTitle);
+		Book* storedBook = findStoredBookByTitle(inputTitle);
+		if (storedBook == nullptr) {
+			std::cout << "Book Library: Could not find '" << inputTitle << "' in the library!" << std::endl;
+			return;
+		}
+		std::cout << "Editing " << *storedBook << std::endl;
+		std::string inputNewTitle;
+		std::string inputAuthor;
+		std::string inputISBN;
+		std::string inputNumPages;
+		std::cout << "Enter new title (blank to keep it): ";
+		std::getline(std::cin, inputNewTitle);
+		std::cout << "Enter new author (blank to keep it): ";
+		std::getline(std::cin, inputAuthor);
+		std::cout << "Enter new ISBN (blank to keep it): ";
+		std::getline(std::cin, inputISBN);
+		std::cout << "Enter new number of pages (blank to keep it): ";
+		std::getline(std::cin, inputNumPages);
+		int newNumPages = storedBook->numPages;
+		if (inputNumPages != "") {
+			newNumPages = std::atoi(inputNumPages.c_str());
+			if (newNumPages <= 0) {
+				std::cout << "Book Library: '" << inputNumPages << "' isn't a number of pages!" << std::endl;
+				return;
+			}
+		}
+		editBook(inputTitle, inputNewTitle != "" ? inputNewTitle : storedBook->title, inputAuthor != "" ? inputAuthor : storedBook->author,
+			inputISBN != "" ? inputISBN : storedBook->ISBN, newNumPages);
+	}
+
 	// Prompts user for a book title and displays the book's information if book was found
 	void promptSearchBook() {
 		// If the library is empty then abort the process 
-		if ((getAllBooks()).size() == 0) {
+		if (bookMap.getNumPairs() == 0 && !lazyBooks) {
 			std::cout << "Book Library: No books in the library to show or search for!" << std::endl;
 			return; 
 		}
-		// Show all books in the library since there are some books
-		showAllBooks();
-		// Prompt input on the book title that the user wants to look at 
+		// Show the books a page at a time until the user enters a title; a blank line moves on to the next page,
+		// and after the last page we start over from the first
+		// NOTE: While the catalog is still loading, a page would have to wait for all of it, so the first page is only
+		// shown if the user asks for it with a blank line; looking up a title only waits for that one book
 		std::string inputTitle;
-		std::cout << "Enter a book title to view it: ";
-		std::getline(std::cin, inputTitle);
+		int offset = 0;
+		bool showPage = !lazyBooks;
+		while (inputTitle == "") {
+			if (showPage) {
+				showBooksPage(offset, listingPageSize);
+				std::cout << "Enter a book title to view it (or leave it blank to see the next page): ";
+			} else {
+				std::cout << "Enter a book title to view it (or leave it blank to see the books): ";
+			}
+			std::getline(std::cin, inputTitle);
+			if (showPage) {
+				offset += listingPageSize;
+				if (offset >= bookMap.getNumPairs()) {
+					offset = 0;
+				}
+			}
+			showPage = true;
+		}
 		Book targetBook = getBook(inputTitle);
 		if (targetBook.ISBN == "") {
 			std::cout << "Book Library: Book titled '" << inputTitle << "' does not exist in this library!" << std::endl;
@@ -223,10 +1765,8 @@ public:
 
 	// Prompts input for issuing a book to a student, and if successful it issues a book
 	void promptIssueBook() {
-		// Get an array of all books from the table
-		std::vector<Book> allBooks = getAllBooks();
 		// If there are no students, or no book, then we can't issue books
-		if (libraryStudents.size() == 0 || allBooks.size() == 0) {
+		if (libraryStudents.size() == 0 || (bookMap.getNumPairs() == 0 && !lazyBooks)) {
 			std::cout << "Book Library: Can't issue books since there are either no books or no students in library!" << std::endl;
 			return;
 		}
@@ -244,23 +1784,22 @@ public:
 		// Else the book exists so we can print out detailed information about it
 		displayBookInfo(targetBook);
 		// If the book isn't available, then tell the user, and then return.
-		// to the home screen again.
+		// to the home screen again, after offering to put a student on its waitlist.
 		if (targetBook.isAvailable == false) {
 			std::cout << "Book Library: '" << targetBook.title << "' is currently not available to be issued!" << std::endl;
+			int holdChoice;
+			std::cout << "Place a hold on it for a student? (1 for yes, 0 for no): ";
+			std::cin >> holdChoice;
+			holdChoice = validateMenuInput(holdChoice, 0, 1);
+			if (holdChoice == 1) {
+				Student holdStudent = libraryStudents[promptSelectStudent("Enter the number corresponding to the student")];
+				placeHold(targetBook, holdStudent);
+			}
 			return;
 		}
 		// Else we have a valid book that's available
-		// List position of the student chosen by the user from the libraryStudents vector
-		int studentChoice;
-		// Show all students that the user can issue book to and prompt input. 
-		// Ensure that they enter something in range.
-		showAllStudents();
-		std::cout << "Enter the number corresponding to the student: ";
-		std::cin >> studentChoice;
-		studentChoice = validateMenuInput(studentChoice, 1, libraryStudents.size());
-		// Access the student object that the user wanted to choose
-		// Decrement by one to get the correct element
-		Student targetStudent = libraryStudents[studentChoice - 1];
+		// Let the user pick the student from the pages of students
+		Student targetStudent = libraryStudents[promptSelectStudent("Enter the number corresponding to the student")];
 		// Now we have a valid student and a valid book, so we can issue it now
 		issueBook(targetBook, targetStudent);
 	}
@@ -273,54 +1812,329 @@ public:
 			std::cout << "Book Library: Failure to proceed returning books since no books have been issued yet!" << std::endl;
 			return;
 		}
-		// Integer representing the eventually index position of the element they want
-		// to pick in issuedBooklist
-		int issueBookChoice;
-		// Show the record of issued books and students they were issued to, and prompt input
-		showIssuedEntries();
-		std::cout << "Enter the number corresponding to the entry: ";
-		std::cin >> issueBookChoice;
-		issueBookChoice = validateMenuInput(issueBookChoice, 1, issuedBookList.size());
 		// Get the entry that the user picked and then call the function to return the book
 		// by passing in the target book and the target student that we want to delete using 
 		// targetEntry.
-		issuedBookEntry targetEntry = issuedBookList[issueBookChoice - 1];
+		issuedBookEntry targetEntry = promptSelectIssuedEntry();
 		returnBook(targetEntry.issuedBook, targetEntry.issuedStudent);
 	}
 
+	// Renews the loan of a book to a student, so it's due a full loan period from now; returns whether there was such a loan
+	bool renewLoan(const Book& book, const Student& student) {
+		TracedOperation traced(traceWriter.get(), TRACE_RENEW_LOAN, clock, book.title, student.getFirstName(), student.getLastName(), student.getStudentID());
+		updateDueDates();
+		int position = findIssuedEntry(book, student);
+		if (position < 0) {
+			if (verbose) std::cout << "Book Library: Couldn't renew '" << book.title << "' for " << student << " since it isn't issued to them!" << std::endl;
+			return false;
+		}
+		LibraryLoan& entry = issuedBookList[position];
+		// Someone waiting for the book gets it when it's due, rather than the loan going on
+		if (holdQueues.getQueueLength(entry.bookID) > 0) {
+			if (verbose) std::cout << "Book Library: Couldn't renew '" << book.title << "' since other students are waiting for it!" << std::endl;
+			return false;
+		}
+		entry.dueTime = clock() + loanPeriodSeconds;
+		publishLoan(entry.loanID);
+		// Moves the loan to its new slot in the wheel, or back out of the overdue ones
+		dueDates.schedule(entry.loanID, overdueTick(entry.dueTime));
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Renewed '" << book.title << "' for " << student << " until " << formatDate(entry.dueTime) << "!" << std::endl;
+		return true;
+	}
+
+	// Puts a student on the waitlist for an issued book, behind everyone with the same or higher priority (so with the
+	// default priority, in the order the holds were placed). Returns whether the hold was placed.
+	bool placeHold(const Book& book, const Student& student, int priority = 0) {
+		TracedOperation traced(traceWriter.get(), TRACE_PLACE_HOLD, clock, book.title, student.getFirstName(), student.getLastName(), student.getStudentID(),
+			static_cast<long long>(priority));
+		Book* storedBook = findStoredBookByTitle(book.title);
+		if (storedBook == nullptr) {
+			if (verbose) std::cout << "Book Library: Cannot place a hold on '" << book.title << "' since it isn't in the library!" << std::endl;
+			return false;
+		}
+		if (storedBook->isAvailable) {
+			if (verbose) std::cout << "Book Library: '" << book.title << "' is available, so it can be issued instead of held!" << std::endl;
+			return false;
+		}
+		int holderID = acquireHolderID(student);
+		if (holdQueues.findHold(storedBook->bookID, holderID) >= 0) {
+			if (verbose) std::cout << "Book Library: " << student << " already has a hold on '" << book.title << "'!" << std::endl;
+			return false;
+		}
+		int hold = holdQueues.addHold(storedBook->bookID, holderID, priority);
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Placed a hold on '" << book.title << "' for " << student << ", number " << holdQueues.getPosition(hold) << " in line!" << std::endl;
+		return true;
+	}
+
+	// Takes a student off the waitlist for a book; returns whether they were on it
+	bool cancelHold(const Book& book, const Student& student) {
+		TracedOperation traced(traceWriter.get(), TRACE_CANCEL_HOLD, clock, book.title, student.getFirstName(), student.getLastName(), student.getStudentID());
+		Book* storedBook = findStoredBookByTitle(book.title);
+		int holderID = findHolderID(student.getStudentID());
+		int hold = storedBook != nullptr && holderID >= 0 ? holdQueues.findHold(storedBook->bookID, holderID) : -1;
+		if (hold < 0) {
+			if (verbose) std::cout << "Book Library: " << student << " doesn't have a hold on '" << book.title << "'!" << std::endl;
+			return false;
+		}
+		holdQueues.removeHold(hold);
+		releaseHolderIDIfUnused(holderID);
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Cancelled the hold on '" << book.title << "' for " << student << "!" << std::endl;
+		return true;
+	}
+
+	// Returns a student's place in line for a book, where 1 is next; 0 if they don't have a hold on it
+	int getHoldPosition(const Book& book, const Student& student) {
+		Book* storedBook = findStoredBookByTitle(book.title);
+		int holderID = findHolderID(student.getStudentID());
+		int hold = storedBook != nullptr && holderID >= 0 ? holdQueues.findHold(storedBook->bookID, holderID) : -1;
+		return hold < 0 ? 0 : holdQueues.getPosition(hold);
+	}
+
+	// Returns the books a student (by ID) is waiting for, in the order they placed the holds
+	std::vector<Book> getStudentHolds(const std::string& studentID) {
+		std::vector<Book> heldBooks;
+		holdQueues.forEachHoldOf(findHolderID(studentID), [this, &heldBooks](int bookID, int) {
+			heldBooks.push_back(*booksByID[bookID]);
+		});
+		return heldBooks;
+	}
+
+	// Returns how many students are waiting for a book
+	int getNumHolds(const Book& book) {
+		Book* storedBook = findStoredBookByTitle(book.title);
+		return storedBook == nullptr ? 0 : holdQueues.getQueueLength(storedBook->bookID);
+	}
+
+	// Returns the k most borrowed titles, most borrowed first. Unless exact counts are on, these are the heavy hitters
+	// of a space-saving summary, so a count can be too high by up to its error.
+	std::vector<CirculationCount> getMostBorrowedTitles(int k) {
+		return circulation.getTopTitles(k);
+	}
+
+	// Returns the k students (by ID) who have borrowed the most books, most first
+	std::vector<CirculationCount> getMostActiveStudents(int k) {
+		return circulation.getTopStudents(k);
+	}
+
+	// Returns the k authors whose books have been borrowed the most, most first
+	std::vector<CirculationCount> getTopAuthors(int k) {
+		return circulation.getTopAuthors(k);
+	}
+
+	// Returns how many times a title (exactly as stored) has been issued; an estimate that's never too low unless
+	// exact counts are on
+	long long getTitleCirculation(const std::string& title) {
+		return circulation.getTitleCount(title);
+	}
+
+	// Returns how many times books by an author (exactly as stored) have been issued, estimated like getTitleCirculation
+	long long getAuthorCirculation(const std::string& author) {
+		return circulation.getAuthorCount(author);
+	}
+
+	// Turns exact circulation counts on or off (off keeps them in a fixed amount of memory); the counts start over
+	void setExactCirculationCounts(bool exact) {
+		circulation.setExact(exact);
+	}
+
+	// Shows the top ten titles, students and authors by circulation
+	void showCirculationReport() {
+		const int reportSize = 10;
+		std::cout << "Book Library: Circulation Report (" << circulation.getNumIssues() << " issues, " << circulation.getNumReturns()
+			<< " returns, average loan " << circulation.getAverageLoanSeconds() / (24 * 60 * 60) << " days"
+			<< (circulation.isExact() ? "" : ", counts are estimates") << "): " << std::endl;
+		std::vector<CirculationCount> topTitles = getMostBorrowedTitles(reportSize);
+		std::cout << "Most Borrowed Titles: " << std::endl;
+		for (size_t i = 0; i < topTitles.size(); i++) {
+			std::cout << i + 1 << ". " << topTitles[i].key << " - " << topTitles[i].count << " issues" << std::endl;
+		}
+		std::vector<CirculationCount> topStudents = getMostActiveStudents(reportSize);
+		std::cout << "Most Active Students: " << std::endl;
+		for (size_t i = 0; i < topStudents.size(); i++) {
+			std::cout << i + 1 << ". Student ID#: " << topStudents[i].key << " - " << topStudents[i].count << " issues" << std::endl;
+		}
+		std::vector<CirculationCount> topAuthors = getTopAuthors(reportSize);
+		std::cout << "Most Borrowed Authors: " << std::endl;
+		for (size_t i = 0; i < topAuthors.size(); i++) {
+			std::cout << i + 1 << ". " << topAuthors[i].key << " - " << topAuthors[i].count << " issues" << std::endl;
+		}
+	}
+
+	// Prompts input for renewing an issued book, and if successful it renews the loan
+	void promptRenewBook() {
+		if (issuedBookList.size() == 0) {
+			std::cout << "Book Library: Failure to proceed renewing books since no books have been issued yet!" << std::endl;
+			return;
+		}
+		issuedBookEntry targetEntry = promptSelectIssuedEntry();
+		renewLoan(targetEntry.issuedBook, targetEntry.issuedStudent);
+	}
+
+	// Returns the loans that are overdue, in title order. Only the loans the due date wheel has marked as overdue are
+	// looked at.
+	std::vector<issuedBookEntry> getOverdueLoans() {
+		updateDueDates();
+		std::vector<issuedBookEntry> overdueLoans;
+		dueDates.forEachExpired([this, &overdueLoans](int loanID) {
+			overdueLoans.push_back(makeIssuedEntry(issuedBookList[loanPositions[loanID]]));
+		});
+		mergeSortInPlace(overdueLoans);
+		return overdueLoans;
+	}
+
+	// Returns the loans that aren't overdue yet but are due within the given number of seconds, in title order
+	std::vector<issuedBookEntry> getLoansDueWithin(long long seconds) {
+		updateDueDates();
+		long long lastDueTime = clock() + seconds;
+		std::vector<issuedBookEntry> dueLoans;
+		dueDates.forEachExpiringBy(overdueTick(lastDueTime), [this, &dueLoans, lastDueTime](int loanID, long long) {
+			const LibraryLoan& loan = issuedBookList[loanPositions[loanID]];
+			if (loan.dueTime <= lastDueTime) {
+				dueLoans.push_back(makeIssuedEntry(loan));
+			}
+		});
+		mergeSortInPlace(dueLoans);
+		return dueLoans;
+	}
+
+	// Number of loans that are overdue
+	int getNumOverdueLoans() {
+		updateDueDates();
+		return dueDates.getNumExpired();
+	}
+
+	// Replaces the clock the library takes checkout and due times from, which returns seconds since the epoch;
+	// e.g. a simulation can run a semester of loans in a second. Loans already issued keep their due dates.
+	void setClock(std::function<long long()> _clock) {
+		clock = _clock;
+		// The new clock might be behind the wheel, so start the wheel over from its time
+		dueDates.clear(clock() / dueTickSeconds);
+		for (size_t i = 0; i < issuedBookList.size(); i++) {
+			dueDates.schedule(issuedBookList[i].loanID, overdueTick(issuedBookList[i].dueTime));
+		}
+	}
+
+	// Starts recording every operation called on the library into a binary trace file (see OperationTrace.h), for
+	// TraceReplay to run again later; returns false if the file can't be created
+	bool startTrace(const std::string& fileName) {
+		stopTrace();
+		traceWriter.reset(new OperationTraceWriter());
+		if (!traceWriter->open(fileName)) {
+			traceWriter.reset();
+			std::cout << "Book Library: Could not open '" << fileName << "' to record a trace!" << std::endl;
+			return false;
+		}
+		if (verbose) std::cout << "Book Library: Recording operations to '" << fileName << "'" << std::endl;
+		return true;
+	}
+
+	// Stops recording and writes out the rest of the trace; returns the number of operations recorded
+	long long stopTrace() {
+		if (!traceWriter) {
+			return 0;
+		}
+		long long numRecords = traceWriter->getNumRecords();
+		if (!traceWriter->close()) {
+			std::cout << "Book Library: Could not write all of the trace!" << std::endl;
+		}
+		traceWriter.reset();
+		return numRecords;
+	}
+
+	bool isTracing() {
+		return traceWriter != nullptr;
+	}
+
+	// Sets how many days a book is issued for (loans made before keep their due dates)
+	void setLoanPeriodDays(int days) {
+		loanPeriodSeconds = static_cast<long long>(days) * 24 * 60 * 60;
+	}
+
+	// Shows the overdue loans, then the ones due in the next week
+	void showDueDates() {
+		std::vector<issuedBookEntry> overdueLoans = getOverdueLoans();
+		std::vector<issuedBookEntry> dueLoans = getLoansDueWithin(7LL * 24 * 60 * 60);
+		if (overdueLoans.empty()) {
+			std::cout << "Book Library: No books are overdue!" << std::endl;
+		} else {
+			std::cout << "Book Library: Overdue Books: " << std::endl;
+			for (size_t i = 0; i < overdueLoans.size(); i++) {
+				std::cout << i + 1 << ". " << overdueLoans[i] << std::endl;
+			}
+		}
+		if (dueLoans.empty()) {
+			std::cout << "Book Library: No other books are due this week!" << std::endl;
+		} else {
+			std::cout << "Book Library: Books Due This Week: " << std::endl;
+			for (size_t i = 0; i < dueLoans.size(); i++) {
+				std::cout << i + 1 << ". " << dueLoans[i] << std::endl;
+			}
+		}
+	}
+
 	// Adds a student to the library, allowing the user to issue that student a book
 	void addStudent(std::string firstName, std::string lastName, std::string studentID) {
+		LIBRARY_TIME_OPERATION(metrics, OP_ADD_STUDENT);
+		TracedOperation traced(traceWriter.get(), TRACE_ADD_STUDENT, clock, firstName, lastName, studentID);
 		if (isExistingStudent(studentID)) {
-			std::cout << "Book Library: Student with ID '" << studentID << "' already exists in the library!" << std::endl;
+			if (verbose) std::cout << "Book Library: Student with ID '" << studentID << "' already exists in the library!" << std::endl;
 			return;
 		}
-		// Then a new Student class instance into the libraryStudents vector and sort the vector
-		Student newStudent = Student(firstName, lastName, studentID);
-		libraryStudents.push_back(newStudent);
-		std::cout << "Book Library: Successfully added student " << newStudent << std::endl;
+		// Then insert a new Student class instance into the libraryStudents vector where it belongs by name, so the vector
+		// is always sorted and listings don't have to sort it. upper_bound binary searches for the first student that comes after it.
+		Student newStudent = Student(std::move(firstName), std::move(lastName), std::move(studentID));
+		std::vector<Student>::iterator position = libraryStudents.insert(
+			std::upper_bound(libraryStudents.begin(), libraryStudents.end(), newStudent), std::move(newStudent));
+		if (useBloomFilters) {
+			studentIDFilter.add(FNV1aHash::hash(position->getStudentID()));
+			if (studentIDFilter.isDegraded()) {
+				rebuildStudentIDFilter();
+			}
+		}
+		publishStudents();
+		traced.succeeded();
+		if (verbose) std::cout << "Book Library: Successfully added student " << *position << std::endl;
 	}
 
 	// Deletes a student based on its studentID
 	// NOTE: Don't need to sort, since we already assumed it's been sorted from addStudent, so removing an element wouldn't mess with the order
-	void deleteStudent(std::string studentID) {
+	void deleteStudent(const std::string& studentID) {
+		LIBRARY_TIME_OPERATION(metrics, OP_DELETE_STUDENT);
+		TracedOperation traced(traceWriter.get(), TRACE_DELETE_STUDENT, clock, studentID);
 		bool found = false;
 		Student targetStudent;
 		for (size_t i = 0; i < libraryStudents.size(); i++) {
 			// If the student if of current student matches passed ID
 			// Then we found the target student that the user wanted to delete
 			if (libraryStudents[i].getStudentID() == studentID) {
-				// Erase the student from vector
-				targetStudent = libraryStudents[i];
+				// Erase the student from vector, along with any holds they have
+				int holderID = findHolderID(studentID);
+				if (holderID >= 0) {
+					holdQueues.removeHoldsOf(holderID);
+					releaseHolderIDIfUnused(holderID);
+				}
+				targetStudent = std::move(libraryStudents[i]);
 				libraryStudents.erase(libraryStudents.begin() + i);
 				found = true;
+				publishStudents();
+				traced.succeeded();
+				if (useBloomFilters) {
+					studentIDFilter.recordRemoval();
+					if (studentIDFilter.isDegraded()) {
+						rebuildStudentIDFilter();
+					}
+				}
 				break;
 			}
 		}
 		// Then output the result to the user
 		if (found) {
-			std::cout << "Book Library: Successfully deleted student " << targetStudent << " from library!" << std::endl;
+			if (verbose) std::cout << "Book Library: Successfully deleted student " << targetStudent << " from library!" << std::endl;
 		} else {
-			std::cout << "Book Library: Failed to find and delete student with ID: " << studentID << std::endl;
+			if (verbose) std::cout << "Book Library: Failed to find and delete student with ID: " << studentID << std::endl;
 		}
 	}
 
@@ -348,20 +2162,14 @@ public:
 			std::cout << "Book Library: There are no students registerd with library!" << std::endl;
 			return;
 		}
-		// Then show all students, since we know there are students in the library
-		showAllStudents();
-		// Prompt input for a student and access the student from the vector
-		int studentChoice;
-		std::cout << "Select student based on the menu number: ";
-		std::cin >> studentChoice;
-		studentChoice = validateMenuInput(studentChoice, 1, libraryStudents.size());
-		Student targetStudent = libraryStudents[studentChoice - 1];
+		// Then let the user pick a student from the pages of students, since we know there are students in the library
+		Student targetStudent = libraryStudents[promptSelectStudent("Select student based on the menu number")];
 		// Then pass the id of that student to the function to delete the student from the library instance
 		deleteStudent(targetStudent.getStudentID());
 	}
 
 	// Displays detailed information about a book
-	void displayBookInfo(Book book) {
+	void displayBookInfo(const Book& book) {
 		std::cout << "Book info: " << std::endl;
 		std::cout << "Title: " << book.title << std::endl;
 		std::cout << "Author: " << book.author << std::endl;
@@ -378,15 +2186,13 @@ public:
 	*/
 	// Shows all books in the library
 	void showAllBooks() {
-		// Get all table values from the book map, which will be book objects
+		// Get all table values from the book map, which will be book objects already sorted by title
 		std::vector<Book> allBooks = getAllBooks();
 		// If there are no book objects in the vector
 		if (allBooks.size() == 0) {
 			std::cout << "Book Library: Library is empty!" << std::endl;
 			return;
 		}
-		// Sort it since it has elements
-		mergeSort(allBooks);
 		// Show output by showing all books
 		std::cout << "Book Library All Books: " << std::endl;
 		for (size_t i = 0; i < allBooks.size(); i++) {
@@ -401,28 +2207,450 @@ public:
 			std::cout << "Book Library: There are no issued book records to be shown!" << std::endl;
 			return;
 		}
-		mergeSort(issuedBookList);
+		sortIssuedBookList();
 		std::cout << "Book Library: Issued Book Record: " << std::endl;
 		for (size_t i = 0; i < issuedBookList.size(); i++) {
-			std::cout << i + 1 << ". " << issuedBookList[i] << std::endl;
+			std::cout << i + 1 << ". " << makeIssuedEntry(issuedBookList[i]) << std::endl;
 		}
 		std::cout << "Book Library: End Record!" << std::endl;
 	}
 
-	// Sorts and shows all registered students
+	// Shows all registered students
 	void showAllStudents() {
 		if (libraryStudents.size() == 0) {
 			std::cout << "Book Library: No students in library that can be shown!" << std::endl;
 			return;
 		}
-		mergeSort(libraryStudents);
-		for (int i = 0; i < libraryStudents.size(); i++) {
+		// Students are kept sorted by name as they're added, so there's no need to sort here
+		for (size_t i = 0; i < libraryStudents.size(); i++) {
 			std::cout << i + 1 << ". " << libraryStudents[i] << std::endl;
 		}
 	}
 
+	/*
+	+ Paged and top-K listings: rather than copying and sorting everything, these only keep as many items as the page
+	needs. The hash table has no order, so a page of books still looks at every book, but it only holds pointers to the
+	(offset + limit) books that come first in a heap, and only copies the ones on the page; getBooksAfter keeps just
+	limit of them no matter how deep into the listing it is. Students are already kept in order so their pages cost only
+	the size of the page.
+	*/
+	// Returns up to limit books, in title order, starting at position offset in that order
+	std::vector<Book> getBooksPage(int offset, int limit) {
+		finishLoadingBooks();
+		std::vector<Book> page;
+		if (offset < 0 || limit <= 0) {
+			return page;
+		}
+		auto selector = makeTopKSelector<Book*>(offset + limit, [](Book* first, Book* second) { return *first < *second; });
+		bookMap.forEachValue([&selector](Book& book) { selector.push(&book); });
+		std::vector<Book*> firstBooks = selector.takeSorted();
+		for (size_t i = offset; i < firstBooks.size(); i++) {
+			page.push_back(*firstBooks[i]);
+		}
+		return page;
+	}
+
+	// Returns up to limit books, in title order, whose titles come after lastTitle. Pass the title of the last book on
+	// a page to get the next page; unlike getBooksPage the cost doesn't grow the deeper you go.
+	std::vector<Book> getBooksAfter(const std::string& lastTitle, int limit) {
+		finishLoadingBooks();
+		std::vector<Book> page;
+		if (limit <= 0) {
+			return page;
+		}
+		auto selector = makeTopKSelector<Book*>(limit, [](Book* first, Book* second) { return *first < *second; });
+		bookMap.forEachValue([&selector, &lastTitle](Book& book) {
+			if (book.title > lastTitle) {
+				selector.push(&book);
+			}
+		});
+		std::vector<Book*> nextBooks = selector.takeSorted();
+		for (size_t i = 0; i < nextBooks.size(); i++) {
+			page.push_back(*nextBooks[i]);
+		}
+		return page;
+	}
+
+	// Returns the k books with the most pages, longest first; books with the same number of pages are in title order
+	std::vector<Book> getLongestBooks(int k) {
+		finishLoadingBooks();
+		std::vector<Book> longestBooks;
+		if (k <= 0) {
+			return longestBooks;
+		}
+		auto selector = makeTopKSelector<Book*>(k, [](Book* first, Book* second) {
+			if (first->numPages != second->numPages) {
+				return first->numPages > second->numPages;
+			}
+			return *first < *second;
+		});
+		bookMap.forEachValue([&selector](Book& book) { selector.push(&book); });
+		std::vector<Book*> selected = selector.takeSorted();
+		for (size_t i = 0; i < selected.size(); i++) {
+			longestBooks.push_back(*selected[i]);
+		}
+		return longestBooks;
+	}
+
+	// Returns up to limit students, in name order, starting at position offset in that order
+	std::vector<Student> getStudentsPage(int offset, int limit) {
+		std::vector<Student> page;
+		for (int i = offset; i >= 0 && i < offset + limit && i < static_cast<int>(libraryStudents.size()); i++) {
+			page.push_back(libraryStudents[i]);
+		}
+		return page;
+	}
+
+	// Returns up to limit issued book entries, in title order, starting at position offset in that order
+	std::vector<issuedBookEntry> getIssuedEntriesPage(int offset, int limit) {
+		std::vector<issuedBookEntry> page;
+		if (offset < 0 || limit <= 0) {
+			return page;
+		}
+		auto selector = makeTopKSelector<LibraryLoan*>(offset + limit, [this](LibraryLoan* first, LibraryLoan* second) {
+			return *booksByID[first->bookID] < *booksByID[second->bookID];
+		});
+		for (size_t i = 0; i < issuedBookList.size(); i++) {
+			selector.push(&issuedBookList[i]);
+		}
+		std::vector<LibraryLoan*> firstLoans = selector.takeSorted();
+		for (size_t i = offset; i < firstLoans.size(); i++) {
+			page.push_back(makeIssuedEntry(*firstLoans[i]));
+		}
+		return page;
+	}
+
+	// Returns the IDs of the books that match a query, by combining the secondary indexes with bitmap operations
+	RoaringBitmap findBookIDs(BookQuery query) {
+		finishLoadingBooks();
+		// Without a page filter there's nothing to combine
+		if (query.minPages <= 0 && query.maxPages == INT_MAX) {
+			return query.onlyAvailable ? availableBooks : allBookIDs;
+		}
+		// OR together the sets for every page count in the range, then AND with the available books if asked
+		RoaringBitmap matches;
+		if (query.minPages > query.maxPages) {
+			return matches;
+		}
+		std::map<int, RoaringBitmap>::iterator current = booksByPages.lower_bound(query.minPages);
+		std::map<int, RoaringBitmap>::iterator end = booksByPages.upper_bound(query.maxPages);
+		for (; current != end; current++) {
+			matches.orInPlace(current->second);
+		}
+		if (query.onlyAvailable) {
+			matches = RoaringBitmap::intersect(matches, availableBooks);
+		}
+		return matches;
+	}
+
+	// Returns the number of books that match a query, without copying any of them
+	long long countBooks(BookQuery query) {
+		finishLoadingBooks();
+		if (query.minPages <= 0 && query.maxPages == INT_MAX) {
+			return query.onlyAvailable ? availableBooks.cardinality() : allBookIDs.cardinality();
+		}
+		if (query.minPages > query.maxPages) {
+			return 0;
+		}
+		// Every book has one page count, so the sets for the page counts in the range don't overlap and their sizes
+		// add up
+		long long count = 0;
+		std::map<int, RoaringBitmap>::iterator current = booksByPages.lower_bound(query.minPages);
+		std::map<int, RoaringBitmap>::iterator end = booksByPages.upper_bound(query.maxPages);
+		for (; current != end; current++) {
+			count += query.onlyAvailable ? RoaringBitmap::intersectionCount(current->second, availableBooks) : current->second.cardinality();
+		}
+		return count;
+	}
+
+	// Returns the books that match a query, up to limit of them (or all of them if limit is negative), in ID order
+	std::vector<Book> findBooks(BookQuery query, int limit = -1) {
+		std::vector<Book> results;
+		if (limit == 0) {
+			return results;
+		}
+		findBookIDs(query).forEachWhile([this, &results, limit](uint32_t bookID) {
+			results.push_back(*booksByID[bookID]);
+			return limit < 0 || static_cast<int>(results.size()) < limit;
+		});
+		return results;
+	}
+
+	// Shows one page of books, numbered by their position in the whole listing
+	void showBooksPage(int offset, int limit) {
+		std::vector<Book> page = getBooksPage(offset, limit);
+		if (page.size() == 0) {
+			std::cout << "Book Library: No books to show on this page!" << std::endl;
+			return;
+		}
+		std::cout << "Book Library Books " << offset + 1 << " to " << offset + page.size() << " of " << bookMap.getNumPairs() << ": " << std::endl;
+		for (size_t i = 0; i < page.size(); i++) {
+			std::cout << offset + i + 1 << ". " << page[i] << std::endl;
+		}
+	}
+
+	// Shows one page of students, numbered by their position in the whole listing
+	void showStudentsPage(int offset, int limit) {
+		std::vector<Student> page = getStudentsPage(offset, limit);
+		std::cout << "Book Library Students " << offset + 1 << " to " << offset + page.size() << " of " << libraryStudents.size() << ": " << std::endl;
+		for (size_t i = 0; i < page.size(); i++) {
+			std::cout << offset + i + 1 << ". " << page[i] << std::endl;
+		}
+	}
+
+	// Shows one page of the issued book record, numbered by their position in the whole record
+	void showIssuedEntriesPage(int offset, int limit) {
+		std::vector<issuedBookEntry> page = getIssuedEntriesPage(offset, limit);
+		std::cout << "Book Library: Issued Book Record " << offset + 1 << " to " << offset + page.size() << " of " << issuedBookList.size() << ": " << std::endl;
+		for (size_t i = 0; i < page.size(); i++) {
+			std::cout << offset + i + 1 << ". " << page[i] << std::endl;
+		}
+	}
+
+	// Shows the students a page at a time and has the user pick one by their number; entering 0 shows the next page.
+	// Returns the index of the chosen student in libraryStudents, so there has to be at least one student.
+	int promptSelectStudent(std::string promptText) {
+		int studentChoice = 0;
+		int offset = 0;
+		while (studentChoice == 0) {
+			showStudentsPage(offset, listingPageSize);
+			std::cout << promptText << " (0 for the next page): ";
+			std::cin >> studentChoice;
+			studentChoice = validateMenuInput(studentChoice, 0, libraryStudents.size());
+			offset += listingPageSize;
+			if (offset >= static_cast<int>(libraryStudents.size())) {
+				offset = 0;
+			}
+		}
+		return studentChoice - 1;
+	}
+
+	// Shows the issued book record a page at a time and has the user pick an entry by its number; entering 0 shows the
+	// next page. Returns a copy of the chosen entry, so there has to be at least one.
+	issuedBookEntry promptSelectIssuedEntry() {
+		int issueBookChoice = 0;
+		int offset = 0;
+		while (issueBookChoice == 0) {
+			showIssuedEntriesPage(offset, listingPageSize);
+			std::cout << "Enter the number corresponding to the entry (0 for the next page): ";
+			std::cin >> issueBookChoice;
+			issueBookChoice = validateMenuInput(issueBookChoice, 0, issuedBookList.size());
+			offset += listingPageSize;
+			if (offset >= static_cast<int>(issuedBookList.size())) {
+				offset = 0;
+			}
+		}
+		return getIssuedEntriesPage(issueBookChoice - 1, 1)[0];
+	}
+
+	// Returns the stats of the library's hash table, along with how long lookups walk its chains when metrics are compiled in
+	HashTableStats getBookMapStats() {
+		finishLoadingBooks();
+		return bookMap.getStats();
+	}
+
+	// Turns the Bloom filters in front of the title, ISBN and student ID lookups on (building them from what's in the
+	// library now) or off
+	void enableBloomFilters(bool enabled) {
+		useBloomFilters = enabled;
+		if (enabled) {
+			rebuildTitleFilter();
+			rebuildISBNFilter();
+			rebuildStudentIDFilter();
+		}
+	}
+
+	// Turns the hot title cache on or off; either way it starts out empty
+	void enableTitleCache(bool enabled) {
+		useTitleCache = enabled;
+		titleCache.clear();
+	}
+
+	CacheStats getTitleCacheStats() {
+		return titleCache.getStats();
+	}
+
+	// Turns snapshots on or off. Turning them on publishes every book and loan to the versioned view, and from then on
+	// each change to a book or loan also makes a new immutable copy of it, which is what lets takeSnapshot be O(1).
+	void enableSnapshots(bool enabled) {
+		finishLoadingBooks();
+		useSnapshots = enabled;
+		liveView = LibrarySnapshot();
+		if (!enabled) {
+			return;
+		}
+		for (size_t i = 0; i < booksByID.size(); i++) {
+			if (booksByID[i] != nullptr) {
+				publishBook(static_cast<int>(i));
+			}
+		}
+		for (size_t i = 0; i < issuedBookList.size(); i++) {
+			publishLoan(issuedBookList[i].loanID);
+		}
+	}
+
+	bool isSnapshotting() {
+		return useSnapshots;
+	}
+
+	/*
+	+ Takes a consistent view of the books, loans and students as they are right now (see LibrarySnapshot). With
+	snapshots on it's O(1), apart from copying the student list if it changed since the last snapshot; with them off
+	it turns them on first, which publishes everything once.
+
+	+ NOTE: Take the snapshot while nothing else is using the library (e.g. as a task on a federation branch); after
+	that it can be read from any thread for as long as it's needed.
+	*/
+	LibrarySnapshot takeSnapshot() {
+		finishLoadingBooks();
+		if (!useSnapshots) {
+			enableSnapshots(true);
+		}
+		if (!liveView.students) {
+			liveView.students = std::make_shared<const std::vector<Student>>(libraryStudents);
+		}
+		liveView.numBooks = bookMap.getNumPairs();
+		liveView.numLoans = static_cast<int>(issuedBookList.size());
+		return liveView;
+	}
+
+	// Stats for the title, ISBN and student ID filters, in that order; empty if the filters are off
+	std::vector<BloomFilterStats> getBloomFilterStats() {
+		if (!useBloomFilters) {
+			return std::vector<BloomFilterStats>();
+		}
+		return { titleFilter.getStats(), isbnFilter.getStats(), studentIDFilter.getStats() };
+	}
+
+	// Writes the library's metrics to an output stream, either as JSON or in the Prometheus text format.
+	// Without BOOKLIBRARY_METRICS only the hash table occupancy is available.
+	void writeStats(std::ostream& os, bool prometheusFormat) {
+		const LibraryMetrics* libraryMetrics = nullptr;
+#ifdef BOOKLIBRARY_METRICS
+		libraryMetrics = &metrics;
+#endif
+		std::vector<std::string> tableNames = { "bookMap", "isbnIndex" };
+		std::vector<HashTableStats> tableStats = { bookMap.getStats(), isbnIndex.getStats() };
+		std::vector<std::string> filterNames;
+		std::vector<BloomFilterStats> filterStats;
+		if (useBloomFilters) {
+			filterNames = { "title", "isbn", "studentID" };
+			filterStats = getBloomFilterStats();
+		}
+		CacheStats cacheStats = titleCache.getStats();
+		const CacheStats* titleCacheStats = useTitleCache ? &cacheStats : nullptr;
+		if (prometheusFormat) {
+			writeMetricsPrometheus(os, libraryMetrics, tableNames, tableStats, filterNames, filterStats, titleCacheStats);
+		} else {
+			writeMetricsJSON(os, libraryMetrics, tableNames, tableStats, filterNames, filterStats, titleCacheStats);
+		}
+	}
+
+	// Shows a summary of the library's metrics, then lets the user save all of them to a file
+	void promptShowStats() {
+		HashTableStats stats = bookMap.getStats();
+		std::cout << "Book Library Stats: " << std::endl;
+		std::cout << "Books: " << stats.numPairs << ", Students: " << libraryStudents.size() << ", Issued: " << issuedBookList.size()
+			<< " (" << getNumOverdueLoans() << " overdue), Holds: " << holdQueues.getNumHolds() << std::endl;
+		std::cout << "Book table: " << stats.numBuckets << " buckets, " << stats.emptyBuckets << " empty, longest chain "
+			<< stats.longestChain << ", resized " << stats.resizes << " times" << std::endl;
+		if (useTitleCache) {
+			CacheStats cacheStats = titleCache.getStats();
+			std::cout << "Title cache: " << cacheStats.entries << " of " << cacheStats.capacity << " entries used, hit rate " << cacheStats.hitRate
+				<< " (" << cacheStats.hits << " hits, " << cacheStats.misses << " misses), " << cacheStats.evictions << " evictions" << std::endl;
+		}
+		std::vector<BloomFilterStats> filterStats = getBloomFilterStats();
+		const char* const filterNames[3] = { "Title", "ISBN", "Student ID" };
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			std::cout << filterNames[i] << " filter: " << filterStats[i].negatives << " of " << filterStats[i].queries
+				<< " lookups answered by the filter, false positive rate " << filterStats[i].observedFalsePositiveRate
+				<< " (expected " << filterStats[i].estimatedFalsePositiveRate << "), rebuilt " << filterStats[i].rebuilds << " times" << std::endl;
+		}
+#ifdef BOOKLIBRARY_METRICS
+		std::cout << "Lookups: " << stats.lookups << ", nodes walked per lookup: mean " << stats.meanChainWalk
+			<< ", p99 " << stats.p99ChainWalk << ", max " << stats.maxChainWalk << std::endl;
+		for (int i = 0; i < NUM_LIBRARY_OPERATIONS; i++) {
+			const LatencyHistogram& latency = metrics.getOperationLatency(static_cast<LibraryOperation>(i));
+			std::cout << libraryOperationNames[i] << ": " << latency.getTotalCount() << " calls, p50 " << latency.valueAtPercentile(50)
+				<< " ns, p99 " << latency.valueAtPercentile(99) << " ns, max " << latency.getMax() << " ns" << std::endl;
+		}
+#else
+		std::cout << "Book Library: Operation timings aren't available since this build doesn't have BOOKLIBRARY_METRICS defined." << std::endl;
+#endif
+		// Prompt whether they want to save the stats; 1 for JSON, 2 for Prometheus text, 3 to go back
+		int formatChoice;
+		std::cout << "Save stats to a file? 1. JSON, 2. Prometheus text, 3. Don't save: ";
+		std::cin >> formatChoice;
+		formatChoice = validateMenuInput(formatChoice, 1, 3);
+		if (formatChoice == 3) {
+			return;
+		}
+		std::string fileName;
+		std::cout << "Enter file name: ";
+		std::getline(std::cin, fileName);
+		std::ofstream statsFile(fileName);
+		if (!statsFile) {
+			std::cout << "Book Library: Could not open '" << fileName << "' to save the stats!" << std::endl;
+			return;
+		}
+		writeStats(statsFile, formatChoice == 2);
+		std::cout << "Book Library: Saved stats to '" << fileName << "'!" << std::endl;
+	}
+
+	// Prompts for what to export, the format and the file name, and exports it
+	void promptExportData() {
+		int dataChoice;
+		std::cout << "Export what? 1. Books, 2. Students, 3. Loans, 4. Go back: ";
+		std::cin >> dataChoice;
+		dataChoice = validateMenuInput(dataChoice, 1, 4);
+		if (dataChoice == 4) {
+			return;
+		}
+		int formatChoice;
+		std::cout << "Format? 1. CSV, 2. JSON Lines: ";
+		std::cin >> formatChoice;
+		formatChoice = validateMenuInput(formatChoice, 1, 2);
+		ExportFormat format = formatChoice == 1 ? EXPORT_CSV : EXPORT_JSON_LINES;
+		std::string fileName;
+		std::cout << "Enter file name: ";
+		std::getline(std::cin, fileName);
+		if (dataChoice == 1) {
+			exportBooks(fileName, format);
+		} else if (dataChoice == 2) {
+			exportStudents(fileName, format);
+		} else {
+			exportLoans(fileName, format);
+		}
+	}
+
+	// Prompts for a fresh book data file and syncs the books with it, then lists what changed
+	void promptSyncBooks() {
+		std::string fileName;
+		std::cout << "Enter the book data file to sync with: ";
+		std::getline(std::cin, fileName);
+		SyncReport report = syncBooks(fileName, ',');
+		for (size_t i = 0; i < report.changes.size(); i++) {
+			const CatalogChange& change = report.changes[i];
+			std::cout << "  " << catalogChangeNames[change.type] << ": ";
+			if (change.title.empty()) {
+				std::cout << change.reason;
+			} else {
+				std::cout << "'" << change.title << "' (ISBN " << change.ISBN << ")";
+				if (!change.reason.empty()) {
+					std::cout << ", since " << change.reason;
+				}
+			}
+			std::cout << std::endl;
+		}
+	}
+
 	// Sees if student is already registered into the library by seeing if an given student id matches any of the student id in the students list
-	bool isExistingStudent(std::string studentID) {
+	bool isExistingStudent(const std::string& studentID) {
+		LIBRARY_TIME_OPERATION(metrics, OP_FIND_STUDENT);
+		TracedOperation traced(traceWriter.get(), TRACE_FIND_STUDENT, clock, studentID);
+		if (useBloomFilters && !studentIDFilter.mightContain(FNV1aHash::hash(studentID))) {
+			return false;
+		}
 		bool found = false;
 		for (int i = 0; i < libraryStudents.size(); i++) {
 			if (libraryStudents[i].getStudentID() == studentID) {
@@ -430,25 +2658,38 @@ public:
 				break;
 			}
 		}
+		if (!found && useBloomFilters) {
+			studentIDFilter.recordFalsePositive();
+			if (studentIDFilter.isDegraded()) {
+				rebuildStudentIDFilter();
+			}
+		}
+		traced.succeeded(found);
 		return found;
 	}
 
 
 	// Sorts and Returns issuedBooklist
 	std::vector<issuedBookEntry> getAllIssuedBookEntries() {
-		mergeSort(issuedBookList);
-		return issuedBookList;
+		sortIssuedBookList();
+		std::vector<issuedBookEntry> allEntries;
+		allEntries.reserve(issuedBookList.size());
+		for (size_t i = 0; i < issuedBookList.size(); i++) {
+			allEntries.push_back(makeIssuedEntry(issuedBookList[i]));
+		}
+		return allEntries;
 	}
 
 	// Returns an array of books that are stored in the library's hash table
 	std::vector<Book> getAllBooks() {
+		finishLoadingBooks();
 		std::vector<Book> allBooks = bookMap.getAllTableValues();
-		return mergeSort(allBooks, true);
+		mergeSortInPlace(allBooks, true);
+		return allBooks;
 	}
 
-	// Sorts and returns the array of students registered with the library instance
+	// Returns the array of students registered with the library instance, which is always sorted by name
 	std::vector<Student> getLibraryStudents() {
-		mergeSort(libraryStudents);
 		return libraryStudents;
 	}
 
@@ -456,14 +2697,6 @@ public:
 	// and using student objects, it's probably going to be a function outside of the 
 	// confines of this class definition. Next thing is setting up menu list structure
 	// and then the idea of issuing and returning books then
-
-	// editBook; be careful if they decide to edit the title, which is our key
-	// if that's the case then we'd delete the old key-value pair, and then add the new value.
-	// Else if it's like the book's information we can just update the pair like normal
-	// Assume that they're going to get a screen 
-
-	// Then we'd have our functions for prompting input 
-	// Like function for editing, or prompt add book
 };
 
 
@@ -0,0 +1,1197 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <map>
+#include "BookLibrary.h"
+#include "LibraryFederation.h"
+#include "FixedHashTable.h"
+#include "utilities.h"
+#include "dataLoader.h"
+
+/*
++ Microbenchmarks for the data structures and algorithms that the book library is built on. Each
+benchmark times a batch of operations and reports the average nanoseconds per operation. Results are
+written as JSON (one result object per line) so that they can be saved as a baseline and compared
+against later runs.
+
++ Each benchmark is run once to warm up (caches, the allocator, the CPU's clock), which isn't recorded, and then
+--repeats more times. A result is the median of those runs, along with their spread: the gap between the slowest and
+the fastest run, as a fraction of the median. When comparing against a baseline, a benchmark only counts as a
+regression if it got slower by more than the threshold and by more than the two runs' spreads added together, so a
+benchmark that's noisy on this machine needs a bigger change to be flagged.
+
++ Usage:
+	BookLibraryBenchmark [--quick] [--json <outputFile>] [--baseline <baselineFile>] [--threshold <ratio>] [--repeats N]
+
+	--quick      Use smaller sizes, for a fast sanity check
+	--json       Write the results to a file rather than to the console
+	--baseline   Compare against results from an earlier run; a benchmark that got slower by more than
+	             the threshold (default 0.10, which is 10%) and its spread counts as a regression, and the program
+	             exits with 1
+	--repeats    Runs of each benchmark after the warm-up run (default 5, or 3 with --quick)
+*/
+
+// Result of a single benchmark
+struct BenchmarkResult {
+	std::string name; // unique name of the benchmark, including its parameters
+	long long iterations; // number of operations that were timed
+	double nsPerOp; // average nanoseconds per operation
+	double allocsPerOp; // average heap allocations per operation
+	double spread; // (slowest - fastest) / median over the repeated runs; 0 for a single run
+};
+
+// Anything the benchmarks compute gets added into this, so the compiler can't throw the work away
+volatile long long benchmarkSink = 0;
+
+std::vector<BenchmarkResult> benchmarkResults;
+
+// Every run of the benchmark that's running now, by result name, and the names in the order they were first recorded
+std::map<std::string, std::vector<BenchmarkResult>> benchmarkRuns;
+std::vector<std::string> benchmarkRunNames;
+bool isWarmUp = false;
+int benchmarkRepeats = 5;
+
+// Every call to the global operator new in this program is counted, so each benchmark can report how many heap
+// allocations its operations make (copies of strings, Books and Students all show up here)
+std::atomic<long long> heapAllocations(0);
+long long allocationsAtStart = 0;
+
+void* operator new(std::size_t size) {
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+// Not inlined, so the compiler doesn't mistake these for a free() of memory that came from new
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+// Starts timing a batch of operations, and starts counting their allocations
+std::chrono::steady_clock::time_point startBenchmark() {
+	allocationsAtStart = heapAllocations.load(std::memory_order_relaxed);
+	return std::chrono::steady_clock::now();
+}
+
+// Records one run's result given the total elapsed time of a batch of operations started with startBenchmark(); the
+// warm-up run's results are thrown away
+void recordResult(std::string name, long long iterations, std::chrono::steady_clock::duration elapsed) {
+	long long allocations = heapAllocations.load(std::memory_order_relaxed) - allocationsAtStart;
+	double totalNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	BenchmarkResult result = { name, iterations, iterations > 0 ? totalNs / iterations : 0.0,
+		iterations > 0 ? static_cast<double>(allocations) / iterations : 0.0, 0.0 };
+	if (isWarmUp) {
+		return;
+	}
+	if (benchmarkRuns.find(name) == benchmarkRuns.end()) {
+		benchmarkRunNames.push_back(name);
+	}
+	benchmarkRuns[name].push_back(result);
+}
+
+// Median of some values (the mean of the middle two for an even count)
+double medianOf(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+// Runs a benchmark once to warm up and then benchmarkRepeats times, and records the median of each of its results
+template <class Benchmark>
+void runBenchmark(Benchmark benchmark) {
+	isWarmUp = true;
+	benchmark();
+	isWarmUp = false;
+	for (int run = 0; run < benchmarkRepeats; run++) {
+		benchmark();
+	}
+	for (size_t i = 0; i < benchmarkRunNames.size(); i++) {
+		const std::vector<BenchmarkResult>& runs = benchmarkRuns[benchmarkRunNames[i]];
+		std::vector<double> nsPerOp;
+		std::vector<double> allocsPerOp;
+		for (size_t run = 0; run < runs.size(); run++) {
+			nsPerOp.push_back(runs[run].nsPerOp);
+			allocsPerOp.push_back(runs[run].allocsPerOp);
+		}
+		BenchmarkResult result = runs[0];
+		result.nsPerOp = medianOf(nsPerOp);
+		result.allocsPerOp = medianOf(allocsPerOp);
+		double fastest = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+		double slowest = *std::max_element(nsPerOp.begin(), nsPerOp.end());
+		result.spread = result.nsPerOp > 0 ? (slowest - fastest) / result.nsPerOp : 0.0;
+		benchmarkResults.push_back(result);
+		std::cerr << result.name << ": " << result.nsPerOp << " ns/op (spread " << result.spread * 100 << "% over " << runs.size()
+			<< " runs), " << result.allocsPerOp << " allocs/op (" << result.iterations << " ops)" << std::endl;
+	}
+	benchmarkRuns.clear();
+	benchmarkRunNames.clear();
+}
+
+// Makes a title that's unique for each index; titles share a prefix like they tend to in a real catalog
+std::string makeTitle(int index) {
+	return "The Collected Works Volume " + std::to_string(index);
+}
+
+// Makes a book with a unique title and ISBN for each index
+Book makeBook(int index) {
+	Book newBook = { makeTitle(index), "Author " + std::to_string(index % 997), std::to_string(9780000000000LL + index), 100 + (index * 37) % 900 };
+	return newBook;
+}
+
+// Makes a student with a unique 8 digit ID for each index
+Student makeStudent(int index) {
+	return Student("First" + std::to_string((index * 7919) % 10007), "Last" + std::to_string(index), std::to_string(10000000 + index));
+}
+
+// HashTable insert, lookup hit, lookup miss and delete at the given size and load factor
+void benchmarkHashTable(int numPairs, int loadFactor) {
+	int numBuckets = numPairs / loadFactor;
+	if (numBuckets < 1) {
+		numBuckets = 1;
+	}
+	std::string suffix = "/n=" + std::to_string(numPairs) + "/load=" + std::to_string(loadFactor);
+	// Build the keys up front so we're only timing the hash table
+	std::vector<std::string> keys;
+	std::vector<std::string> missingKeys;
+	for (int i = 0; i < numPairs; i++) {
+		keys.push_back(lowerCaseString(makeTitle(i)));
+		missingKeys.push_back(lowerCaseString(makeTitle(numPairs + i)));
+	}
+	HashTable<Book> table(numBuckets);
+	Book value = makeBook(0);
+
+	auto start = startBenchmark();
+	for (int i = 0; i < numPairs; i++) {
+		benchmarkSink += table.insertPair(keys[i], value);
+	}
+	recordResult("HashTable.insertPair" + suffix, numPairs, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int i = 0; i < numPairs; i++) {
+		benchmarkSink += table.getValue(keys[i]).numPages;
+	}
+	recordResult("HashTable.getValue.hit" + suffix, numPairs, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int i = 0; i < numPairs; i++) {
+		benchmarkSink += table.getValue(missingKeys[i]).numPages;
+	}
+	recordResult("HashTable.getValue.miss" + suffix, numPairs, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int i = 0; i < numPairs; i++) {
+		benchmarkSink += table.deletePair(keys[i]);
+	}
+	recordResult("HashTable.deletePair" + suffix, numPairs, std::chrono::steady_clock::now() - start);
+}
+
+// Insert, lookup hit and lookup miss on one table configuration; the table starts small so inserts include growing
+template <class Table, class Key>
+void benchmarkTableConfiguration(Table& table, std::string name, const std::vector<Key>& keys, const std::vector<Key>& missingKeys) {
+	std::string suffix = "/n=" + std::to_string(keys.size());
+	auto start = startBenchmark();
+	for (size_t i = 0; i < keys.size(); i++) {
+		benchmarkSink += table.insertPair(keys[i], static_cast<int>(i));
+	}
+	recordResult(name + ".insertPair" + suffix, keys.size(), std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (size_t i = 0; i < keys.size(); i++) {
+		benchmarkSink += table.getValue(keys[i]);
+	}
+	recordResult(name + ".getValue.hit" + suffix, keys.size(), std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (size_t i = 0; i < missingKeys.size(); i++) {
+		benchmarkSink += table.getValue(missingKeys[i]);
+	}
+	recordResult(name + ".getValue.miss" + suffix, missingKeys.size(), std::chrono::steady_clock::now() - start);
+}
+
+// The generic HashTable configuration against the compile-time specialized ones, for title keys and for ISBN keys
+// stored as strings or as integers
+void benchmarkHashTableConfigurations(int numPairs) {
+	std::vector<std::string> titles;
+	std::vector<std::string> missingTitles;
+	std::vector<std::string> ISBNs;
+	std::vector<std::string> missingISBNs;
+	std::vector<long long> ISBNNumbers;
+	std::vector<long long> missingISBNNumbers;
+	for (int i = 0; i < numPairs; i++) {
+		titles.push_back(lowerCaseString(makeTitle(i)));
+		missingTitles.push_back(lowerCaseString(makeTitle(numPairs + i)));
+		ISBNNumbers.push_back(9780000000000LL + i);
+		missingISBNNumbers.push_back(9780000000000LL + numPairs + i);
+		ISBNs.push_back(std::to_string(ISBNNumbers.back()));
+		missingISBNs.push_back(std::to_string(missingISBNNumbers.back()));
+	}
+
+	HashTable<int> sumPrimeTitles;
+	benchmarkTableConfiguration(sumPrimeTitles, "HashTableConfig.title.sumOfChars.prime", titles, missingTitles);
+	HashTable<int, std::string, FNV1aHash, PrimeBucketCount> fnvPrimeTitles;
+	benchmarkTableConfiguration(fnvPrimeTitles, "HashTableConfig.title.fnv1a.prime", titles, missingTitles);
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> fnvMaskTitles;
+	benchmarkTableConfiguration(fnvMaskTitles, "HashTableConfig.title.fnv1a.powerOfTwo", titles, missingTitles);
+
+	HashTable<int> sumPrimeISBNs;
+	benchmarkTableConfiguration(sumPrimeISBNs, "HashTableConfig.isbn.string.sumOfChars.prime", ISBNs, missingISBNs);
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> fnvMaskISBNs;
+	benchmarkTableConfiguration(fnvMaskISBNs, "HashTableConfig.isbn.string.fnv1a.powerOfTwo", ISBNs, missingISBNs);
+	HashTable<int, long long, IntegerHash, PowerOfTwoBucketCount> integerMaskISBNs;
+	benchmarkTableConfiguration(integerMaskISBNs, "HashTableConfig.isbn.integer.powerOfTwo", ISBNNumbers, missingISBNNumbers);
+	// The fixed table is too big for the stack, but it doesn't allocate anything itself
+	if (numPairs <= 65536) {
+		std::unique_ptr<FixedHashTable<int, long long, 131072>> fixedISBNs(new FixedHashTable<int, long long, 131072>());
+		benchmarkTableConfiguration(*fixedISBNs, "HashTableConfig.isbn.integer.fixed131072", ISBNNumbers, missingISBNNumbers);
+	}
+}
+
+// Walking a single chain, both by searching for the last key and by collecting every value
+void benchmarkLinkedList(int length, int repetitions) {
+	std::string suffix = "/n=" + std::to_string(length);
+	HTLinkedList<std::string, Book> list;
+	for (int i = 0; i < length; i++) {
+		list.insertLast(makeTitle(i), makeBook(i));
+	}
+	std::string lastKey = makeTitle(length - 1);
+
+	auto start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += list.searchNode(lastKey)->info.numPages;
+	}
+	recordResult("HTLinkedList.searchNode.last" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += list.getAllNodeValues().size();
+	}
+	recordResult("HTLinkedList.getAllNodeValues" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+	list.destroyList();
+}
+
+// Sorting books, students and plain integers with our merge sort; the inputs are shuffled the same way every run
+void benchmarkMergeSort(int numItems) {
+	std::string suffix = "/n=" + std::to_string(numItems);
+	std::vector<int> numbers;
+	std::vector<Book> books;
+	std::vector<Student> students;
+	for (int i = 0; i < numItems; i++) {
+		int shuffled = static_cast<int>((static_cast<long long>(i) * 7919) % numItems);
+		numbers.push_back(shuffled);
+		books.push_back(makeBook(shuffled));
+		students.push_back(makeStudent(shuffled));
+	}
+
+	auto start = startBenchmark();
+	mergeSortInPlace(numbers);
+	benchmarkSink += numbers.size();
+	recordResult("mergeSort.int" + suffix, numItems, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	mergeSortInPlace(books);
+	benchmarkSink += books.size();
+	recordResult("mergeSort.Book" + suffix, numItems, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	mergeSortInPlace(students);
+	benchmarkSink += students.size();
+	recordResult("mergeSort.Student" + suffix, numItems, std::chrono::steady_clock::now() - start);
+}
+
+// The string helpers that run on every lookup and every line of a data file
+void benchmarkStringUtilities(int repetitions) {
+	std::string title = "The Hitchhiker's Guide To The Galaxy";
+	std::string line = "The Hitchhiker's Guide To The Galaxy,Douglas Adams,9780345391803,224";
+
+	auto start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += lowerCaseString(title).length();
+	}
+	recordResult("lowerCaseString", repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += splitLine(line, ',').size();
+	}
+	recordResult("splitLine", repetitions, std::chrono::steady_clock::now() - start);
+}
+
+// Look up, issue and return a book, the way the desk does it, against a library of the given size
+void benchmarkIssueReturn(int numBooks, int numStudents, int numCycles) {
+	std::string suffix = "/books=" + std::to_string(numBooks) + "/students=" + std::to_string(numStudents);
+	BookLibrary library;
+	library.setVerbose(false);
+	std::vector<Student> students;
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+	}
+	for (int i = 0; i < numStudents; i++) {
+		Student newStudent = makeStudent(i);
+		library.addStudent(newStudent.getFirstName(), newStudent.getLastName(), newStudent.getStudentID());
+		students.push_back(newStudent);
+	}
+
+	auto start = startBenchmark();
+	for (int i = 0; i < numCycles; i++) {
+		std::string title = makeTitle((i * 31) % numBooks);
+		Student student = students[i % numStudents];
+		Book targetBook = library.getBook(title);
+		library.issueBook(targetBook, student);
+		library.returnBook(targetBook, student);
+	}
+	recordResult("BookLibrary.issueReturnCycle" + suffix, numCycles, std::chrono::steady_clock::now() - start);
+}
+
+// Full sorted listing against a single page and a top-K query, for a library of the given size
+void benchmarkListings(int numBooks, int repetitions) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	BookLibrary library;
+	library.setVerbose(false);
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+	}
+
+	auto start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += library.getAllBooks().size();
+	}
+	recordResult("BookLibrary.getAllBooks" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += library.getBooksPage(0, 20).size();
+	}
+	recordResult("BookLibrary.getBooksPage.first20" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += library.getBooksAfter(makeTitle(numBooks / 2), 20).size();
+	}
+	recordResult("BookLibrary.getBooksAfter.20" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += library.getLongestBooks(20).size();
+	}
+	recordResult("BookLibrary.getLongestBooks.20" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+}
+
+// Filtered listings ("available books with 100 to 300 pages") through the secondary indexes, against scanning every book
+void benchmarkFilteredQueries(int numBooks, int repetitions) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	BookLibrary library;
+	library.setVerbose(false);
+	std::vector<Student> students = { makeStudent(0) };
+	library.addStudent(students[0].getFirstName(), students[0].getLastName(), students[0].getStudentID());
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+	}
+	// Check out every tenth book so the availability filter has something to do
+	for (int i = 0; i < numBooks; i += 10) {
+		library.issueBook(library.getBook(makeTitle(i)), students[0]);
+	}
+	BookQuery query;
+	query.minPages = 100;
+	query.maxPages = 300;
+	query.onlyAvailable = true;
+
+	auto start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		long long matches = 0;
+		std::vector<Book> allBooks = library.getAllBooks();
+		for (size_t i = 0; i < allBooks.size(); i++) {
+			if (allBooks[i].isAvailable && allBooks[i].numPages >= query.minPages && allBooks[i].numPages <= query.maxPages) {
+				matches += 1;
+			}
+		}
+		benchmarkSink += matches;
+	}
+	recordResult("BookLibrary.filter.fullScan" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += library.countBooks(query);
+	}
+	recordResult("BookLibrary.countBooks.availableInPageRange" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += library.findBooks(query, 50).size();
+	}
+	recordResult("BookLibrary.findBooks.availableInPageRange.first50" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+}
+
+// Title lookups in the mutable hash table against the frozen catalog, and how long freezing takes
+void benchmarkFrozenCatalog(int numBooks) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	BookLibrary library;
+	library.setVerbose(false);
+	std::vector<std::string> titles;
+	std::vector<std::string> missingTitles;
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+		titles.push_back(newBook.title);
+		missingTitles.push_back(makeTitle(numBooks + i));
+	}
+	// Look the titles up in random order; in insertion order the hash table's nodes would be next to each other in
+	// memory, which flatters it
+	std::mt19937 generator(12345);
+	std::shuffle(titles.begin(), titles.end(), generator);
+
+	auto start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += library.getBook(titles[i]).numPages;
+	}
+	recordResult("BookLibrary.getBook.hit.mutable" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += library.getBook(missingTitles[i]).numPages;
+	}
+	recordResult("BookLibrary.getBook.miss.mutable" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+	int numThreads = static_cast<int>(std::thread::hardware_concurrency());
+	std::vector<int> threadCounts = { 1 };
+	if (numThreads > 1) {
+		threadCounts.push_back(numThreads);
+	}
+	for (size_t t = 0; t < threadCounts.size(); t++) {
+		start = startBenchmark();
+		double bitsPerKey = library.freezeCatalog(threadCounts[t]);
+		recordResult("BookLibrary.freezeCatalog/threads=" + std::to_string(threadCounts[t]) + suffix, numBooks, std::chrono::steady_clock::now() - start);
+		// Printed once, on the warm-up run
+		if (isWarmUp) std::cerr << "  " << bitsPerKey << " bits per title" << std::endl;
+	}
+
+	start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += library.getBook(titles[i]).numPages;
+	}
+	recordResult("BookLibrary.getBook.hit.frozen" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += library.getBook(missingTitles[i]).numPages;
+	}
+	recordResult("BookLibrary.getBook.miss.frozen" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+}
+
+// Bulk loading and lookups for titles, ISBNs and student IDs that aren't there, with and without the Bloom filters
+void benchmarkBloomFilters(int numBooks, int numStudents) {
+	for (int useFilters = 0; useFilters <= 1; useFilters++) {
+		std::string suffix = std::string(useFilters ? "/bloom" : "/plain") + "/books=" + std::to_string(numBooks);
+		BookLibrary library;
+		library.setVerbose(false);
+		library.enableBloomFilters(useFilters == 1);
+		std::vector<Book> books;
+		for (int i = 0; i < numBooks; i++) {
+			books.push_back(makeBook(i));
+		}
+
+		auto start = startBenchmark();
+		for (int i = 0; i < numBooks; i++) {
+			library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+		}
+		recordResult("BookLibrary.addBook.bulkLoad" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+		std::vector<Book> missingBooks;
+		for (int i = 0; i < numBooks; i++) {
+			missingBooks.push_back(makeBook(numBooks + i));
+		}
+		start = startBenchmark();
+		for (int i = 0; i < numBooks; i++) {
+			benchmarkSink += library.getBook(missingBooks[i].title).numPages;
+		}
+		recordResult("BookLibrary.getBook.miss" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+		start = startBenchmark();
+		for (int i = 0; i < numBooks; i++) {
+			benchmarkSink += library.getBookByISBN(missingBooks[i].ISBN).numPages;
+		}
+		recordResult("BookLibrary.getBookByISBN.miss" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+		std::string studentSuffix = std::string(useFilters ? "/bloom" : "/plain") + "/students=" + std::to_string(numStudents);
+		for (int i = 0; i < numStudents; i++) {
+			Student newStudent = makeStudent(i);
+			library.addStudent(newStudent.getFirstName(), newStudent.getLastName(), newStudent.getStudentID());
+		}
+		start = startBenchmark();
+		for (int i = 0; i < numStudents; i++) {
+			benchmarkSink += library.isExistingStudent(makeStudent(numStudents + i).getStudentID());
+		}
+		recordResult("BookLibrary.isExistingStudent.miss" + studentSuffix, numStudents, std::chrono::steady_clock::now() - start);
+	}
+}
+
+// Lookups that mostly ask for a few hundred hot titles (90% of them, the rest spread over every book), with the hot
+// title cache off and on
+void benchmarkHotTitleCache(int numBooks, int numLookups) {
+	std::mt19937 generator(36);
+	std::vector<std::string> lookupTitles;
+	int numHotTitles = numBooks < 256 ? numBooks : 256;
+	for (int i = 0; i < numLookups; i++) {
+		int bookIndex = generator() % 10 < 9 ? generator() % numHotTitles : generator() % numBooks;
+		lookupTitles.push_back(makeBook(bookIndex).title);
+	}
+	for (int useCache = 0; useCache <= 1; useCache++) {
+		std::string suffix = std::string(useCache ? "/cached" : "/uncached") + "/books=" + std::to_string(numBooks);
+		BookLibrary library;
+		library.setVerbose(false);
+		library.enableTitleCache(useCache == 1);
+		for (int i = 0; i < numBooks; i++) {
+			Book newBook = makeBook(i);
+			library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+		}
+		auto start = startBenchmark();
+		for (int i = 0; i < numLookups; i++) {
+			benchmarkSink += library.getBook(lookupTitles[i]).numPages;
+		}
+		recordResult("BookLibrary.getBook.skewed" + suffix, numLookups, std::chrono::steady_clock::now() - start);
+	}
+}
+
+// Getting a catalog ready to search by building a BookLibrary against mapping a catalog image of the same books, and
+// then title and ISBN lookups against each
+void benchmarkCatalogImage(int numBooks) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	std::vector<Book> books;
+	for (int i = 0; i < numBooks; i++) {
+		books.push_back(makeBook(i));
+	}
+	auto start = startBenchmark();
+	BookLibrary library;
+	library.setVerbose(false);
+	for (int i = 0; i < numBooks; i++) {
+		library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+	}
+	recordResult("BookLibrary.load" + suffix, 1, std::chrono::steady_clock::now() - start);
+
+	std::string imageFileName = "benchmarkCatalog.img";
+	library.exportCatalogImage(imageFileName);
+	start = startBenchmark();
+	CatalogImage image;
+	image.open(imageFileName);
+	recordResult("CatalogImage.open" + suffix, 1, std::chrono::steady_clock::now() - start);
+
+	std::mt19937 generator(37);
+	std::vector<int> order(numBooks);
+	for (int i = 0; i < numBooks; i++) {
+		order[i] = i;
+	}
+	std::shuffle(order.begin(), order.end(), generator);
+	start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += library.getBook(books[order[i]].title).numPages;
+	}
+	recordResult("BookLibrary.getBook" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+	start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += image.getBook(books[order[i]].title).numPages;
+	}
+	recordResult("CatalogImage.getBook" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+	start = startBenchmark();
+	for (int i = 0; i < numBooks; i++) {
+		benchmarkSink += image.getBookByISBN(books[order[i]].ISBN).numPages;
+	}
+	recordResult("CatalogImage.getBookByISBN" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+	image.close();
+	std::remove(imageFileName.c_str());
+}
+
+// Checking for overdue loans once a simulated minute over a day, with loans due throughout the next few weeks: the
+// library's due date wheel against scanning every loan's due time
+void benchmarkDueDates(int numLoans) {
+	std::string suffix = "/loans=" + std::to_string(numLoans);
+	long long now = 1700000000;
+	BookLibrary library;
+	library.setVerbose(false);
+	library.setClock([&now]() { return now; });
+	library.addStudent("Bench", "Student", "00000001");
+	Student student("Bench", "Student", "00000001");
+	std::vector<long long> dueTimes;
+	for (int i = 0; i < numLoans; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+		library.issueBook(newBook, student);
+		dueTimes.push_back(now + 14LL * 24 * 60 * 60);
+		now += 30;
+	}
+	const int numChecks = 24 * 60;
+	long long startTime = now + 14LL * 24 * 60 * 60 - 12LL * 60 * 60;
+	now = startTime;
+	auto start = startBenchmark();
+	for (int i = 0; i < numChecks; i++) {
+		now += 60;
+		benchmarkSink += library.getNumOverdueLoans();
+	}
+	recordResult("BookLibrary.getNumOverdueLoans.wheel" + suffix, numChecks, std::chrono::steady_clock::now() - start);
+	now = startTime;
+	start = startBenchmark();
+	for (int i = 0; i < numChecks; i++) {
+		now += 60;
+		int numOverdue = 0;
+		for (size_t j = 0; j < dueTimes.size(); j++) {
+			numOverdue += dueTimes[j] < now;
+		}
+		benchmarkSink += numOverdue;
+	}
+	recordResult("BookLibrary.getNumOverdueLoans.scan" + suffix, numChecks, std::chrono::steady_clock::now() - start);
+}
+
+// Placing holds on issued books until there are numHolds of them, several per book and per student, and then asking
+// for students' places in line and their lists of holds
+void benchmarkHolds(int numBooks, int numStudents, int numHolds) {
+	std::string suffix = "/holds=" + std::to_string(numHolds);
+	BookLibrary library;
+	library.setVerbose(false);
+	std::vector<Book> books;
+	std::vector<Student> students;
+	for (int i = 0; i < numStudents; i++) {
+		students.push_back(makeStudent(i));
+		library.addStudent(students[i].getFirstName(), students[i].getLastName(), students[i].getStudentID());
+	}
+	for (int i = 0; i < numBooks; i++) {
+		books.push_back(makeBook(i));
+		library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+		library.issueBook(books[i], students[i % numStudents]);
+	}
+	std::mt19937 generator(39);
+	std::vector<std::pair<int, int>> holdPairs; // (book, student)
+	for (int i = 0; i < numHolds; i++) {
+		holdPairs.push_back(std::make_pair(static_cast<int>(generator() % numBooks), static_cast<int>(generator() % numStudents)));
+	}
+	auto start = startBenchmark();
+	for (int i = 0; i < numHolds; i++) {
+		benchmarkSink += library.placeHold(books[holdPairs[i].first], students[holdPairs[i].second]);
+	}
+	recordResult("BookLibrary.placeHold" + suffix, numHolds, std::chrono::steady_clock::now() - start);
+	start = startBenchmark();
+	for (int i = 0; i < numHolds; i++) {
+		benchmarkSink += library.getHoldPosition(books[holdPairs[i].first], students[holdPairs[i].second]);
+	}
+	recordResult("BookLibrary.getHoldPosition" + suffix, numHolds, std::chrono::steady_clock::now() - start);
+	start = startBenchmark();
+	for (int i = 0; i < numStudents; i++) {
+		benchmarkSink += library.getStudentHolds(students[i].getStudentID()).size();
+	}
+	recordResult("BookLibrary.getStudentHolds" + suffix, numStudents, std::chrono::steady_clock::now() - start);
+}
+
+// Checking out and returning stacks of books: one batch call per stack, against getBook and issueBook (or returnBook)
+// for each book, with numLoans books already out so the returns have an issued list to search
+void benchmarkBatchCheckout(int numBooks, int numLoans, int stackSize) {
+	std::string suffix = "/stack=" + std::to_string(stackSize) + "/loans=" + std::to_string(numLoans);
+	BookLibrary library;
+	library.setVerbose(false);
+	std::vector<Book> books;
+	for (int i = 0; i < numBooks; i++) {
+		books.push_back(makeBook(i));
+		library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+	}
+	Student otherStudent = makeStudent(0);
+	for (int i = 0; i < numLoans; i++) {
+		library.issueBook(books[numBooks - 1 - i], otherStudent);
+	}
+	Student student = makeStudent(1);
+	int numStacks = (numBooks - numLoans) / stackSize;
+	std::vector<std::vector<std::string>> stacks(numStacks);
+	for (int i = 0; i < numStacks * stackSize; i++) {
+		stacks[i / stackSize].push_back(books[i].title);
+	}
+	for (int batch = 0; batch <= 1; batch++) {
+		std::string mode = batch ? "batch" : "single";
+		auto start = startBenchmark();
+		for (int i = 0; i < numStacks; i++) {
+			if (batch) {
+				benchmarkSink += library.issueBooks(student, stacks[i]).applied;
+				continue;
+			}
+			for (int j = 0; j < stackSize; j++) {
+				Book book = library.getBook(stacks[i][j]);
+				if (book.isAvailable) {
+					library.issueBook(book, student);
+				}
+			}
+		}
+		recordResult("BookLibrary.issueStack/" + mode + suffix, numStacks, std::chrono::steady_clock::now() - start);
+		start = startBenchmark();
+		for (int i = 0; i < numStacks; i++) {
+			if (batch) {
+				benchmarkSink += library.returnBooks(student, stacks[i]).applied;
+				continue;
+			}
+			for (int j = 0; j < stackSize; j++) {
+				library.returnBook(library.getBook(stacks[i][j]), student);
+			}
+		}
+		recordResult("BookLibrary.returnStack/" + mode + suffix, numStacks, std::chrono::steady_clock::now() - start);
+	}
+}
+
+// How long a report holds up the library to get a consistent view of it: copying every book out (getAllBooks) against
+// taking a snapshot, and what snapshots add to each issue and return, with none live and with a new one every 100 operations
+void benchmarkSnapshots(int numBooks, int numOperations) {
+	std::string suffix = "/n=" + std::to_string(numBooks);
+	BookLibrary library;
+	library.setVerbose(false);
+	std::vector<Book> books;
+	for (int i = 0; i < numBooks; i++) {
+		books.push_back(makeBook(i));
+		library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+	}
+	Student student = makeStudent(0);
+	library.addStudent(student.getFirstName(), student.getLastName(), student.getStudentID());
+	int numReports = 20;
+	auto start = startBenchmark();
+	for (int i = 0; i < numReports; i++) {
+		benchmarkSink += static_cast<long long>(library.getAllBooks().size());
+	}
+	recordResult("BookLibrary.consistentView/copy" + suffix, numReports, std::chrono::steady_clock::now() - start);
+	library.enableSnapshots(true);
+	start = startBenchmark();
+	for (int i = 0; i < numReports * 1000; i++) {
+		benchmarkSink += library.takeSnapshot().getNumBooks();
+	}
+	recordResult("BookLibrary.consistentView/snapshot" + suffix, numReports * 1000, std::chrono::steady_clock::now() - start);
+	for (int mode = 0; mode < 3; mode++) {
+		const char* modeNames[] = { "off", "on", "live" };
+		library.enableSnapshots(mode > 0);
+		LibrarySnapshot report;
+		start = startBenchmark();
+		for (int i = 0; i < numOperations; i++) {
+			if (mode == 2 && i % 100 == 0) {
+				report = library.takeSnapshot();
+			}
+			const Book& book = books[i % numBooks];
+			library.issueBook(book, student);
+			library.returnBook(book, student);
+		}
+		recordResult("BookLibrary.issueReturn/snapshots=" + std::string(modeNames[mode]) + suffix, numOperations, std::chrono::steady_clock::now() - start);
+		benchmarkSink += report.getNumLoans();
+	}
+}
+
+// What an export costs the thread that asks for it: writing it inline, against handing it to the background scheduler
+// (the snapshot and the hand-off), and how long the handed-off exports then waited for a worker
+void benchmarkBackgroundExport(int numBooks, int numExports) {
+	std::string suffix = "/n=" + std::to_string(numBooks);
+	BookLibrary library;
+	library.setVerbose(false);
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+	}
+	std::string exportFileName = "benchmarkBackgroundExport.csv";
+	auto start = startBenchmark();
+	for (int i = 0; i < numExports; i++) {
+		benchmarkSink += library.exportBooks(exportFileName);
+	}
+	recordResult("BookLibrary.exportBooks/inline" + suffix, numExports, std::chrono::steady_clock::now() - start);
+	TaskScheduler scheduler(2);
+	library.setBackgroundScheduler(&scheduler);
+	library.takeSnapshot();
+	std::vector<TaskHandle<bool>> exports;
+	start = startBenchmark();
+	// Each job gets its own file, since any of them can be running at the same time as another
+	for (int i = 0; i < numExports; i++) {
+		exports.push_back(library.exportInBackground(EXPORT_BOOKS, exportFileName + std::to_string(i)));
+	}
+	recordResult("BookLibrary.exportBooks/handOff" + suffix, numExports, std::chrono::steady_clock::now() - start);
+	for (int i = 0; i < numExports; i++) {
+		benchmarkSink += exports[i].get();
+	}
+	LatencyHistogram queueTimes = scheduler.getStats(PRIORITY_LOW).queueNanoseconds;
+	if (isWarmUp) std::cerr << "  queue time: p50 " << queueTimes.valueAtPercentile(50) << " ns, max " << queueTimes.valueAtPercentile(100) << " ns" << std::endl;
+	std::remove(exportFileName.c_str());
+	for (int i = 0; i < numExports; i++) {
+		std::remove((exportFileName + std::to_string(i)).c_str());
+	}
+}
+
+// Feeding issues over numTitles titles (a few of them much more popular than the rest) into the circulation analytics,
+// sketched and exact, then asking for the ten most borrowed titles
+void benchmarkCirculationAnalytics(int numTitles, int numEvents) {
+	std::mt19937 generator(40);
+	std::vector<Book> books;
+	for (int i = 0; i < numTitles; i++) {
+		books.push_back(makeBook(i));
+	}
+	std::vector<Student> students;
+	for (int i = 0; i < 1000; i++) {
+		students.push_back(makeStudent(i));
+	}
+	std::vector<int> eventBooks;
+	for (int i = 0; i < numEvents; i++) {
+		// Half the issues go to the first 1% of the titles
+		int range = generator() % 2 == 0 ? numTitles / 100 + 1 : numTitles;
+		eventBooks.push_back(static_cast<int>(generator() % range));
+	}
+	for (int exact = 0; exact <= 1; exact++) {
+		std::string suffix = std::string(exact ? "/exact" : "/sketch") + "/titles=" + std::to_string(numTitles);
+		CirculationAnalytics analytics;
+		analytics.setExact(exact == 1);
+		auto start = startBenchmark();
+		for (int i = 0; i < numEvents; i++) {
+			analytics.recordIssue(books[eventBooks[i]], students[i % students.size()]);
+		}
+		recordResult("CirculationAnalytics.recordIssue" + suffix, numEvents, std::chrono::steady_clock::now() - start);
+		start = startBenchmark();
+		for (int i = 0; i < 100; i++) {
+			benchmarkSink += analytics.getTopTitles(10).size();
+		}
+		recordResult("CirculationAnalytics.getTopTitles" + suffix, 100, std::chrono::steady_clock::now() - start);
+	}
+}
+
+// Exporting the whole catalog through the buffered writer, against writing the same rows with an ofstream a line at a time
+void benchmarkExport(int numBooks) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	std::vector<Book> books;
+	BookLibrary library;
+	library.setVerbose(false);
+	for (int i = 0; i < numBooks; i++) {
+		books.push_back(makeBook(i));
+		library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+	}
+	std::string exportFileName = "benchmarkExport.csv";
+	auto start = startBenchmark();
+	library.exportBooks(exportFileName, EXPORT_CSV);
+	recordResult("BookLibrary.exportBooks/csv" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+	start = startBenchmark();
+	library.exportBooks(exportFileName, EXPORT_JSON_LINES);
+	recordResult("BookLibrary.exportBooks/jsonl" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	std::ofstream exportFile(exportFileName);
+	for (int i = 0; i < numBooks; i++) {
+		exportFile << books[i].title << ',' << books[i].author << ',' << books[i].ISBN << ',' << books[i].numPages << std::endl;
+	}
+	exportFile.close();
+	recordResult("ofstream.exportBooks/csv" + suffix, numBooks, std::chrono::steady_clock::now() - start);
+	std::remove(exportFileName.c_str());
+}
+
+// Starting up from a book file: loading all of it, against indexing it and serving the first lookup (of a book near
+// the end of the file) straight away; then what the rest of the lazy load costs, and a lookup while it's still going
+void benchmarkLazyStartup(int numBooks) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	std::string bookFileName = "benchmarkLazyStartup.txt";
+	BookLibrary source;
+	source.setVerbose(false);
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		source.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+	}
+	source.exportBooks(bookFileName);
+	source.destroyBookLibrary();
+	std::string lastTitle = makeBook(numBooks - 1).title;
+
+	auto start = startBenchmark();
+	{
+		BookLibrary library;
+		library.setVerbose(false);
+		loadBookData(library, bookFileName, ',');
+		benchmarkSink += library.getBook(lastTitle).numPages;
+		recordResult("BookLibrary.startup/full" + suffix, 1, std::chrono::steady_clock::now() - start);
+	}
+	TaskScheduler scheduler(1);
+	BookLibrary library;
+	library.setVerbose(false);
+	library.setBackgroundScheduler(&scheduler);
+	start = startBenchmark();
+	library.startLoadingBooks(bookFileName, ',');
+	benchmarkSink += library.getBook(lastTitle).numPages;
+	recordResult("BookLibrary.startup/lazy" + suffix, 1, std::chrono::steady_clock::now() - start);
+	int numLookups = 1000;
+	start = startBenchmark();
+	for (int i = 0; i < numLookups; i++) {
+		benchmarkSink += library.getBook(makeTitle(static_cast<int>((static_cast<long long>(i) * 7919) % numBooks))).numPages;
+	}
+	recordResult("BookLibrary.getBook/whileLoading" + suffix, numLookups, std::chrono::steady_clock::now() - start);
+	start = startBenchmark();
+	library.finishLoadingBooks();
+	recordResult("BookLibrary.finishLoadingBooks" + suffix, 1, std::chrono::steady_clock::now() - start);
+	std::remove(bookFileName.c_str());
+}
+
+// Nightly catalog refresh: a delta sync against a file where 2% of the records differ (1% changed, 0.5% gone and
+// 0.5% new), against throwing the books away and loading the file again. The README quotes the 500k book run.
+void benchmarkDeltaSync(int numBooks) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	std::string oldFileName = "benchmarkDeltaSyncOld.txt";
+	std::string newFileName = "benchmarkDeltaSyncNew.txt";
+	std::ofstream oldFile(oldFileName);
+	std::ofstream newFile(newFileName);
+	for (int i = 0; i < numBooks; i++) {
+		Book book = makeBook(i);
+		oldFile << book.title << "," << book.author << "," << book.ISBN << "," << book.numPages << "\n";
+		if (i % 200 == 1) {
+			continue;
+		}
+		if (i % 100 == 0) {
+			book.numPages += 1;
+		}
+		newFile << book.title << "," << book.author << "," << book.ISBN << "," << book.numPages << "\n";
+	}
+	for (int i = numBooks; i < numBooks + numBooks / 200; i++) {
+		Book book = makeBook(i);
+		newFile << book.title << "," << book.author << "," << book.ISBN << "," << book.numPages << "\n";
+	}
+	oldFile.close();
+	newFile.close();
+
+	TaskScheduler scheduler(1);
+	BookLibrary library;
+	library.setVerbose(false);
+	library.setBackgroundScheduler(&scheduler);
+	loadBookData(library, oldFileName, ',');
+	auto start = startBenchmark();
+	SyncReport report = library.syncBooks(newFileName, ',');
+	recordResult("BookLibrary.syncBooks" + suffix, 1, std::chrono::steady_clock::now() - start);
+	benchmarkSink += report.changes.size();
+
+	library.destroyBookLibrary();
+	loadBookData(library, oldFileName, ',');
+	start = startBenchmark();
+	library.destroyBookLibrary();
+	loadBookData(library, newFileName, ',');
+	recordResult("BookLibrary.fullReload" + suffix, 1, std::chrono::steady_clock::now() - start);
+	benchmarkSink += library.getNumBooks();
+	std::remove(oldFileName.c_str());
+	std::remove(newFileName.c_str());
+}
+
+// Retitling books with editBook, which relinks each one's node under its new title, against deleting each book and
+// adding it back under the new title
+void benchmarkEditBook(int numBooks, int numEdits) {
+	std::string suffix = "/books=" + std::to_string(numBooks);
+	BookLibrary library;
+	library.setVerbose(false);
+	for (int i = 0; i < numBooks; i++) {
+		Book newBook = makeBook(i);
+		library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+	}
+	std::vector<Book> books;
+	for (int i = 0; i < numEdits; i++) {
+		books.push_back(makeBook(static_cast<int>((static_cast<long long>(i) * 7919) % numBooks)));
+	}
+	auto start = startBenchmark();
+	for (int i = 0; i < numEdits; i++) {
+		benchmarkSink += library.editBook(books[i].title, books[i].title + " (edited)", books[i].author, books[i].ISBN, books[i].numPages);
+	}
+	recordResult("BookLibrary.editBook.retitle" + suffix, numEdits, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int i = 0; i < numEdits; i++) {
+		library.deleteBook(books[i].title + " (edited)");
+		library.addBook(books[i].title, books[i].author, books[i].ISBN, books[i].numPages);
+	}
+	recordResult("BookLibrary.deleteAndAddBook.retitle" + suffix, numEdits, std::chrono::steady_clock::now() - start);
+	benchmarkSink += library.getNumBooks();
+}
+
+// Author search over one library against the same books spread over branches that are searched in parallel
+void benchmarkFederatedSearch(int numBooks, int numBranches, int repetitions) {
+	std::string suffix = "/books=" + std::to_string(numBooks) + "/branches=" + std::to_string(numBranches);
+	std::vector<std::string> branchNames;
+	for (int i = 0; i < numBranches; i++) {
+		branchNames.push_back("Branch " + std::to_string(i));
+	}
+	LibraryFederation federation(branchNames);
+	std::vector<std::future<void>> loading;
+	for (int b = 0; b < numBranches; b++) {
+		loading.push_back(federation.runOnBranch(b, [b, numBooks, numBranches](BookLibrary& library) {
+			for (int i = b; i < numBooks; i += numBranches) {
+				Book newBook = makeBook(i);
+				library.addBook(newBook.title, newBook.author, newBook.ISBN, newBook.numPages);
+			}
+		}));
+	}
+	for (size_t i = 0; i < loading.size(); i++) {
+		loading[i].get();
+	}
+
+	auto start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += federation.findByAuthor("Author " + std::to_string(r % 997)).size();
+	}
+	recordResult("LibraryFederation.findByAuthor" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+
+	start = startBenchmark();
+	for (int r = 0; r < repetitions; r++) {
+		benchmarkSink += federation.findByISBN(makeBook(r % numBooks).ISBN).size();
+	}
+	recordResult("LibraryFederation.findByISBN" + suffix, repetitions, std::chrono::steady_clock::now() - start);
+}
+
+// Writes out all results as JSON; one result object per line so it's also easy to read back in
+void writeResults(std::ostream& os) {
+	os << "[" << std::endl;
+	for (size_t i = 0; i < benchmarkResults.size(); i++) {
+		os << "{\"name\": \"" << benchmarkResults[i].name
+			<< "\", \"iterations\": " << benchmarkResults[i].iterations
+			<< ", \"ns_per_op\": " << benchmarkResults[i].nsPerOp
+			<< ", \"allocs_per_op\": " << benchmarkResults[i].allocsPerOp
+			<< ", \"spread\": " << benchmarkResults[i].spread << "}"
+			<< (i + 1 < benchmarkResults.size() ? "," : "") << std::endl;
+	}
+	os << "]" << std::endl;
+}
+
+// Reads results written by writeResults back in; lines that aren't result objects are skipped
+std::vector<BenchmarkResult> readResults(std::string fileName) {
+	std::vector<BenchmarkResult> results;
+	std::ifstream resultFile(fileName);
+	std::string currentLine;
+	const std::string nameField = "\"name\": \"";
+	const std::string nsField = "\"ns_per_op\": ";
+	const std::string allocsField = "\"allocs_per_op\": ";
+	const std::string spreadField = "\"spread\": ";
+	while (std::getline(resultFile, currentLine)) {
+		size_t namePos = currentLine.find(nameField);
+		size_t nsPos = currentLine.find(nsField);
+		if (namePos == std::string::npos || nsPos == std::string::npos) {
+			continue;
+		}
+		namePos += nameField.length();
+		BenchmarkResult result;
+		result.name = currentLine.substr(namePos, currentLine.find('"', namePos) - namePos);
+		result.iterations = 0;
+		result.nsPerOp = std::atof(currentLine.c_str() + nsPos + nsField.length());
+		// Older baselines don't have allocation counts
+		size_t allocsPos = currentLine.find(allocsField);
+		result.allocsPerOp = allocsPos == std::string::npos ? 0.0 : std::atof(currentLine.c_str() + allocsPos + allocsField.length());
+		// ... or spreads, from before benchmarks were repeated
+		size_t spreadPos = currentLine.find(spreadField);
+		result.spread = spreadPos == std::string::npos ? 0.0 : std::atof(currentLine.c_str() + spreadPos + spreadField.length());
+		results.push_back(result);
+	}
+	return results;
+}
+
+// Compares the current results against a baseline, and returns the number of regressions. A benchmark has to get
+// slower by more than both the threshold and the noise seen in the two runs (their spreads added together).
+int compareToBaseline(std::vector<BenchmarkResult> baseline, double threshold) {
+	int numRegressions = 0;
+	std::cerr << "Comparing against baseline (threshold " << threshold * 100 << "%): " << std::endl;
+	for (size_t i = 0; i < benchmarkResults.size(); i++) {
+		for (size_t j = 0; j < baseline.size(); j++) {
+			if (benchmarkResults[i].name != baseline[j].name || baseline[j].nsPerOp <= 0) {
+				continue;
+			}
+			double change = (benchmarkResults[i].nsPerOp - baseline[j].nsPerOp) / baseline[j].nsPerOp;
+			double allowed = std::max(threshold, benchmarkResults[i].spread + baseline[j].spread);
+			bool isRegression = change > allowed;
+			if (isRegression) {
+				numRegressions += 1;
+			}
+			std::cerr << (isRegression ? "REGRESSION " : "ok         ") << benchmarkResults[i].name << ": "
+				<< baseline[j].nsPerOp << " -> " << benchmarkResults[i].nsPerOp << " ns/op ("
+				<< (change >= 0 ? "+" : "") << change * 100 << "%, allowed " << allowed * 100 << "%)" << std::endl;
+			break;
+		}
+	}
+	return numRegressions;
+}
+
+int main(int argc, char* argv[]) {
+	bool quick = false;
+	std::string jsonFileName;
+	std::string baselineFileName;
+	double threshold = 0.10;
+	int repeats = 0;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--quick") {
+			quick = true;
+		} else if (arg == "--json" && i + 1 < argc) {
+			jsonFileName = argv[++i];
+		} else if (arg == "--baseline" && i + 1 < argc) {
+			baselineFileName = argv[++i];
+		} else if (arg == "--threshold" && i + 1 < argc) {
+			threshold = std::atof(argv[++i]);
+		} else if (arg == "--repeats" && i + 1 < argc) {
+			repeats = std::max(1, std::atoi(argv[++i]));
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--quick] [--json <outputFile>] [--baseline <baselineFile>] [--threshold <ratio>] [--repeats N]" << std::endl;
+			return 2;
+		}
+	}
+
+	benchmarkRepeats = repeats > 0 ? repeats : (quick ? 3 : 5);
+
+	// Sizes for each group of benchmarks; the quick run is only meant to make sure everything still works
+	std::vector<int> tableSizes = quick ? std::vector<int>{ 1000 } : std::vector<int>{ 1000, 10000, 50000 };
+	std::vector<int> loadFactors = { 1, 8, 64 };
+	int repetitions = quick ? 10000 : 200000;
+
+	for (size_t i = 0; i < tableSizes.size(); i++) {
+		for (size_t j = 0; j < loadFactors.size(); j++) {
+			runBenchmark([&]() { benchmarkHashTable(tableSizes[i], loadFactors[j]); });
+		}
+	}
+	for (size_t i = 0; i < tableSizes.size(); i++) {
+		runBenchmark([&]() { benchmarkHashTableConfigurations(tableSizes[i]); });
+	}
+	runBenchmark([&]() { benchmarkLinkedList(8, repetitions); });
+	runBenchmark([&]() { benchmarkLinkedList(64, repetitions / 10); });
+	for (size_t i = 0; i < tableSizes.size(); i++) {
+		runBenchmark([&]() { benchmarkMergeSort(tableSizes[i]); });
+	}
+	runBenchmark([&]() { benchmarkStringUtilities(repetitions); });
+	runBenchmark([&]() { benchmarkIssueReturn(quick ? 1000 : 10000, quick ? 100 : 1000, quick ? 1000 : 10000); });
+	runBenchmark([&]() { benchmarkListings(quick ? 1000 : 50000, quick ? 10 : 20); });
+	runBenchmark([&]() { benchmarkFilteredQueries(quick ? 1000 : 50000, quick ? 10 : 20); });
+	runBenchmark([&]() { benchmarkFrozenCatalog(quick ? 1000 : 200000); });
+	runBenchmark([&]() { benchmarkBloomFilters(quick ? 1000 : 200000, quick ? 100 : 10000); });
+	runBenchmark([&]() { benchmarkHotTitleCache(quick ? 1000 : 200000, quick ? 10000 : 1000000); });
+	runBenchmark([&]() { benchmarkCatalogImage(quick ? 1000 : 200000); });
+	runBenchmark([&]() { benchmarkDueDates(quick ? 1000 : 100000); });
+	runBenchmark([&]() { benchmarkCirculationAnalytics(quick ? 1000 : 200000, quick ? 10000 : 1000000); });
+	runBenchmark([&]() { benchmarkExport(quick ? 1000 : 200000); });
+	runBenchmark([&]() { benchmarkBatchCheckout(quick ? 2000 : 20000, quick ? 500 : 5000, 10); });
+	runBenchmark([&]() { benchmarkSnapshots(quick ? 2000 : 100000, quick ? 2000 : 100000); });
+	runBenchmark([&]() { benchmarkBackgroundExport(quick ? 1000 : 100000, 10); });
+	runBenchmark([&]() { benchmarkLazyStartup(quick ? 2000 : 500000); });
+	runBenchmark([&]() { benchmarkDeltaSync(quick ? 2000 : 500000); });
+	runBenchmark([&]() { benchmarkEditBook(quick ? 2000 : 200000, quick ? 500 : 50000); });
+	runBenchmark([&]() { benchmarkHolds(quick ? 1000 : 20000, quick ? 500 : 50000, quick ? 5000 : 200000); });
+	runBenchmark([&]() { benchmarkFederatedSearch(quick ? 4000 : 200000, 1, quick ? 20 : 50); });
+	runBenchmark([&]() { benchmarkFederatedSearch(quick ? 4000 : 200000, 4, quick ? 20 : 50); });
+
+	if (jsonFileName.empty()) {
+		writeResults(std::cout);
+	} else {
+		std::ofstream jsonFile(jsonFileName);
+		writeResults(jsonFile);
+	}
+
+	if (!baselineFileName.empty()) {
+		std::vector<BenchmarkResult> baseline = readResults(baselineFileName);
+		if (baseline.empty()) {
+			std::cerr << "Benchmark: Could not read any results from baseline '" << baselineFileName << "'!" << std::endl;
+			return 2;
+		}
+		int numRegressions = compareToBaseline(baseline, threshold);
+		std::cerr << numRegressions << " regression(s) found." << std::endl;
+		return numRegressions > 0 ? 1 : 0;
+	}
+	return 0;
+}
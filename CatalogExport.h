@@ -0,0 +1,336 @@
+#ifndef CATALOGEXPORT_H
+#define CATALOGEXPORT_H
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+#include "Book.h"
+#include "Student.h"
+
+/*
++ Streaming export of the library's books, students and loans, for the nightly reports. Rows are formatted straight
+into a BufferedFileWriter as the library walks its own structures, so nothing is copied into a vector or sorted first,
+and nothing goes through iostreams.
+
++ Two formats: CSV, with the same columns the data loader reads (so an exported bookData or studentData file can be
+loaded back in), and JSON Lines, one JSON object per line. CSV fields with a comma, a quote or a line break in them are
+quoted, with quotes doubled, which splitLine understands.
+*/
+
+enum ExportFormat { EXPORT_CSV, EXPORT_JSON_LINES };
+
+// What an export has in it, for the exports that are handed to a background job
+enum ExportContents { EXPORT_BOOKS, EXPORT_STUDENTS, EXPORT_LOANS };
+
+/*
++ Writes to a file through a few large buffers that are reused for the whole file. Appends are copied into the current
+buffer, and once every buffer is full they're all handed to the kernel with a single writev call, so a file of millions
+of rows takes a few hundred system calls rather than one per row. Where there's no writev (anything but Linux), each
+full buffer is written with one fwrite instead.
+*/
+class BufferedFileWriter {
+private:
+	static const size_t bufferSize = 256 * 1024;
+	static const int numBuffers = 4;
+#ifdef __linux__
+	int fd = -1;
+#else
+	FILE* file = nullptr;
+#endif
+	std::vector<std::vector<char>> buffers;
+	int currentBuffer = 0;
+	size_t used[numBuffers] = {};
+	long long bytesWritten = 0;
+	bool failed = false;
+
+	// Moves on to the next buffer, writing them all out first if this was the last one
+	void nextBuffer() {
+		currentBuffer += 1;
+		if (currentBuffer == numBuffers) {
+			flush();
+		}
+	}
+
+public:
+	BufferedFileWriter() {
+		buffers.assign(numBuffers, std::vector<char>(bufferSize));
+	}
+
+	BufferedFileWriter(const BufferedFileWriter&) = delete;
+	BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+	~BufferedFileWriter() {
+		close();
+	}
+
+	// Creates (or empties) a file to write to; returns false if it can't be opened
+	bool open(const std::string& fileName) {
+		close();
+#ifdef __linux__
+		fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		failed = fd < 0;
+#else
+		file = std::fopen(fileName.c_str(), "wb");
+		failed = file == nullptr;
+#endif
+		bytesWritten = 0;
+		return !failed;
+	}
+
+	// Writes everything appended so far
+	void flush() {
+#ifdef __linux__
+		struct iovec pieces[numBuffers];
+		int numPieces = 0;
+		for (int i = 0; i < numBuffers; i++) {
+			if (used[i] > 0) {
+				pieces[numPieces].iov_base = buffers[i].data();
+				pieces[numPieces].iov_len = used[i];
+				numPieces += 1;
+			}
+		}
+		// writev can write less than it was given, so keep going from wherever it stopped
+		int firstPiece = 0;
+		while (!failed && fd >= 0 && firstPiece < numPieces) {
+			ssize_t written = writev(fd, pieces + firstPiece, numPieces - firstPiece);
+			if (written < 0) {
+				failed = true;
+				break;
+			}
+			bytesWritten += written;
+			while (firstPiece < numPieces && static_cast<size_t>(written) >= pieces[firstPiece].iov_len) {
+				written -= static_cast<ssize_t>(pieces[firstPiece].iov_len);
+				firstPiece += 1;
+			}
+			if (firstPiece < numPieces) {
+				pieces[firstPiece].iov_base = static_cast<char*>(pieces[firstPiece].iov_base) + written;
+				pieces[firstPiece].iov_len -= static_cast<size_t>(written);
+			}
+		}
+#else
+		for (int i = 0; i < numBuffers && !failed && file != nullptr; i++) {
+			if (used[i] > 0) {
+				if (std::fwrite(buffers[i].data(), 1, used[i], file) != used[i]) {
+					failed = true;
+				}
+				bytesWritten += static_cast<long long>(used[i]);
+			}
+		}
+#endif
+		for (int i = 0; i < numBuffers; i++) {
+			used[i] = 0;
+		}
+		currentBuffer = 0;
+	}
+
+	// Writes what's left and closes the file; returns false if any write failed
+	bool close() {
+#ifdef __linux__
+		if (fd < 0) {
+			return !failed;
+		}
+		flush();
+		if (::close(fd) != 0) {
+			failed = true;
+		}
+		fd = -1;
+#else
+		if (file == nullptr) {
+			return !failed;
+		}
+		flush();
+		if (std::fclose(file) != 0) {
+			failed = true;
+		}
+		file = nullptr;
+#endif
+		return !failed;
+	}
+
+	void append(const char* text, size_t length) {
+		while (length > 0) {
+			size_t room = bufferSize - used[currentBuffer];
+			size_t amount = length < room ? length : room;
+			std::memcpy(buffers[currentBuffer].data() + used[currentBuffer], text, amount);
+			used[currentBuffer] += amount;
+			text += amount;
+			length -= amount;
+			if (used[currentBuffer] == bufferSize) {
+				nextBuffer();
+			}
+		}
+	}
+
+	void append(const std::string& text) {
+		append(text.data(), text.size());
+	}
+
+	void append(char c) {
+		buffers[currentBuffer][used[currentBuffer]] = c;
+		used[currentBuffer] += 1;
+		if (used[currentBuffer] == bufferSize) {
+			nextBuffer();
+		}
+	}
+
+	void appendNumber(long long number) {
+		char digits[24];
+		std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), number);
+		append(digits, static_cast<size_t>(result.ptr - digits));
+	}
+
+	// Appends a CSV field, quoted only if it has to be
+	void appendCSVField(const std::string& field) {
+		bool needsQuotes = false;
+		for (size_t i = 0; i < field.size(); i++) {
+			char c = field[i];
+			needsQuotes |= c == ',' || c == '"' || c == '\r' || c == '\n';
+		}
+		if (!needsQuotes) {
+			append(field);
+			return;
+		}
+		append('"');
+		for (size_t i = 0; i < field.size(); i++) {
+			if (field[i] == '"') {
+				append('"');
+			}
+			append(field[i]);
+		}
+		append('"');
+	}
+
+	// Appends a JSON string, with its quotes, escaping what JSON requires
+	void appendJSONString(const std::string& text) {
+		append('"');
+		size_t start = 0;
+		for (size_t i = 0; i < text.size(); i++) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c != '"' && c != '\\' && c >= 0x20) {
+				continue;
+			}
+			// Copy the run of plain characters before this one in one go
+			append(text.data() + start, i - start);
+			start = i + 1;
+			if (c == '"' || c == '\\') {
+				append('\\');
+				append(static_cast<char>(c));
+			} else if (c == '\n') {
+				append("\\n", 2);
+			} else if (c == '\t') {
+				append("\\t", 2);
+			} else if (c == '\r') {
+				append("\\r", 2);
+			} else {
+				const char* hexDigits = "0123456789abcdef";
+				char escaped[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 15] };
+				append(escaped, 6);
+			}
+		}
+		append(text.data() + start, text.size() - start);
+		append('"');
+	}
+
+	long long getBytesWritten() {
+		return bytesWritten;
+	}
+};
+
+// Header rows, for the formats that have them. The book and student CSV files have none, like the files the loader reads.
+void writeLoanExportHeader(BufferedFileWriter& writer, ExportFormat format) {
+	if (format == EXPORT_CSV) {
+		writer.append("title,author,ISBN,studentID,firstName,lastName,checkoutTime,dueTime\n");
+	}
+}
+
+// Book row: title, author, ISBN, number of pages (the loader's columns), or a JSON object that also has availability
+void writeBookRow(BufferedFileWriter& writer, const Book& book, ExportFormat format) {
+	if (format == EXPORT_CSV) {
+		writer.appendCSVField(book.title);
+		writer.append(',');
+		writer.appendCSVField(book.author);
+		writer.append(',');
+		writer.appendCSVField(book.ISBN);
+		writer.append(',');
+		writer.appendNumber(book.numPages);
+		writer.append('\n');
+		return;
+	}
+	writer.append("{\"title\": ");
+	writer.appendJSONString(book.title);
+	writer.append(", \"author\": ");
+	writer.appendJSONString(book.author);
+	writer.append(", \"isbn\": ");
+	writer.appendJSONString(book.ISBN);
+	writer.append(", \"pages\": ");
+	writer.appendNumber(book.numPages);
+	writer.append(book.isAvailable ? ", \"available\": true}\n" : ", \"available\": false}\n");
+}
+
+// Student row: first name, last name, student ID (the loader's columns)
+void writeStudentRow(BufferedFileWriter& writer, const Student& student, ExportFormat format) {
+	if (format == EXPORT_CSV) {
+		writer.appendCSVField(student.getFirstName());
+		writer.append(',');
+		writer.appendCSVField(student.getLastName());
+		writer.append(',');
+		writer.appendCSVField(student.getStudentID());
+		writer.append('\n');
+		return;
+	}
+	writer.append("{\"firstName\": ");
+	writer.appendJSONString(student.getFirstName());
+	writer.append(", \"lastName\": ");
+	writer.appendJSONString(student.getLastName());
+	writer.append(", \"studentID\": ");
+	writer.appendJSONString(student.getStudentID());
+	writer.append("}\n");
+}
+
+// Loan row: the book, who it's issued to, and when it was issued and is due (seconds since the epoch)
+void writeLoanRow(BufferedFileWriter& writer, const Book& book, const Student& student, long long checkoutTime, long long dueTime, ExportFormat format) {
+	if (format == EXPORT_CSV) {
+		writer.appendCSVField(book.title);
+		writer.append(',');
+		writer.appendCSVField(book.author);
+		writer.append(',');
+		writer.appendCSVField(book.ISBN);
+		writer.append(',');
+		writer.appendCSVField(student.getStudentID());
+		writer.append(',');
+		writer.appendCSVField(student.getFirstName());
+		writer.append(',');
+		writer.appendCSVField(student.getLastName());
+		writer.append(',');
+		writer.appendNumber(checkoutTime);
+		writer.append(',');
+		writer.appendNumber(dueTime);
+		writer.append('\n');
+		return;
+	}
+	writer.append("{\"title\": ");
+	writer.appendJSONString(book.title);
+	writer.append(", \"author\": ");
+	writer.appendJSONString(book.author);
+	writer.append(", \"isbn\": ");
+	writer.appendJSONString(book.ISBN);
+	writer.append(", \"studentID\": ");
+	writer.appendJSONString(student.getStudentID());
+	writer.append(", \"firstName\": ");
+	writer.appendJSONString(student.getFirstName());
+	writer.append(", \"lastName\": ");
+	writer.appendJSONString(student.getLastName());
+	writer.append(", \"checkoutTime\": ");
+	writer.appendNumber(checkoutTime);
+	writer.append(", \"dueTime\": ");
+	writer.appendNumber(dueTime);
+	writer.append("}\n");
+}
+
+#endif
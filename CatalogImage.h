@@ -0,0 +1,583 @@
+#ifndef CATALOGIMAGE_H
+#define CATALOGIMAGE_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <chrono>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "Book.h"
+#include "HashTable.h"
+#include "utilities.h"
+
+/*
++ Catalog image: the books and their title, ISBN and author indexes written out as one read-only file that can be
+memory mapped. The search terminals each open the same image instead of loading bookData.txt into their own hash
+tables, so every process shares one copy of the catalog in the page cache, and opening it doesn't parse anything.
+
++ Layout: a header, then the book records, the author groups, the author postings, the three index tables and finally
+the string pool. Everything refers to everything else by offsets from the start of the file (never by pointers), so the
+image works wherever it gets mapped. Each index is an open addressing table (linear probing, a power of two slots, at
+least twice as many as keys) of record numbers plus one, with 0 for an empty slot; titles and authors are hashed lower
+cased so lookups ignore case, like the library's.
+
++ NOTE: A writer never changes an image that might be mapped. writeCatalogImage writes the new version to a temporary
+file next to it and renames that over the old one, which is atomic, so a reader sees either the old version or the new
+one, never half of each. Readers that already have the old one mapped keep it (the old file stays around until the
+last of them unmaps it) until they call reopenIfChanged().
+
++ NOTE: mmap, fsync and inode numbers are only used on Linux. Elsewhere the image is read into memory with an ifstream
+(each process gets its own copy, but lookups work the same), it's written with an ofstream, and reopenIfChanged()
+compares the generation in the file's header instead of its inode.
+*/
+
+// Fixed-width structures stored in the image; they're only read in place, so the layout is the same in every process
+namespace CatalogImageFormat {
+	const char magic[8] = { 'B', 'L', 'C', 'A', 'T', 'I', 'M', 'G' };
+	const uint32_t version = 1;
+	const uint32_t byteOrderMark = 0x01020304; // reads back differently on a machine with the other byte order
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrderMark;
+		uint64_t fileSize;
+		uint64_t generation; // goes up by one each time an image is published over the last one
+		uint32_t numBooks;
+		uint32_t numAuthors;
+		uint64_t booksOffset;
+		uint64_t authorGroupsOffset;
+		uint64_t authorPostingsOffset;
+		uint64_t titleSlotsOffset;
+		uint32_t numTitleSlots;
+		uint32_t numISBNSlots;
+		uint64_t isbnSlotsOffset;
+		uint64_t authorSlotsOffset;
+		uint32_t numAuthorSlots;
+		uint32_t reserved;
+		uint64_t stringsOffset;
+		uint64_t stringsSize;
+	};
+
+	struct StringRef {
+		uint32_t offset; // from the start of the string pool
+		uint32_t length;
+	};
+
+	struct BookRecord {
+		StringRef title;
+		StringRef author;
+		StringRef ISBN;
+		int32_t numPages;
+		uint32_t isAvailable;
+	};
+
+	// The books by one author are postings[firstPosting] to postings[firstPosting + numPostings - 1]
+	struct AuthorGroup {
+		StringRef author;
+		uint32_t firstPosting;
+		uint32_t numPostings;
+	};
+}
+
+// Number of slots for an index over numKeys keys: a power of two, at least twice the keys
+uint32_t catalogImageSlotCount(size_t numKeys) {
+	uint32_t numSlots = 16;
+	while (numSlots < numKeys * 2) {
+		numSlots *= 2;
+	}
+	return numSlots;
+}
+
+// Writes an image of the given books to fileName, replacing any image already there with one atomic rename, and
+// returns whether it worked. The new image's generation is one more than the one it replaces.
+bool writeCatalogImage(const std::vector<Book>& books, const std::string& fileName) {
+	using namespace CatalogImageFormat;
+
+	// Generation of the image being replaced, if there's a valid one
+	uint64_t generation = 1;
+	FILE* oldFile = std::fopen(fileName.c_str(), "rb");
+	if (oldFile != nullptr) {
+		Header oldHeader;
+		if (std::fread(&oldHeader, sizeof(oldHeader), 1, oldFile) == 1 && std::memcmp(oldHeader.magic, magic, sizeof(magic)) == 0) {
+			generation = oldHeader.generation + 1;
+		}
+		std::fclose(oldFile);
+	}
+
+	// String pool; each string is only ever added once per book, so there's no need to share them
+	std::string strings;
+	auto addString = [&strings](const std::string& text) {
+		StringRef ref;
+		ref.offset = static_cast<uint32_t>(strings.size());
+		ref.length = static_cast<uint32_t>(text.size());
+		strings += text;
+		return ref;
+	};
+	std::vector<BookRecord> records(books.size());
+	for (size_t i = 0; i < books.size(); i++) {
+		records[i].title = addString(books[i].title);
+		records[i].author = addString(books[i].author);
+		records[i].ISBN = addString(books[i].ISBN);
+		records[i].numPages = books[i].numPages;
+		records[i].isAvailable = books[i].isAvailable ? 1 : 0;
+	}
+
+	// Group the books by lower cased author, using a HashTable from author to group number
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> groupNumbers;
+	std::vector<AuthorGroup> authorGroups;
+	std::vector<std::vector<uint32_t>> groupBooks;
+	for (size_t i = 0; i < books.size(); i++) {
+		std::string authorKey = lowerCaseString(books[i].author);
+		int* groupNumber = groupNumbers.findValue(authorKey);
+		if (groupNumber == nullptr) {
+			groupNumbers.insertPair(authorKey, static_cast<int>(authorGroups.size()));
+			AuthorGroup group;
+			group.author = records[i].author;
+			authorGroups.push_back(group);
+			groupBooks.push_back(std::vector<uint32_t>());
+			groupBooks.back().push_back(static_cast<uint32_t>(i));
+		} else {
+			groupBooks[*groupNumber].push_back(static_cast<uint32_t>(i));
+		}
+	}
+	std::vector<uint32_t> authorPostings;
+	authorPostings.reserve(books.size());
+	for (size_t g = 0; g < authorGroups.size(); g++) {
+		authorGroups[g].firstPosting = static_cast<uint32_t>(authorPostings.size());
+		authorGroups[g].numPostings = static_cast<uint32_t>(groupBooks[g].size());
+		authorPostings.insert(authorPostings.end(), groupBooks[g].begin(), groupBooks[g].end());
+	}
+
+	// Open addressing tables of record (or group) numbers plus one; a key that's already in a table keeps its first
+	// entry, like the library's ISBN index
+	auto buildSlots = [](size_t numKeys, auto keyFor) {
+		std::vector<uint32_t> slots(catalogImageSlotCount(numKeys), 0);
+		uint32_t mask = static_cast<uint32_t>(slots.size() - 1);
+		for (size_t i = 0; i < numKeys; i++) {
+			std::string key = keyFor(i);
+			uint32_t slot = static_cast<uint32_t>(FNV1aHash::hash(key)) & mask;
+			bool duplicate = false;
+			while (slots[slot] != 0) {
+				if (keyFor(slots[slot] - 1) == key) {
+					duplicate = true;
+					break;
+				}
+				slot = (slot + 1) & mask;
+			}
+			if (!duplicate) {
+				slots[slot] = static_cast<uint32_t>(i + 1);
+			}
+		}
+		return slots;
+	};
+	std::vector<uint32_t> titleSlots = buildSlots(books.size(), [&books](size_t i) { return lowerCaseString(books[i].title); });
+	std::vector<uint32_t> isbnSlots = buildSlots(books.size(), [&books](size_t i) { return books[i].ISBN; });
+	std::vector<uint32_t> authorSlots = buildSlots(authorGroups.size(), [&books, &groupBooks](size_t g) {
+		return lowerCaseString(books[groupBooks[g][0]].author);
+	});
+
+	// Lay the sections out one after another, each starting on an 8-byte boundary
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.byteOrderMark = byteOrderMark;
+	header.generation = generation;
+	header.numBooks = static_cast<uint32_t>(books.size());
+	header.numAuthors = static_cast<uint32_t>(authorGroups.size());
+	uint64_t offset = sizeof(Header);
+	auto placeSection = [&offset](uint64_t size) {
+		uint64_t sectionOffset = (offset + 7) & ~uint64_t(7);
+		offset = sectionOffset + size;
+		return sectionOffset;
+	};
+	header.booksOffset = placeSection(records.size() * sizeof(BookRecord));
+	header.authorGroupsOffset = placeSection(authorGroups.size() * sizeof(AuthorGroup));
+	header.authorPostingsOffset = placeSection(authorPostings.size() * sizeof(uint32_t));
+	header.numTitleSlots = static_cast<uint32_t>(titleSlots.size());
+	header.titleSlotsOffset = placeSection(titleSlots.size() * sizeof(uint32_t));
+	header.numISBNSlots = static_cast<uint32_t>(isbnSlots.size());
+	header.isbnSlotsOffset = placeSection(isbnSlots.size() * sizeof(uint32_t));
+	header.numAuthorSlots = static_cast<uint32_t>(authorSlots.size());
+	header.authorSlotsOffset = placeSection(authorSlots.size() * sizeof(uint32_t));
+	header.stringsSize = strings.size();
+	header.stringsOffset = placeSection(strings.size());
+	header.fileSize = offset;
+
+	std::vector<char> image(offset, 0);
+	std::memcpy(image.data(), &header, sizeof(header));
+	auto copySection = [&image](uint64_t sectionOffset, const void* data, size_t size) {
+		if (size > 0) {
+			std::memcpy(image.data() + sectionOffset, data, size);
+		}
+	};
+	copySection(header.booksOffset, records.data(), records.size() * sizeof(BookRecord));
+	copySection(header.authorGroupsOffset, authorGroups.data(), authorGroups.size() * sizeof(AuthorGroup));
+	copySection(header.authorPostingsOffset, authorPostings.data(), authorPostings.size() * sizeof(uint32_t));
+	copySection(header.titleSlotsOffset, titleSlots.data(), titleSlots.size() * sizeof(uint32_t));
+	copySection(header.isbnSlotsOffset, isbnSlots.data(), isbnSlots.size() * sizeof(uint32_t));
+	copySection(header.authorSlotsOffset, authorSlots.data(), authorSlots.size() * sizeof(uint32_t));
+	copySection(header.stringsOffset, strings.data(), strings.size());
+
+	// Write it all to a temporary file, make sure it's on disk, then swap it in
+#ifdef __linux__
+	std::string tempFileName = fileName + ".tmp." + std::to_string(getpid());
+	int fd = open(tempFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	size_t written = 0;
+	while (written < image.size()) {
+		ssize_t result = write(fd, image.data() + written, image.size() - written);
+		if (result <= 0) {
+			close(fd);
+			unlink(tempFileName.c_str());
+			return false;
+		}
+		written += static_cast<size_t>(result);
+	}
+	if (fsync(fd) != 0) {
+		close(fd);
+		unlink(tempFileName.c_str());
+		return false;
+	}
+	close(fd);
+#else
+	std::string tempFileName = fileName + ".tmp." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+	std::ofstream tempFile(tempFileName, std::ios::binary | std::ios::trunc);
+	tempFile.write(image.data(), static_cast<std::streamsize>(image.size()));
+	tempFile.close();
+	if (!tempFile) {
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+	// Some systems won't rename over a file that exists
+	std::remove(fileName.c_str());
+#endif
+	if (std::rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Read-only view of a catalog image mapped into memory; the lookups read straight from the shared pages
+class CatalogImage {
+private:
+	const char* base = nullptr; // start of the mapping, or nullptr if no image is open
+	size_t mappedSize = 0;
+	std::string fileName;
+#ifdef __linux__
+	ino_t fileInode = 0; // which file was mapped, to notice when a new image was renamed over it
+#else
+	std::vector<char> fileData; // the whole image, read into memory where there's no mmap
+#endif
+	const CatalogImageFormat::Header* header = nullptr;
+
+	template <class T>
+	const T* section(uint64_t offset) const {
+		return reinterpret_cast<const T*>(base + offset);
+	}
+
+	const char* stringData(CatalogImageFormat::StringRef ref) const {
+		return base + header->stringsOffset + ref.offset;
+	}
+
+	// Whether a stored string equals a lower cased key, ignoring the stored string's case
+	bool equalsKeyIgnoringCase(CatalogImageFormat::StringRef ref, const std::string& lowerKey) const {
+		if (ref.length != lowerKey.length()) {
+			return false;
+		}
+		const char* text = stringData(ref);
+		for (size_t i = 0; i < lowerKey.length(); i++) {
+			if (tolower(static_cast<unsigned char>(text[i])) != static_cast<unsigned char>(lowerKey[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool equalsKey(CatalogImageFormat::StringRef ref, const std::string& key) const {
+		return ref.length == key.length() && std::memcmp(stringData(ref), key.data(), key.length()) == 0;
+	}
+
+	// Checks that the header describes a file of this size whose sections all fit inside it, so a truncated or
+	// corrupt image can't make a lookup read past the mapping
+	bool isValid(size_t size) const {
+		using namespace CatalogImageFormat;
+		if (size < sizeof(Header) || std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version
+			|| header->byteOrderMark != byteOrderMark || header->fileSize != size) {
+			return false;
+		}
+		auto fits = [size](uint64_t offset, uint64_t count, uint64_t itemSize) {
+			return offset % 4 == 0 && offset <= size && count <= (size - offset) / itemSize;
+		};
+		auto isPowerOfTwo = [](uint32_t n) { return n > 0 && (n & (n - 1)) == 0; };
+		if (!fits(header->booksOffset, header->numBooks, sizeof(BookRecord))
+			|| !fits(header->authorGroupsOffset, header->numAuthors, sizeof(AuthorGroup))
+			|| !fits(header->authorPostingsOffset, header->numBooks, sizeof(uint32_t))
+			|| !fits(header->titleSlotsOffset, header->numTitleSlots, sizeof(uint32_t))
+			|| !fits(header->isbnSlotsOffset, header->numISBNSlots, sizeof(uint32_t))
+			|| !fits(header->authorSlotsOffset, header->numAuthorSlots, sizeof(uint32_t))
+			|| !fits(header->stringsOffset, header->stringsSize, 1)
+			|| !isPowerOfTwo(header->numTitleSlots) || !isPowerOfTwo(header->numISBNSlots) || !isPowerOfTwo(header->numAuthorSlots)) {
+			return false;
+		}
+		// Every reference has to stay inside the section it points into
+		const BookRecord* records = section<BookRecord>(header->booksOffset);
+		auto stringFits = [this](StringRef ref) {
+			return ref.offset <= header->stringsSize && ref.length <= header->stringsSize - ref.offset;
+		};
+		for (uint32_t i = 0; i < header->numBooks; i++) {
+			if (!stringFits(records[i].title) || !stringFits(records[i].author) || !stringFits(records[i].ISBN)) {
+				return false;
+			}
+		}
+		const AuthorGroup* groups = section<AuthorGroup>(header->authorGroupsOffset);
+		for (uint32_t g = 0; g < header->numAuthors; g++) {
+			if (!stringFits(groups[g].author) || groups[g].firstPosting > header->numBooks
+				|| groups[g].numPostings > header->numBooks - groups[g].firstPosting) {
+				return false;
+			}
+		}
+		const uint32_t* postings = section<uint32_t>(header->authorPostingsOffset);
+		for (uint32_t i = 0; i < header->numBooks; i++) {
+			if (postings[i] >= header->numBooks) {
+				return false;
+			}
+		}
+		auto slotsFit = [this](uint64_t offset, uint32_t numSlots, uint32_t numEntries) {
+			const uint32_t* slots = section<uint32_t>(offset);
+			uint32_t numUsed = 0;
+			for (uint32_t s = 0; s < numSlots; s++) {
+				if (slots[s] > numEntries) {
+					return false;
+				}
+				numUsed += slots[s] != 0;
+			}
+			// A full table would make a probe for a missing key loop forever
+			return numUsed < numSlots;
+		};
+		return slotsFit(header->titleSlotsOffset, header->numTitleSlots, header->numBooks)
+			&& slotsFit(header->isbnSlotsOffset, header->numISBNSlots, header->numBooks)
+			&& slotsFit(header->authorSlotsOffset, header->numAuthorSlots, header->numAuthors);
+	}
+
+	Book makeBook(uint32_t recordNumber) const {
+		const CatalogImageFormat::BookRecord& record = section<CatalogImageFormat::BookRecord>(header->booksOffset)[recordNumber];
+		Book book;
+		book.title.assign(stringData(record.title), record.title.length);
+		book.author.assign(stringData(record.author), record.author.length);
+		book.ISBN.assign(stringData(record.ISBN), record.ISBN.length);
+		book.numPages = record.numPages;
+		book.isAvailable = record.isAvailable != 0;
+		return book;
+	}
+
+	// Record number of the book with the given title, or -1
+	long long findTitleRecord(const std::string& title) const {
+		if (base == nullptr) {
+			return -1;
+		}
+		std::string key = lowerCaseString(title);
+		const uint32_t* slots = section<uint32_t>(header->titleSlotsOffset);
+		const CatalogImageFormat::BookRecord* records = section<CatalogImageFormat::BookRecord>(header->booksOffset);
+		uint32_t mask = header->numTitleSlots - 1;
+		for (uint32_t slot = static_cast<uint32_t>(FNV1aHash::hash(key)) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+			if (equalsKeyIgnoringCase(records[slots[slot] - 1].title, key)) {
+				return slots[slot] - 1;
+			}
+		}
+		return -1;
+	}
+
+public:
+	CatalogImage() {}
+
+	CatalogImage(const CatalogImage&) = delete;
+	CatalogImage& operator=(const CatalogImage&) = delete;
+
+	~CatalogImage() {
+		close();
+	}
+
+	// Maps the image in fileName, replacing any image that's open; returns false (with nothing open) if the file
+	// can't be opened or isn't a valid image
+	bool open(const std::string& _fileName) {
+		close();
+#ifdef __linux__
+		int fd = ::open(_fileName.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat fileInfo;
+		if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size < static_cast<off_t>(sizeof(CatalogImageFormat::Header))) {
+			::close(fd);
+			return false;
+		}
+		size_t size = static_cast<size_t>(fileInfo.st_size);
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		// The mapping keeps the file's pages, so the descriptor isn't needed after this
+		::close(fd);
+		if (mapping == MAP_FAILED) {
+			return false;
+		}
+		base = static_cast<const char*>(mapping);
+#else
+		std::ifstream imageFile(_fileName, std::ios::binary | std::ios::ate);
+		if (!imageFile) {
+			return false;
+		}
+		std::streamoff fileSize = imageFile.tellg();
+		if (fileSize < static_cast<std::streamoff>(sizeof(CatalogImageFormat::Header))) {
+			return false;
+		}
+		size_t size = static_cast<size_t>(fileSize);
+		fileData.resize(size);
+		imageFile.seekg(0);
+		if (!imageFile.read(fileData.data(), static_cast<std::streamsize>(size))) {
+			close();
+			return false;
+		}
+		base = fileData.data();
+#endif
+		mappedSize = size;
+		header = reinterpret_cast<const CatalogImageFormat::Header*>(base);
+		if (!isValid(size)) {
+			close();
+			return false;
+		}
+		fileName = _fileName;
+#ifdef __linux__
+		fileInode = fileInfo.st_ino;
+#endif
+		return true;
+	}
+
+	// Unmaps the image, if one is open
+	void close() {
+#ifdef __linux__
+		if (base != nullptr) {
+			munmap(const_cast<char*>(base), mappedSize);
+		}
+		fileInode = 0;
+#else
+		std::vector<char>().swap(fileData);
+#endif
+		base = nullptr;
+		mappedSize = 0;
+		header = nullptr;
+	}
+
+	bool isOpen() const {
+		return base != nullptr;
+	}
+
+	// If a new image was published over the open one, maps the new one instead and returns true. If the new one can't
+	// be mapped, the old one stays open.
+	bool reopenIfChanged() {
+		if (fileName.empty()) {
+			return false;
+		}
+#ifdef __linux__
+		struct stat fileInfo;
+		if (stat(fileName.c_str(), &fileInfo) != 0 || fileInfo.st_ino == fileInode) {
+			return false;
+		}
+#else
+		CatalogImageFormat::Header fileHeader;
+		std::ifstream imageFile(fileName, std::ios::binary);
+		if (!imageFile.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) || fileHeader.generation == getGeneration()) {
+			return false;
+		}
+#endif
+		CatalogImage newImage;
+		if (!newImage.open(fileName)) {
+			return false;
+		}
+		close();
+		base = newImage.base;
+		mappedSize = newImage.mappedSize;
+		header = newImage.header;
+#ifdef __linux__
+		fileInode = newImage.fileInode;
+#else
+		// Moving the vector keeps its buffer, so base still points into it
+		fileData = std::move(newImage.fileData);
+#endif
+		newImage.base = nullptr;
+		return true;
+	}
+
+	uint64_t getGeneration() const {
+		return base == nullptr ? 0 : header->generation;
+	}
+
+	int getNumBooks() const {
+		return base == nullptr ? 0 : static_cast<int>(header->numBooks);
+	}
+
+	// Size of the mapping in bytes
+	size_t getImageSize() const {
+		return mappedSize;
+	}
+
+	// Returns the book with the given title (in any case); if there isn't one we return a default book object
+	Book getBook(const std::string& title) const {
+		long long recordNumber = findTitleRecord(title);
+		return recordNumber < 0 ? Book() : makeBook(static_cast<uint32_t>(recordNumber));
+	}
+
+	bool isExistingBook(const std::string& title) const {
+		return findTitleRecord(title) >= 0;
+	}
+
+	// Returns the book with the given ISBN; if there isn't one we return a default book object
+	Book getBookByISBN(const std::string& ISBN) const {
+		if (base == nullptr) {
+			return Book();
+		}
+		const uint32_t* slots = section<uint32_t>(header->isbnSlotsOffset);
+		const CatalogImageFormat::BookRecord* records = section<CatalogImageFormat::BookRecord>(header->booksOffset);
+		uint32_t mask = header->numISBNSlots - 1;
+		for (uint32_t slot = static_cast<uint32_t>(FNV1aHash::hash(ISBN)) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+			if (equalsKey(records[slots[slot] - 1].ISBN, ISBN)) {
+				return makeBook(slots[slot] - 1);
+			}
+		}
+		return Book();
+	}
+
+	// Returns every book by an author, ignoring case, in the order they were written to the image
+	std::vector<Book> findBooksByAuthor(const std::string& author) const {
+		std::vector<Book> matches;
+		if (base == nullptr) {
+			return matches;
+		}
+		std::string key = lowerCaseString(author);
+		const uint32_t* slots = section<uint32_t>(header->authorSlotsOffset);
+		const CatalogImageFormat::AuthorGroup* groups = section<CatalogImageFormat::AuthorGroup>(header->authorGroupsOffset);
+		const uint32_t* postings = section<uint32_t>(header->authorPostingsOffset);
+		uint32_t mask = header->numAuthorSlots - 1;
+		for (uint32_t slot = static_cast<uint32_t>(FNV1aHash::hash(key)) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+			const CatalogImageFormat::AuthorGroup& group = groups[slots[slot] - 1];
+			if (equalsKeyIgnoringCase(group.author, key)) {
+				for (uint32_t i = 0; i < group.numPostings; i++) {
+					matches.push_back(makeBook(postings[group.firstPosting + i]));
+				}
+				break;
+			}
+		}
+		return matches;
+	}
+};
+
+#endif
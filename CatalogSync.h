@@ -0,0 +1,194 @@
+#ifndef CATALOGSYNC_H
+#define CATALOGSYNC_H
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Book.h"
+#include "TaskScheduler.h"
+#include "LazyCatalog.h"
+
+/*
++ Delta import: brings a library's books in line with a fresh bookData.txt (see BookLibrary::syncBooks) without
+reloading it. Every record in the file and every book in the library gets a fingerprint, a hash of its title, author,
+ISBN and pages, and the two sides are matched up by ISBN: a record with an ISBN the library doesn't have is added, one
+whose fingerprint differs from its book's is applied to that book, and a book whose ISBN isn't in the file any more is
+removed. Everything else is left as it is, so a nightly file that changed in a few places costs a read of the file and
+a few changes, not a full reload.
+
++ Reading and fingerprinting the file is split into chunks that run on the background scheduler; this file has that
+part and the report. Matching and applying the changes happen on the library's own thread, since BookLibrary has no
+locks.
+*/
+
+enum CatalogChangeType { CHANGE_ADDED, CHANGE_UPDATED, CHANGE_REMOVED, CHANGE_KEPT_ON_LOAN, CHANGE_REJECTED };
+
+// One change (or change that couldn't be made) from a sync
+struct CatalogChange {
+	CatalogChangeType type = CHANGE_ADDED;
+	std::string ISBN;
+	std::string title; // the book's title after the change (before it, for removals)
+	std::string reason; // why a change was rejected
+};
+
+// What a sync did; applied is false if the file couldn't be read, in which case nothing changed
+struct SyncReport {
+	bool applied = false;
+	int numRecords = 0;
+	int numAdded = 0;
+	int numUpdated = 0;
+	int numRemoved = 0;
+	int numUnchanged = 0;
+	int numKeptOnLoan = 0; // books that aren't in the file any more but are issued, so they stay until they're returned
+	int numRejected = 0; // records that couldn't be applied, e.g. a new title that another book already has
+	std::vector<CatalogChange> changes; // every change except the unchanged books, in the order they were made
+
+	void record(CatalogChangeType type, const Book& book, std::string reason = "") {
+		changes.push_back({type, book.ISBN, book.title, std::move(reason)});
+		int* counts[] = { &numAdded, &numUpdated, &numRemoved, &numKeptOnLoan, &numRejected };
+		*counts[type] += 1;
+	}
+};
+
+const char* const catalogChangeNames[] = { "added", "updated", "removed", "kept on loan", "rejected" };
+
+// Fingerprint of a book's catalog fields (FNV-1a, with a separator after each field so they can't run together)
+inline uint64_t fingerprintFields(const char* title, size_t titleLength, const char* author, size_t authorLength, const char* ISBN, size_t ISBNLength, int numPages) {
+	uint64_t hashValue = 14695981039346656037ULL;
+	auto addBytes = [&hashValue](const char* bytes, size_t length) {
+		for (size_t i = 0; i < length; i++) {
+			hashValue ^= static_cast<unsigned char>(bytes[i]);
+			hashValue *= 1099511628211ULL;
+		}
+		hashValue ^= 0x1f;
+		hashValue *= 1099511628211ULL;
+	};
+	addBytes(title, titleLength);
+	addBytes(author, authorLength);
+	addBytes(ISBN, ISBNLength);
+	addBytes(reinterpret_cast<const char*>(&numPages), sizeof(numPages));
+	return hashValue;
+}
+
+inline uint64_t bookFingerprint(const Book& book) {
+	return fingerprintFields(book.title.data(), book.title.size(), book.author.data(), book.author.size(), book.ISBN.data(), book.ISBN.size(), book.numPages);
+}
+
+/*
++ A book data file (in loadBookData's format) read for a sync: the ISBN and fingerprint of every record, in file order.
+Reading maps the file and cuts it into chunks of records, which are scanned on the scheduler (or right here, with no
+scheduler). An ordinary record is fingerprinted straight from the file's bytes, and only its ISBN is copied out, since
+most records in a nightly file haven't changed; getBook parses the whole record for the ones that have.
+*/
+class SyncSourceFile {
+private:
+	struct Record {
+		uint64_t fingerprint = 0;
+		std::string ISBN;
+		size_t start = 0;
+		size_t end = 0;
+		bool isBook = false; // false if loadBookData couldn't read it as a book either
+	};
+
+	std::shared_ptr<MappedDataFile> file;
+	char delimiter = ',';
+	std::vector<Record> records;
+
+	// Fills in a record's ISBN and fingerprint; reads it the way splitLine would, finding the fields in place unless
+	// it has quotes in it
+	static void scanRecord(const char* data, char delimiter, Record& record) {
+		const char* fieldStart[4];
+		size_t fieldLength[4];
+		size_t position = record.start;
+		bool plain = std::memchr(data + record.start, '"', record.end - record.start) == nullptr;
+		for (int i = 0; i < 4 && plain; i++) {
+			const char* fieldEnd = static_cast<const char*>(std::memchr(data + position, delimiter, record.end - position));
+			size_t stop = fieldEnd != nullptr ? static_cast<size_t>(fieldEnd - data) : record.end;
+			fieldStart[i] = data + position;
+			fieldLength[i] = stop - position;
+			// Fewer than four fields, or an empty last one, is for the full parse to sort out
+			plain = i < 3 ? fieldEnd != nullptr : fieldLength[i] > 0;
+			position = stop + 1;
+		}
+		if (!plain) {
+			Book book;
+			record.isBook = LazyBookCatalog::parseRecord(data, record.start, record.end, delimiter, book);
+			record.ISBN = book.ISBN;
+			record.fingerprint = record.isBook ? bookFingerprint(book) : 0;
+			return;
+		}
+		int numPages = std::stoi(std::string(fieldStart[3], fieldLength[3]));
+		record.isBook = true;
+		record.ISBN.assign(fieldStart[2], fieldLength[2]);
+		record.fingerprint = fingerprintFields(fieldStart[0], fieldLength[0], fieldStart[1], fieldLength[1], fieldStart[2], fieldLength[2], numPages);
+	}
+
+public:
+	// Reads the file; returns false if it can't be read
+	bool read(const std::string& fileName, char _delimiter, TaskScheduler* scheduler) {
+		static const size_t recordsPerChunk = 4096;
+		file = std::make_shared<MappedDataFile>();
+		records.clear();
+		if (!file->open(fileName)) {
+			return false;
+		}
+		delimiter = _delimiter;
+		// Finding where the records are only needs the line breaks, which is quick next to reading them
+		const char* data = file->data;
+		size_t position = LazyBookCatalog::skipLineBreaks(data, 0, file->size);
+		while (position < file->size) {
+			Record record;
+			record.start = position;
+			record.end = LazyBookCatalog::recordEnd(data, position, file->size, delimiter);
+			position = LazyBookCatalog::skipLineBreaks(data, record.end, file->size);
+			records.push_back(std::move(record));
+		}
+		// Each job fills in its own chunk of the records
+		std::vector<TaskHandle<void>> jobs;
+		char chunkDelimiter = delimiter;
+		for (size_t first = 0; first < records.size(); first += recordsPerChunk) {
+			Record* chunk = records.data() + first;
+			size_t numRecords = std::min(recordsPerChunk, records.size() - first);
+			jobs.push_back(runInBackground(scheduler, [data, chunkDelimiter, chunk, numRecords]() {
+				for (size_t i = 0; i < numRecords; i++) {
+					scanRecord(data, chunkDelimiter, chunk[i]);
+				}
+			}));
+		}
+		// Every job has to be done with the records before a bad one's exception is passed on
+		for (size_t i = 0; i < jobs.size(); i++) {
+			jobs[i].wait();
+		}
+		for (size_t i = 0; i < jobs.size(); i++) {
+			jobs[i].get();
+		}
+		return true;
+	}
+
+	size_t getNumRecords() {
+		return records.size();
+	}
+
+	bool isBook(size_t record) {
+		return records[record].isBook;
+	}
+
+	const std::string& getISBN(size_t record) {
+		return records[record].ISBN;
+	}
+
+	uint64_t getFingerprint(size_t record) {
+		return records[record].fingerprint;
+	}
+
+	// The whole record as a book, parsed the way loadBookData would; a default book if it isn't one
+	Book getBook(size_t record) {
+		Book book;
+		if (!LazyBookCatalog::parseRecord(file->data, records[record].start, records[record].end, delimiter, book)) {
+			book = Book();
+		}
+		return book;
+	}
+};
+
+#endif
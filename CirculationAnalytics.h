@@ -0,0 +1,334 @@
+#ifndef CIRCULATIONANALYTICS_H
+#define CIRCULATIONANALYTICS_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "Book.h"
+#include "Student.h"
+#include "HashTable.h"
+#include "utilities.h"
+
+/*
++ Circulation analytics: counts how often each title, student and author shows up in issues, as the issues happen,
+without keeping the events themselves. By default each of those is counted in a fixed amount of memory, however many
+different titles, students or authors there are:
+
+	- A count-min sketch estimates the count of any key. It's depth rows of width counters; a key adds to one counter in
+	each row, and its estimate is the smallest of those. Other keys landing on the same counters can only make an
+	estimate too high, never too low, and with width w it's off by at most about (2 / w) * total events with high
+	probability.
+	- A space-saving summary keeps the heavyHitters keys that look most frequent, with their counts, for top-K queries.
+	A key that isn't being tracked takes the place of the one with the smallest count, starting from that count (which
+	is kept as the key's error). Any key with more than total / heavyHitters events is guaranteed to be tracked.
+
++ NOTE: With exact counting on, every key gets its own counter in a HashTable instead, so counts and top-K are exact but
+the memory grows with the number of different keys.
+*/
+
+// One key from a top-K query: its count, and how much of that count might belong to other keys (0 when exact)
+struct CirculationCount {
+	std::string key;
+	long long count = 0;
+	long long error = 0;
+};
+
+// Count-min sketch over string keys
+class CountMinSketch {
+private:
+	int width; // counters per row, a power of two
+	int depth;
+	std::vector<uint32_t> counters; // counters[row * width + column]
+
+	// Column of a key in a row: its hash spread differently for each row (the splitmix64 finalizer, with a different
+	// offset per row), so two keys that share a column in one row are no more likely to share one in the next
+	int column(uint64_t keyHash, int row) const {
+		uint64_t mixed = keyHash + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(row + 1);
+		mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+		mixed ^= mixed >> 31;
+		return static_cast<int>(mixed & static_cast<uint64_t>(width - 1));
+	}
+
+public:
+	CountMinSketch(int _width = 2048, int _depth = 4) : width(_width), depth(_depth) {
+		counters.assign(static_cast<size_t>(width) * depth, 0);
+	}
+
+	// Adds to a key's count. Only the counters that are at the key's current estimate go up (a conservative update),
+	// which keeps the estimates of other keys from growing more than they have to.
+	void add(const std::string& key, uint32_t count = 1) {
+		uint64_t keyHash = FNV1aHash::hash(key);
+		uint32_t newEstimate = estimateHash(keyHash) + count;
+		for (int row = 0; row < depth; row++) {
+			uint32_t& counter = counters[static_cast<size_t>(row) * width + column(keyHash, row)];
+			if (counter < newEstimate) {
+				counter = newEstimate;
+			}
+		}
+	}
+
+	uint32_t estimateHash(uint64_t keyHash) const {
+		uint32_t estimate = UINT32_MAX;
+		for (int row = 0; row < depth; row++) {
+			uint32_t counter = counters[static_cast<size_t>(row) * width + column(keyHash, row)];
+			if (counter < estimate) {
+				estimate = counter;
+			}
+		}
+		return estimate;
+	}
+
+	// Estimated count of a key; never lower than the real count
+	uint32_t estimate(const std::string& key) const {
+		return estimateHash(FNV1aHash::hash(key));
+	}
+
+	void clear() {
+		counters.assign(counters.size(), 0);
+	}
+
+	size_t getMemoryBytes() const {
+		return counters.size() * sizeof(uint32_t);
+	}
+};
+
+// Space-saving summary of the most frequent keys. The entries stay where they are and a min-heap of entry numbers,
+// ordered by count, keeps the one to replace on top; the HashTable from key to entry number only changes when a key
+// is replaced, so moving entries around the heap doesn't touch it.
+class SpaceSavingSummary {
+private:
+	size_t capacity;
+	std::vector<CirculationCount> entries;
+	std::vector<int> heapPositions; // where each entry is in the heap
+	std::vector<int> heap; // entry numbers
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> entryNumbers; // entry number of each tracked key
+
+	long long countAt(size_t i) const {
+		return entries[heap[i]].count;
+	}
+
+	void swapHeap(size_t i, size_t j) {
+		std::swap(heap[i], heap[j]);
+		heapPositions[heap[i]] = static_cast<int>(i);
+		heapPositions[heap[j]] = static_cast<int>(j);
+	}
+
+	// Moves an entry whose count went up down the heap, until both its children have counts at least as big
+	void siftDown(size_t i) {
+		while (true) {
+			size_t smallest = i;
+			size_t left = 2 * i + 1;
+			size_t right = 2 * i + 2;
+			if (left < heap.size() && countAt(left) < countAt(smallest)) {
+				smallest = left;
+			}
+			if (right < heap.size() && countAt(right) < countAt(smallest)) {
+				smallest = right;
+			}
+			if (smallest == i) {
+				return;
+			}
+			swapHeap(i, smallest);
+			i = smallest;
+		}
+	}
+
+public:
+	SpaceSavingSummary(size_t _capacity = 256) : capacity(_capacity) {}
+
+	void add(const std::string& key) {
+		int* entryNumber = entryNumbers.findValue(key);
+		if (entryNumber != nullptr) {
+			entries[*entryNumber].count += 1;
+			siftDown(heapPositions[*entryNumber]);
+			return;
+		}
+		if (entries.size() < capacity) {
+			CirculationCount entry;
+			entry.key = key;
+			entry.count = 1;
+			entries.push_back(entry);
+			int newEntry = static_cast<int>(entries.size()) - 1;
+			entryNumbers.insertPair(key, newEntry);
+			heap.push_back(newEntry);
+			heapPositions.push_back(newEntry);
+			// A count of 1 is as small as any, so it moves up past every entry with a bigger count
+			size_t i = heap.size() - 1;
+			while (i > 0 && countAt((i - 1) / 2) > countAt(i)) {
+				swapHeap(i, (i - 1) / 2);
+				i = (i - 1) / 2;
+			}
+			return;
+		}
+		// Replace the key with the smallest count, which the new key inherits as its error
+		CirculationCount& smallest = entries[heap[0]];
+		entryNumbers.deletePair(smallest.key);
+		smallest.error = smallest.count;
+		smallest.count += 1;
+		smallest.key = key;
+		entryNumbers.insertPair(key, heap[0]);
+		siftDown(0);
+	}
+
+	// The k tracked keys with the highest counts, highest first
+	std::vector<CirculationCount> top(size_t k) const {
+		auto selector = makeTopKSelector<CirculationCount>(k, [](const CirculationCount& first, const CirculationCount& second) {
+			return first.count > second.count || (first.count == second.count && first.key < second.key);
+		});
+		for (size_t i = 0; i < entries.size(); i++) {
+			selector.push(entries[i]);
+		}
+		return selector.takeSorted();
+	}
+
+	void clear() {
+		entries.clear();
+		heapPositions.clear();
+		heap.clear();
+		entryNumbers.destroyHashTable();
+	}
+};
+
+// Counts for one kind of key (titles, students or authors), either sketched or exact
+class CirculationCounter {
+private:
+	bool exact;
+	CountMinSketch sketch;
+	SpaceSavingSummary heavyHitters;
+	HashTable<long long, std::string, FNV1aHash, PowerOfTwoBucketCount> exactCounts;
+
+public:
+	CirculationCounter(bool _exact = false) : exact(_exact) {}
+
+	void add(const std::string& key) {
+		if (exact) {
+			long long* count = exactCounts.findValue(key);
+			if (count != nullptr) {
+				*count += 1;
+			} else {
+				exactCounts.insertPair(key, 1);
+			}
+			return;
+		}
+		sketch.add(key);
+		heavyHitters.add(key);
+	}
+
+	long long getCount(const std::string& key) {
+		if (exact) {
+			long long* count = exactCounts.findValue(key);
+			return count == nullptr ? 0 : *count;
+		}
+		return sketch.estimate(key);
+	}
+
+	std::vector<CirculationCount> top(size_t k) {
+		if (!exact) {
+			return heavyHitters.top(k);
+		}
+		auto selector = makeTopKSelector<CirculationCount>(k, [](const CirculationCount& first, const CirculationCount& second) {
+			return first.count > second.count || (first.count == second.count && first.key < second.key);
+		});
+		exactCounts.forEachPair([&selector](const std::string& key, long long count) {
+			CirculationCount entry;
+			entry.key = key;
+			entry.count = count;
+			selector.push(entry);
+		});
+		return selector.takeSorted();
+	}
+
+	// Empties the counts, switching between exact and sketched counting
+	void reset(bool _exact) {
+		exact = _exact;
+		sketch.clear();
+		heavyHitters.clear();
+		exactCounts.destroyHashTable();
+	}
+};
+
+// Analytics fed by the library's issues and returns
+class CirculationAnalytics {
+private:
+	bool exact = false;
+	CirculationCounter titleCounts;
+	CirculationCounter studentCounts; // by student ID
+	CirculationCounter authorCounts;
+	long long numIssues = 0;
+	long long numReturns = 0;
+	long long totalLoanSeconds = 0; // summed over the returns
+
+public:
+	CirculationAnalytics() {}
+
+	void recordIssue(const Book& book, const Student& student) {
+		titleCounts.add(book.title);
+		studentCounts.add(student.getStudentID());
+		authorCounts.add(book.author);
+		numIssues += 1;
+	}
+
+	void recordReturn(long long loanSeconds) {
+		numReturns += 1;
+		totalLoanSeconds += loanSeconds;
+	}
+
+	// Turns exact counting on or off; the counts start over either way
+	void setExact(bool _exact) {
+		exact = _exact;
+		clear();
+	}
+
+	bool isExact() {
+		return exact;
+	}
+
+	void clear() {
+		titleCounts.reset(exact);
+		studentCounts.reset(exact);
+		authorCounts.reset(exact);
+		numIssues = 0;
+		numReturns = 0;
+		totalLoanSeconds = 0;
+	}
+
+	std::vector<CirculationCount> getTopTitles(size_t k) {
+		return titleCounts.top(k);
+	}
+
+	std::vector<CirculationCount> getTopStudents(size_t k) {
+		return studentCounts.top(k);
+	}
+
+	std::vector<CirculationCount> getTopAuthors(size_t k) {
+		return authorCounts.top(k);
+	}
+
+	long long getTitleCount(const std::string& title) {
+		return titleCounts.getCount(title);
+	}
+
+	long long getStudentCount(const std::string& studentID) {
+		return studentCounts.getCount(studentID);
+	}
+
+	long long getAuthorCount(const std::string& author) {
+		return authorCounts.getCount(author);
+	}
+
+	long long getNumIssues() {
+		return numIssues;
+	}
+
+	long long getNumReturns() {
+		return numReturns;
+	}
+
+	// Average length of the loans that have been returned, in seconds
+	double getAverageLoanSeconds() {
+		return numReturns > 0 ? static_cast<double>(totalLoanSeconds) / numReturns : 0.0;
+	}
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef FIXEDHASHTABLE_H
+#define FIXEDHASHTABLE_H
+#include <array>
+#include <cstddef>
+#include "HashTable.h"
+
+/*
++ Hash table with a capacity that's fixed at compile time, for builds like the kiosks that shouldn't touch the heap.
+All of the slots live inside the object itself (in std::arrays), and it uses open addressing with linear probing rather
+than chaining, so there are no nodes to allocate. The capacity has to be a power of two so the index is a bitmask.
+
++ NOTE: It never grows, so insertPair returns false once every slot has a pair in it. Deleted slots are marked as
+deleted (rather than emptied) so that probes for keys further along still find them, and they're reused by inserts.
+
++ NOTE: It's only heap free when the keys and values are, e.g. FixedHashTable<int, long long, 1024> keyed by ISBN.
+*/
+template <class U, class K, int capacity, class Hash = IntegerHash>
+class FixedHashTable {
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "FixedHashTable capacity must be a power of two");
+private:
+	enum SlotState : unsigned char { EMPTY_SLOT, USED_SLOT, DELETED_SLOT };
+	static constexpr int mask = capacity - 1;
+	std::array<K, capacity> keys;
+	std::array<U, capacity> values;
+	std::array<SlotState, capacity> states;
+	int numPairs;
+
+	// Index of the slot holding the key, or -1 if it's not in the table
+	int findSlot(const K& key) const {
+		int index = static_cast<int>(Hash::hash(key) & mask);
+		for (int probes = 0; probes < capacity; probes++) {
+			if (states[index] == EMPTY_SLOT) {
+				return -1;
+			}
+			if (states[index] == USED_SLOT && keys[index] == key) {
+				return index;
+			}
+			index = (index + 1) & mask;
+		}
+		return -1;
+	}
+
+public:
+	FixedHashTable() {
+		states.fill(EMPTY_SLOT);
+		numPairs = 0;
+	}
+
+	// Removes every pair
+	void destroyHashTable() {
+		states.fill(EMPTY_SLOT);
+		numPairs = 0;
+	}
+
+	// Inserts a new key-value pair; returns false if the key already exists or the table is full
+	bool insertPair(const K& key, const U& value) {
+		if (numPairs == capacity || findSlot(key) >= 0) {
+			return false;
+		}
+		// Take the first slot that isn't in use, which might be one that had its pair deleted
+		int index = static_cast<int>(Hash::hash(key) & mask);
+		while (states[index] == USED_SLOT) {
+			index = (index + 1) & mask;
+		}
+		keys[index] = key;
+		values[index] = value;
+		states[index] = USED_SLOT;
+		numPairs += 1;
+		return true;
+	}
+
+	// Deletes the pair with the given key; returns false if there isn't one
+	bool deletePair(const K& key) {
+		int index = findSlot(key);
+		if (index < 0) {
+			return false;
+		}
+		states[index] = DELETED_SLOT;
+		numPairs -= 1;
+		return true;
+	}
+
+	// Replaces the value stored with the given key; returns false if there isn't one
+	bool updatePair(const K& key, const U& value) {
+		int index = findSlot(key);
+		if (index < 0) {
+			return false;
+		}
+		values[index] = value;
+		return true;
+	}
+
+	// Gets the value stored with the given key, or a default constructed value if there isn't one
+	U getValue(const K& key) const {
+		int index = findSlot(key);
+		if (index < 0) {
+			return U();
+		}
+		return values[index];
+	}
+
+	// Returns a pointer to the value stored with the given key, or a nullptr if there isn't one
+	U* findValue(const K& key) {
+		int index = findSlot(key);
+		if (index < 0) {
+			return nullptr;
+		}
+		return &values[index];
+	}
+
+	bool isExistingKey(const K& key) const {
+		return findSlot(key) >= 0;
+	}
+
+	int getNumPairs() const {
+		return numPairs;
+	}
+
+	static constexpr int getCapacity() {
+		return capacity;
+	}
+};
+
+#endif
@@ -1,39 +1,176 @@
 #ifndef HashTable_H
 #define HashTable_H
+#include <string>
+#include <cstddef>
+#include <cstdint>
 #include "linkedList.h"
+#include "LibraryMetrics.h"
 /*
 
-+ Class for general hash table that uses strings keys, but the values can be flexible. The 
-hash table uses separate chaining, and the time complexity for most operations is O(n) rather than constant time
-due to the fact that we check whether a key is valid often when we manipulate the hash table.
++ Class for general hash table with flexible keys and values. The hash table uses separate chaining, and the time
+complexity for most operations is O(n) rather than constant time due to the fact that we check whether a key is
+valid often when we manipulate the hash table.
 
-+ NOTE: Since our specific hashtable is only going to take strings for keys,
-due to the fact that we're using modular/division hash, we replace template class T with
-std::string for better readability. We keep class template U because we won't do anything where it's datatype
-would be an issue, unlike the keys where we are solely hashing strings. As a result, now our linked lists only
-accept nodes that have string datatype for keys, while our values should be flexible.
++ NOTE: How a key turns into a bucket is picked at compile time with two policies, so there's no runtime dispatch:
+	- Hash turns a key into a number: SumOfCharsHash (the original modular/division hash on the sum of the
+	  characters), FNV1aHash for strings, or IntegerHash for integer keys like ISBNs or student IDs, which skips
+	  string hashing entirely
+	- BucketCount turns that number into a bucket: PrimeBucketCount uses % on a prime number of buckets, and
+	  PowerOfTwoBucketCount keeps the bucket count a power of two so the index is just a bitmask
+The defaults are string keys with SumOfCharsHash and PrimeBucketCount, which is how the table has always worked, so
+HashTable<U> means the same thing it always has. For a table with a fixed capacity that never touches the heap, see
+FixedHashTable.h.
+
++ NOTE: Once the average chain gets longer than maxLoadFactor nodes, the table grows to the bucket count's next size
+(the next prime that's at least double, or just double). Growing moves the existing nodes over to their new buckets
+rather than copying them, so values stay at the same address.
 */
-template <class U>
+
+// Hash policies
+
+// Sum of the character codes. It's cheap, but anagrams collide, and the sums don't get very big, so in a big table
+// most of the buckets never get used
+struct SumOfCharsHash {
+	static size_t hash(const std::string& key) {
+		size_t sum = 0;
+		for (size_t i = 0; i < key.length(); i++) {
+			sum += static_cast<unsigned char>(key[i]);
+		}
+		return sum;
+	}
+};
+
+// FNV-1a: every character gets mixed into all of the bits, so similar strings (like titles in a series) spread out
+struct FNV1aHash {
+	static size_t hash(const std::string& key) {
+		uint64_t hashValue = 14695981039346656037ULL;
+		for (size_t i = 0; i < key.length(); i++) {
+			hashValue ^= static_cast<unsigned char>(key[i]);
+			hashValue *= 1099511628211ULL;
+		}
+		return static_cast<size_t>(hashValue);
+	}
+};
+
+// For integer keys. Multiplying by 2^64 / golden ratio (Fibonacci hashing) and folding the high half down spreads
+// out keys that only differ in their last digits, which matters when the bucket index is a bitmask of the low bits
+struct IntegerHash {
+	template <class K>
+	static size_t hash(K key) {
+		uint64_t hashValue = static_cast<uint64_t>(key) * 11400714819323198485ULL;
+		return static_cast<size_t>(hashValue ^ (hashValue >> 32));
+	}
+};
+
+// Bucket count policies
+
+// Any number of buckets to start with, growing to primes; the index is hash % numBuckets
+struct PrimeBucketCount {
+	static bool isPrime(int number) {
+		if (number < 2) {
+			return false;
+		}
+		for (int divisor = 2; divisor * divisor <= number; divisor++) {
+			if (number % divisor == 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static int initialBucketCount(int requested) {
+		return requested < 1 ? 1 : requested;
+	}
+
+	// The smallest prime that's at least double the current count
+	static int nextBucketCount(int current) {
+		int next = current * 2 + 1;
+		while (!isPrime(next)) {
+			next += 2;
+		}
+		return next;
+	}
+
+	static int bucketIndex(size_t hashValue, int numBuckets) {
+		return static_cast<int>(hashValue % static_cast<size_t>(numBuckets));
+	}
+};
+
+// Power of two buckets, so the index is hash & (numBuckets - 1) rather than a division. Only use this with a hash
+// that mixes its low bits well (FNV1aHash or IntegerHash, not SumOfCharsHash).
+struct PowerOfTwoBucketCount {
+	static int initialBucketCount(int requested) {
+		int count = 1;
+		while (count < requested) {
+			count *= 2;
+		}
+		return count;
+	}
+
+	static int nextBucketCount(int current) {
+		return current * 2;
+	}
+
+	static int bucketIndex(size_t hashValue, int numBuckets) {
+		return static_cast<int>(hashValue & static_cast<size_t>(numBuckets - 1));
+	}
+};
+
+template <class U, class K = std::string, class Hash = SumOfCharsHash, class BucketCount = PrimeBucketCount>
 class HashTable {
 private:
 	int numBuckets; // size of the hash table
-	HTLinkedList<std::string, U>* buckets; // underlying array of a hash table
+	HTLinkedList<K, U>* buckets; // underlying array of a hash table
 	int numPairs; // number of pairs that exist in the hash table
+	long long numResizes = 0; // number of times the table has grown
+	static const int maxLoadFactor = 2; // average nodes per bucket allowed before the table grows
+#ifdef BOOKLIBRARY_METRICS
+	LatencyHistogram chainWalks; // nodes looked at by each lookup
+#endif
+
+	// Records how far the last search in a bucket had to walk down the chain
+	void recordChainWalk(int index) {
+#ifdef BOOKLIBRARY_METRICS
+		chainWalks.recordValue(static_cast<uint64_t>(buckets[index].getLastSearchLength()));
+#else
+		(void)index;
+#endif
+	}
+
+	// Moves every node into a new array of buckets, with the bucket count policy's next size
+	void grow() {
+		int newNumBuckets = BucketCount::nextBucketCount(numBuckets);
+		HTLinkedList<K, U>* oldBuckets = buckets;
+		int oldNumBuckets = numBuckets;
+		buckets = new HTLinkedList<K, U>[newNumBuckets];
+		numBuckets = newNumBuckets;
+		for (int i = 0; i < oldNumBuckets; i++) {
+			HTNode<K, U>* node = oldBuckets[i].detachHead();
+			while (node != nullptr) {
+				buckets[bucketIndex(node->key)].attachLast(node);
+				node = oldBuckets[i].detachHead();
+			}
+		}
+		delete[] oldBuckets;
+		numResizes += 1;
+	}
 public:
-	// Constructor: apparently using prime numbers is good for improving distribution
+	// Constructor: apparently using prime numbers is good for improving distribution (PowerOfTwoBucketCount rounds
+	// this up to a power of two)
 	HashTable(int _numBuckets = 17) {
-		numBuckets = _numBuckets;
+		numBuckets = BucketCount::initialBucketCount(_numBuckets);
 		numPairs = 0;
-		buckets = new HTLinkedList<std::string, U>[numBuckets];
+		buckets = new HTLinkedList<K, U>[numBuckets];
 		// Fill array up with empty linked lists; when the linked list 
 		// is empty, we know the bucket is empty
 		for (int i = 0; i < numBuckets; i++) {
-			buckets[i] = HTLinkedList<std::string, U>();
+			buckets[i] = HTLinkedList<K, U>();
 		}
 	}
 
-	// Destructor
+	// Destructor; the linked lists don't free their own nodes, so clear them first
 	~HashTable() {
+		destroyHashTable();
 		delete[] buckets;
 	}
 
@@ -49,26 +186,49 @@ public:
 
 	// Inserts a new key-value pair into one of the linked lists stored in the 
 	// hash table
-	bool insertPair(std::string key, U value) {
+	bool insertPair(const K& key, const U& value) {
+		return insertPairAndFind(key, value) != nullptr;
+	}
+
+	// Same as insertPair, but returns a pointer to the value stored in the table, or a nullptr if the key already exists.
+	// An rvalue is only moved from when the pair is actually inserted, so on failure the caller still has its value.
+	template <class V>
+	U* insertPairAndFind(const K& key, V&& value) {
 		// Get the index of the linked list 
-		int index = modularHash(key);
+		int index = bucketIndex(key);
 		// If pair already exists, then we are erroneously trying to add a duplicate key to the hash table
 		// So stop the function call early and output a warning
-		if (isExistingKey(key)) {
-			return false;
+		bool exists = buckets[index].isExistingNode(key);
+		recordChainWalk(index);
+		if (exists) {
+			return nullptr;
 		}
-		// Else insert the valid pair at the end of the linked list, and increment number of pairs
-		buckets[index].insertLast(key, value);
+		return insertNewPair(key, std::forward<V>(value));
+	}
+
+	// Inserts a pair whose key the caller already knows isn't in the table (for example because a Bloom filter said
+	// so), without searching the chain for it first; returns a pointer to the stored value
+	template <class V>
+	U* insertNewPair(const K& key, V&& value) {
+		int index = bucketIndex(key);
+		// Insert the pair at the end of the linked list, and increment number of pairs
+		// NOTE: Growing moves nodes rather than copying them, so the node stays valid after grow()
+		HTNode<K, U>* newNode = buckets[index].insertLast(key, std::forward<V>(value));
 		numPairs += 1;
-		return true;
+		if (numPairs > numBuckets * maxLoadFactor) {
+			grow();
+		}
+		return &newNode->info;
 	}
 
 	// Delete a pair from the hashmap by using the key of that pair
-	bool deletePair(std::string key) {
-		int index = modularHash(key);
+	bool deletePair(const K& key) {
+		int index = bucketIndex(key);
 		// If the key-value pair doesn't already exist, then show an error message saying that
 		// the program is trying to delete a pair with a key that doesn't exist in the hash table.
-		if (!isExistingKey(key)) {
+		bool exists = buckets[index].isExistingNode(key);
+		recordChainWalk(index);
+		if (!exists) {
 			return false;
 		}
 		// Else it does exist, so delete the node with the corresponding key; decrement number of pairs
@@ -77,16 +237,36 @@ public:
 		return true;
 	}
 
+	// Gives a pair a new key, moving its node to the new key's bucket rather than copying the value, so the value stays
+	// at the same address. Returns a pointer to it, or a nullptr (changing nothing) if there's no pair with oldKey or
+	// there's already one with newKey.
+	U* rekeyPair(const K& oldKey, const K& newKey) {
+		int newIndex = bucketIndex(newKey);
+		bool exists = buckets[newIndex].isExistingNode(newKey);
+		recordChainWalk(newIndex);
+		if (exists) {
+			return nullptr;
+		}
+		HTNode<K, U>* node = buckets[bucketIndex(oldKey)].detachNode(oldKey);
+		if (node == nullptr) {
+			return nullptr;
+		}
+		node->key = newKey;
+		buckets[newIndex].attachLast(node);
+		return &node->info;
+	}
+
 	/*
 	+ NOTE: The reason updatePair and getValue don't use isExistingPair() and rather just
 	searchNode is because they intend to get and manipulate the nodes, whilst isExistingPair() is used
 	in functions where we aren't really going to
 	*/
 	// Updates the key-value pair, but entering in the key, and then the new value 
-	bool updatePair(std::string key, U value) {
-		int index = modularHash(key);
+	bool updatePair(const K& key, const U& value) {
+		int index = bucketIndex(key);
 		// Get the target node
-		HTNode<std::string, U>* targetNode = buckets[index].searchNode(key);
+		HTNode<K, U>* targetNode = buckets[index].searchNode(key);
+		recordChainWalk(index);
 		// Remember: searchNode() can return a nullptr if it didn't find the node
 		// If it's not an existing key-value pair, show an error
 		if (targetNode == nullptr) {
@@ -98,10 +278,11 @@ public:
 	}
 
 	// Gets a value from the map that's associated with the given key
-	U getValue(std::string key) {
+	U getValue(const K& key) {
 		// Get the index and get the target node
-		int index = modularHash(key);
-		HTNode<std::string, U>* targetNode = buckets[index].searchNode(key);
+		int index = bucketIndex(key);
+		HTNode<K, U>* targetNode = buckets[index].searchNode(key);
+		recordChainWalk(index);
 		// If targetNode == nullptr, we couldn't find the value in the linked list, so we are returning default constructed object
 		if (targetNode == nullptr) {
 			return U();
@@ -110,23 +291,31 @@ public:
 		return targetNode->info;
 	}
 
-	// Division or modular hash; outputs the index that 
-	// the key-value pair should be placed in the array
-	int modularHash(std::string key) {
-		int sum = 0;
-		for (int i = 0; i < static_cast<int>(key.length()); i++) {
-			int asciiValue = static_cast<int>(key[i]);
-			sum += asciiValue;
+	// Returns a pointer to the value stored with the given key, or a nullptr if there isn't one. The pointer stays
+	// valid until that pair is deleted, since nodes are never copied (not even when the table grows).
+	U* findValue(const K& key) {
+		int index = bucketIndex(key);
+		HTNode<K, U>* targetNode = buckets[index].searchNode(key);
+		recordChainWalk(index);
+		if (targetNode == nullptr) {
+			return nullptr;
 		}
-		return sum % numBuckets;
+		return &targetNode->info;
+	}
+
+	// Outputs the index that the key-value pair should be placed in the array
+	int bucketIndex(const K& key) {
+		return BucketCount::bucketIndex(Hash::hash(key), numBuckets);
 	}
 
 	// Determines if a key already exists/is associated with a value in the hash table 
-	bool isExistingKey(std::string key) {
-		int index = modularHash(key);
+	bool isExistingKey(const K& key) {
+		int index = bucketIndex(key);
 		// Access the corresponding linked list, and check its nodes to see if it has a node with that key.
 		// If it does then the key-value pair already exists in our hash-table, else it's a brand new key-value pair.
-		return buckets[index].isExistingNode(key);
+		bool found = buckets[index].isExistingNode(key);
+		recordChainWalk(index);
+		return found;
 	}
 
 	// Function for printing out the hash table
@@ -150,6 +339,49 @@ public:
 		return numPairs;
 	}
 
+	// Returns how full the buckets are and how many times the table has grown; with BOOKLIBRARY_METRICS
+	// it also includes how far lookups have had to walk down the chains
+	HashTableStats getStats() {
+		HashTableStats stats;
+		stats.numBuckets = numBuckets;
+		stats.numPairs = numPairs;
+		stats.resizes = numResizes;
+		for (int i = 0; i < numBuckets; i++) {
+			int length = buckets[i].getLength();
+			if (length == 0) {
+				stats.emptyBuckets += 1;
+			}
+			if (length > stats.longestChain) {
+				stats.longestChain = length;
+			}
+		}
+#ifdef BOOKLIBRARY_METRICS
+		stats.hasLookupStats = true;
+		stats.lookups = chainWalks.getTotalCount();
+		stats.meanChainWalk = chainWalks.getMean();
+		stats.p99ChainWalk = chainWalks.valueAtPercentile(99);
+		stats.maxChainWalk = chainWalks.getMax();
+#endif
+		return stats;
+	}
+
+	// Calls visit(value) on every value in the table, in no particular order. Unlike getAllTableValues this doesn't
+	// copy anything, so callers that only need a few of the values (like a page of a listing) can pick them out.
+	template <class Visitor>
+	void forEachValue(Visitor visit) {
+		for (int i = 0; i < numBuckets; i++) {
+			buckets[i].forEachNode(visit);
+		}
+	}
+
+	// Calls visit(key, value) on every pair in the table, in no particular order
+	template <class Visitor>
+	void forEachPair(Visitor visit) {
+		for (int i = 0; i < numBuckets; i++) {
+			buckets[i].forEachPair(visit);
+		}
+	}
+
 	// Returns a vector with all of the values in the table.
 	std::vector<U> getAllTableValues() {
 		std::vector<U> tableValues;
@@ -0,0 +1,221 @@
+#ifndef HOLDQUEUES_H
+#define HOLDQUEUES_H
+#include <vector>
+
+/*
++ Waitlists for every item (book) at once, kept in one shared pool of hold records instead of a vector per item.
+Items and holders (students) are both small integer IDs. Each hold is linked into two doubly linked lists: its item's
+queue, in the order holds get served, and its holder's list, so "what is this student waiting for" doesn't have to look
+through every queue. Removed hold records are reused, so the pool doesn't grow past the most holds at one time.
+
++ A queue is served highest priority first, and in the order the holds were placed within a priority, so with every
+priority at 0 it's plain FIFO. Adding a hold walks back from the tail of its queue only past holds of lower priority,
+taking the front hold is O(1), and removing a hold is O(1) since it knows its neighbours in both lists.
+
++ NOTE: A hold's position in its queue is found by walking from the front, so it costs the length of that one queue,
+however many holds there are on other items.
+*/
+class HoldQueues {
+private:
+	struct Hold {
+		int itemID = -1; // -1 while the record is free
+		int holderID = -1;
+		int priority = 0;
+		int prevInQueue = -1;
+		int nextInQueue = -1;
+		int prevForHolder = -1;
+		int nextForHolder = -1;
+	};
+	struct Queue {
+		int head = -1;
+		int tail = -1;
+		int length = 0;
+	};
+
+	std::vector<Hold> holds; // every hold record, by hold number
+	std::vector<int> freeHolds; // hold numbers that can be reused
+	std::vector<Queue> queues; // by item ID
+	std::vector<int> holderHeads; // first hold of each holder, by holder ID, in the order they were placed
+	std::vector<int> holderTails;
+	std::vector<int> holderCounts;
+	int numHolds = 0;
+
+	// Links hold h into its item's queue right after hold "after" (or at the front if after is -1)
+	void linkIntoQueue(int h, int after) {
+		Queue& queue = queues[holds[h].itemID];
+		int before = after >= 0 ? holds[after].nextInQueue : queue.head;
+		holds[h].prevInQueue = after;
+		holds[h].nextInQueue = before;
+		if (after >= 0) {
+			holds[after].nextInQueue = h;
+		} else {
+			queue.head = h;
+		}
+		if (before >= 0) {
+			holds[before].prevInQueue = h;
+		} else {
+			queue.tail = h;
+		}
+		queue.length += 1;
+	}
+
+public:
+	HoldQueues() {}
+
+	// Removes every hold
+	void clear() {
+		holds.clear();
+		freeHolds.clear();
+		queues.clear();
+		holderHeads.clear();
+		holderTails.clear();
+		holderCounts.clear();
+		numHolds = 0;
+	}
+
+	// Adds a hold on an item for a holder, behind every hold of the same or higher priority; returns its hold number
+	int addHold(int itemID, int holderID, int priority = 0) {
+		if (itemID >= static_cast<int>(queues.size())) {
+			queues.resize(itemID + 1);
+		}
+		if (holderID >= static_cast<int>(holderHeads.size())) {
+			holderHeads.resize(holderID + 1, -1);
+			holderTails.resize(holderID + 1, -1);
+			holderCounts.resize(holderID + 1, 0);
+		}
+		int h;
+		if (!freeHolds.empty()) {
+			h = freeHolds.back();
+			freeHolds.pop_back();
+		} else {
+			holds.push_back(Hold());
+			h = static_cast<int>(holds.size()) - 1;
+		}
+		holds[h].itemID = itemID;
+		holds[h].holderID = holderID;
+		holds[h].priority = priority;
+
+		int after = queues[itemID].tail;
+		while (after >= 0 && holds[after].priority < priority) {
+			after = holds[after].prevInQueue;
+		}
+		linkIntoQueue(h, after);
+
+		holds[h].prevForHolder = holderTails[holderID];
+		holds[h].nextForHolder = -1;
+		if (holderTails[holderID] >= 0) {
+			holds[holderTails[holderID]].nextForHolder = h;
+		} else {
+			holderHeads[holderID] = h;
+		}
+		holderTails[holderID] = h;
+		holderCounts[holderID] += 1;
+		numHolds += 1;
+		return h;
+	}
+
+	// Removes a hold from its item's queue and its holder's list
+	void removeHold(int h) {
+		Hold& hold = holds[h];
+		Queue& queue = queues[hold.itemID];
+		if (hold.prevInQueue >= 0) {
+			holds[hold.prevInQueue].nextInQueue = hold.nextInQueue;
+		} else {
+			queue.head = hold.nextInQueue;
+		}
+		if (hold.nextInQueue >= 0) {
+			holds[hold.nextInQueue].prevInQueue = hold.prevInQueue;
+		} else {
+			queue.tail = hold.prevInQueue;
+		}
+		queue.length -= 1;
+		if (hold.prevForHolder >= 0) {
+			holds[hold.prevForHolder].nextForHolder = hold.nextForHolder;
+		} else {
+			holderHeads[hold.holderID] = hold.nextForHolder;
+		}
+		if (hold.nextForHolder >= 0) {
+			holds[hold.nextForHolder].prevForHolder = hold.prevForHolder;
+		} else {
+			holderTails[hold.holderID] = hold.prevForHolder;
+		}
+		holderCounts[hold.holderID] -= 1;
+		numHolds -= 1;
+		hold = Hold();
+		freeHolds.push_back(h);
+	}
+
+	// Hold number of the hold that's served next for an item, or -1 if nobody is waiting for it
+	int frontHold(int itemID) const {
+		return itemID >= 0 && itemID < static_cast<int>(queues.size()) ? queues[itemID].head : -1;
+	}
+
+	// Hold number of a holder's hold on an item, or -1 if they don't have one; looks through the holder's holds
+	int findHold(int itemID, int holderID) const {
+		if (holderID < 0 || holderID >= static_cast<int>(holderHeads.size())) {
+			return -1;
+		}
+		for (int h = holderHeads[holderID]; h >= 0; h = holds[h].nextForHolder) {
+			if (holds[h].itemID == itemID) {
+				return h;
+			}
+		}
+		return -1;
+	}
+
+	// Position of a hold in its item's queue, where 1 is served next
+	int getPosition(int h) const {
+		int position = 1;
+		for (int other = holds[h].prevInQueue; other >= 0; other = holds[other].prevInQueue) {
+			position += 1;
+		}
+		return position;
+	}
+
+	// Calls visit(itemID, holdNumber) for each of a holder's holds, in the order they were placed
+	template <class Visitor>
+	void forEachHoldOf(int holderID, Visitor visit) const {
+		if (holderID < 0 || holderID >= static_cast<int>(holderHeads.size())) {
+			return;
+		}
+		for (int h = holderHeads[holderID]; h >= 0; h = holds[h].nextForHolder) {
+			visit(holds[h].itemID, h);
+		}
+	}
+
+	// Removes every hold a holder has
+	void removeHoldsOf(int holderID) {
+		while (holderID >= 0 && holderID < static_cast<int>(holderHeads.size()) && holderHeads[holderID] >= 0) {
+			removeHold(holderHeads[holderID]);
+		}
+	}
+
+	// Removes every hold on an item
+	void removeHoldsOn(int itemID) {
+		while (itemID >= 0 && itemID < static_cast<int>(queues.size()) && queues[itemID].head >= 0) {
+			removeHold(queues[itemID].head);
+		}
+	}
+
+	int getItem(int h) const {
+		return holds[h].itemID;
+	}
+
+	int getHolder(int h) const {
+		return holds[h].holderID;
+	}
+
+	int getQueueLength(int itemID) const {
+		return itemID >= 0 && itemID < static_cast<int>(queues.size()) ? queues[itemID].length : 0;
+	}
+
+	int getNumHoldsOf(int holderID) const {
+		return holderID >= 0 && holderID < static_cast<int>(holderCounts.size()) ? holderCounts[holderID] : 0;
+	}
+
+	int getNumHolds() const {
+		return numHolds;
+	}
+};
+
+#endif
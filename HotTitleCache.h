@@ -0,0 +1,138 @@
+#ifndef HOTTITLECACHE_H
+#define HOTTITLECACHE_H
+#include <string>
+#include <array>
+#include <cstdint>
+#include "HashTable.h"
+#include "LibraryMetrics.h"
+
+/*
++ Small fixed-size cache for the most looked up titles, keyed on the title exactly as it was typed (so a hit skips
+lower casing it, hashing it and walking a chain). It holds pointers to the values stored elsewhere, not copies.
+
++ The cache is split into numSets sets of `ways` entries each, and each set fits in one cache line (the tags, the
+CLOCK reference bits and the value pointers; the full keys, which are only compared when a tag matches, live in a
+separate array). A key can only go in one set, so a lookup is one cache line plus one key comparison. When a set is
+full, the CLOCK hand picks what to evict: it skips (and clears) entries that were used since it last passed them,
+and evicts the first one that wasn't, which keeps the hot titles in.
+
++ NOTE: Since it holds pointers, the owner has to invalidate a value before it's deleted (or its key changes).
+*/
+template <class U, int numSets = 128, int ways = 4>
+class HotTitleCache {
+	static_assert(numSets > 0 && (numSets & (numSets - 1)) == 0, "HotTitleCache numSets must be a power of two");
+private:
+	struct alignas(64) CacheSet {
+		uint32_t tags[ways]; // part of each entry's hash, or 0 for an empty entry
+		uint8_t referenced[ways]; // CLOCK bit: used since the hand last passed
+		uint8_t hand; // next entry the CLOCK hand looks at
+		U* values[ways];
+	};
+
+	std::array<CacheSet, numSets> sets;
+	std::array<std::string, numSets * ways> keys; // keys[set * ways + way]
+	long long numHits = 0;
+	long long numMisses = 0;
+	long long numEvictions = 0;
+	long long numInvalidations = 0;
+
+	// Tag stored for a hash; never 0, since 0 marks an empty entry
+	static uint32_t tagFor(size_t keyHash) {
+		return static_cast<uint32_t>(keyHash >> 32) | 1;
+	}
+
+public:
+	HotTitleCache() {
+		clear();
+	}
+
+	// Removes every entry (the hit and miss counts are kept)
+	void clear() {
+		for (int s = 0; s < numSets; s++) {
+			for (int w = 0; w < ways; w++) {
+				sets[s].tags[w] = 0;
+				sets[s].referenced[w] = 0;
+				sets[s].values[w] = nullptr;
+			}
+			sets[s].hand = 0;
+		}
+	}
+
+	// Returns the cached value for the key, or a nullptr on a miss
+	U* find(const std::string& key) {
+		size_t keyHash = FNV1aHash::hash(key);
+		int s = static_cast<int>(keyHash & (numSets - 1));
+		uint32_t tag = tagFor(keyHash);
+		CacheSet& set = sets[s];
+		for (int w = 0; w < ways; w++) {
+			if (set.tags[w] == tag && keys[s * ways + w] == key) {
+				set.referenced[w] = 1;
+				numHits += 1;
+				return set.values[w];
+			}
+		}
+		numMisses += 1;
+		return nullptr;
+	}
+
+	// Caches a value for a key that find() just missed, evicting an entry from the key's set if it's full
+	void insert(const std::string& key, U* value) {
+		size_t keyHash = FNV1aHash::hash(key);
+		int s = static_cast<int>(keyHash & (numSets - 1));
+		CacheSet& set = sets[s];
+		int victim = -1;
+		for (int w = 0; w < ways; w++) {
+			if (set.tags[w] == 0) {
+				victim = w;
+				break;
+			}
+		}
+		if (victim < 0) {
+			// Give every recently used entry a second chance; at most one sweep clears them all
+			while (set.referenced[set.hand]) {
+				set.referenced[set.hand] = 0;
+				set.hand = static_cast<uint8_t>((set.hand + 1) % ways);
+			}
+			victim = set.hand;
+			set.hand = static_cast<uint8_t>((set.hand + 1) % ways);
+			numEvictions += 1;
+		}
+		set.tags[victim] = tagFor(keyHash);
+		set.referenced[victim] = 0;
+		set.values[victim] = value;
+		keys[s * ways + victim] = key;
+	}
+
+	// Removes every entry pointing at the value (several keys, like "Dune" and "dune", can point at the same one)
+	void invalidate(const U* value) {
+		for (int s = 0; s < numSets; s++) {
+			for (int w = 0; w < ways; w++) {
+				if (sets[s].tags[w] != 0 && sets[s].values[w] == value) {
+					sets[s].tags[w] = 0;
+					sets[s].values[w] = nullptr;
+					numInvalidations += 1;
+				}
+			}
+		}
+	}
+
+	CacheStats getStats() {
+		CacheStats stats;
+		stats.capacity = numSets * ways;
+		for (int s = 0; s < numSets; s++) {
+			for (int w = 0; w < ways; w++) {
+				if (sets[s].tags[w] != 0) {
+					stats.entries += 1;
+				}
+			}
+		}
+		stats.hits = numHits;
+		stats.misses = numMisses;
+		stats.evictions = numEvictions;
+		stats.invalidations = numInvalidations;
+		stats.hitRate = numHits + numMisses > 0 ? static_cast<double>(numHits) / (numHits + numMisses) : 0.0;
+		return stats;
+	}
+};
+
+#endif
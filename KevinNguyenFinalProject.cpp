@@ -2,29 +2,12 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#ifdef __linux__
+#include <poll.h>
+#endif
 #include "BookLibrary.h"
 #include "utilities.h"
-void loadBookData(BookLibrary& someLibrary, std::string fileName, char delimiter) {
-	std::ifstream bookDataFile;
-	std::string currentLine; 
-	bookDataFile.open(fileName);
-	while (std::getline(bookDataFile, currentLine)) {
-		// book attributes put into vector form, we convert bookVector[3] in the data-file it represents an integer, but was converted into a string in the vector
-		// Now we convert it back into a vector
-		std::vector<std::string> bookVector = splitLine(currentLine, delimiter);	
-		someLibrary.addBook(bookVector[0], bookVector[1], bookVector[2], std::stoi(bookVector[3]));
-	}
-}
-
-void loadStudentData(BookLibrary& someLibrary, std::string fileName, char delimiter) {
-	std::ifstream studentDataFile;
-	std::string currentLine;
-	studentDataFile.open(fileName);
-	while (std::getline(studentDataFile, currentLine)) {
-		std::vector<std::string> studentVector = splitLine(currentLine, delimiter);
-		someLibrary.addStudent(studentVector[0], studentVector[1], studentVector[2]);
-	}
-}
+#include "dataLoader.h"
 
 // Displays 
 void displayMainMenu() {
@@ -36,17 +19,61 @@ void displayMainMenu() {
 	std::cout << "5. Delete Book" << std::endl;
 	std::cout << "6. Add Student" << std::endl;
 	std::cout << "7. Delete Student" << std::endl;
-	std::cout << "8. Quit" << std::endl;
+	std::cout << "8. Library Stats" << std::endl;
+	std::cout << "9. Due Dates" << std::endl;
+	std::cout << "10. Renew Book" << std::endl;
+	std::cout << "11. Circulation Report" << std::endl;
+	std::cout << "12. Export Data" << std::endl;
+	std::cout << "13. Sync Books" << std::endl;
+	std::cout << "14. Edit Book" << std::endl;
+	std::cout << "15. Quit" << std::endl;
 	std::cout << "Enter the number for your choice: ";
 }
 
-int main() {
-	// Create library
+// Waits for the user to type something, adding more of the catalog's books while we wait (when it's still loading).
+// Without poll there's no telling whether anything has been typed, so it adds one slice of books and then lets the
+// next read from std::cin block.
+void waitForInput(BookLibrary& library) {
+#ifdef __linux__
+	pollfd input = { 0, POLLIN, 0 };
+	while (library.isLoadingBooks() && poll(&input, 1, 0) == 0) {
+		library.continueLoadingBooks(std::chrono::milliseconds(10));
+	}
+#else
+	if (library.isLoadingBooks()) {
+		library.continueLoadingBooks(std::chrono::milliseconds(100));
+	}
+#endif
+}
+
+// Run with "--trace <file>" to record every library operation to a file that TraceReplay can run again, and with
+// "--lazy" to show the menu as soon as bookData.txt is indexed, loading its books as they're needed
+int main(int argc, char* argv[]) {
+	std::string traceFileName;
+	bool lazy = false;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--trace" && i + 1 < argc) {
+			traceFileName = argv[++i];
+		} else if (std::string(argv[i]) == "--lazy") {
+			lazy = true;
+		}
+	}
+	// Create library, with a scheduler for its background work (declared first, so it outlives the library's jobs)
+	TaskScheduler backgroundScheduler;
 	BookLibrary myLibrary;
+	myLibrary.setBackgroundScheduler(&backgroundScheduler);
 	// Load the library instance with data for book objects
-	loadBookData(myLibrary, "bookData.txt", ',');
+	if (lazy) {
+		myLibrary.startLoadingBooks("bookData.txt", ',');
+	} else {
+		loadBookData(myLibrary, "bookData.txt", ',');
+	}
 	// Load the library instance with pre made student objects
 	loadStudentData(myLibrary, "studentData.txt", ',');
+	// Start recording after loading, since the replay loads the same data files itself
+	if (!traceFileName.empty()) {
+		myLibrary.startTrace(traceFileName);
+	}
 
 	// Boolean for continuing the loop
 	bool continueLoop = true;
@@ -55,8 +82,9 @@ int main() {
 
 	while (continueLoop) {
 		displayMainMenu();
+		waitForInput(myLibrary);
 		std::cin >> userChoice;
-		userChoice = validateMenuInput(userChoice, 1, 8);
+		userChoice = validateMenuInput(userChoice, 1, 15);
 		switch (userChoice) {
 			case 1:
 				myLibrary.promptSearchBook();
@@ -80,6 +108,27 @@ int main() {
 				myLibrary.promptDeleteStudent();
 				break;
 			case 8:
+				myLibrary.promptShowStats();
+				break;
+			case 9:
+				myLibrary.showDueDates();
+				break;
+			case 10:
+				myLibrary.promptRenewBook();
+				break;
+			case 11:
+				myLibrary.showCirculationReport();
+				break;
+			case 12:
+				myLibrary.promptExportData();
+				break;
+			case 13:
+				myLibrary.promptSyncBooks();
+				break;
+			case 14:
+				myLibrary.promptEditBook();
+				break;
+			case 15:
 				// Set booelan to false 
 				continueLoop = false;
 		}
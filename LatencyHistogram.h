@@ -0,0 +1,148 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/*
++ Histogram for recording latencies in the style of HdrHistogram. Values below 128 each get their own bucket,
+and every power of two above that is split into 64 equal sub-buckets, so any recorded value is reported within
+about 1.6% of what it really was. That keeps memory fixed (a few thousand counters covers every 64 bit value)
+no matter how many values are recorded, while percentiles way out in the tail stay accurate.
+
++ NOTE: Values are unitless; the load driver records nanoseconds.
+*/
+class LatencyHistogram {
+private:
+	static const int subBucketBits = 6; // each power of two is split into 2^subBucketBits sub-buckets
+	static const int linearLimit = 1 << (subBucketBits + 1); // values below this each get their own bucket
+	std::vector<int64_t> counts;
+	int64_t totalCount;
+	uint64_t minValue;
+	uint64_t maxValue;
+	double sum;
+
+	// Position of the highest set bit in a non-zero value
+	static int highestBit(uint64_t value) {
+		int position = 0;
+		while (value >>= 1) {
+			position += 1;
+		}
+		return position;
+	}
+
+	// Index of the bucket that a value is counted in
+	static size_t bucketIndex(uint64_t value) {
+		if (value < static_cast<uint64_t>(linearLimit)) {
+			return static_cast<size_t>(value);
+		}
+		int shift = highestBit(value) - subBucketBits;
+		uint64_t subBucket = value >> shift; // between 2^subBucketBits and 2^(subBucketBits + 1) - 1
+		return linearLimit + static_cast<size_t>(shift - 1) * (linearLimit / 2) + static_cast<size_t>(subBucket - linearLimit / 2);
+	}
+
+	// Largest value that would be counted in the bucket at the given index
+	static uint64_t highestEquivalentValue(size_t index) {
+		if (index < static_cast<size_t>(linearLimit)) {
+			return index;
+		}
+		size_t offset = index - linearLimit;
+		int shift = static_cast<int>(offset / (linearLimit / 2)) + 1;
+		uint64_t subBucket = offset % (linearLimit / 2) + linearLimit / 2;
+		return ((subBucket + 1) << shift) - 1;
+	}
+
+public:
+	LatencyHistogram() {
+		counts.assign(bucketIndex(UINT64_MAX) + 1, 0);
+		reset();
+	}
+
+	// Forgets every recorded value
+	void reset() {
+		std::fill(counts.begin(), counts.end(), 0);
+		totalCount = 0;
+		minValue = UINT64_MAX;
+		maxValue = 0;
+		sum = 0;
+	}
+
+	// Records a single value
+	void recordValue(uint64_t value) {
+		counts[bucketIndex(value)] += 1;
+		totalCount += 1;
+		sum += static_cast<double>(value);
+		if (value < minValue) {
+			minValue = value;
+		}
+		if (value > maxValue) {
+			maxValue = value;
+		}
+	}
+
+	// Adds all the values recorded in another histogram into this one
+	void add(const LatencyHistogram& other) {
+		for (size_t i = 0; i < counts.size(); i++) {
+			counts[i] += other.counts[i];
+		}
+		totalCount += other.totalCount;
+		sum += other.sum;
+		if (other.minValue < minValue) {
+			minValue = other.minValue;
+		}
+		if (other.maxValue > maxValue) {
+			maxValue = other.maxValue;
+		}
+	}
+
+	// Returns the value that the given percentage (0 to 100) of recorded values are at or below
+	uint64_t valueAtPercentile(double percentile) const {
+		if (totalCount == 0) {
+			return 0;
+		}
+		int64_t target = static_cast<int64_t>(percentile / 100.0 * totalCount + 0.5);
+		if (target < 1) {
+			target = 1;
+		}
+		int64_t runningCount = 0;
+		for (size_t i = 0; i < counts.size(); i++) {
+			runningCount += counts[i];
+			if (runningCount >= target) {
+				// A bucket covers a range of values, but it can't go past the largest value we actually saw
+				uint64_t value = highestEquivalentValue(i);
+				return value < maxValue ? value : maxValue;
+			}
+		}
+		return maxValue;
+	}
+
+	int64_t getTotalCount() const {
+		return totalCount;
+	}
+	uint64_t getMin() const {
+		return totalCount == 0 ? 0 : minValue;
+	}
+	uint64_t getMax() const {
+		return maxValue;
+	}
+	double getMean() const {
+		return totalCount == 0 ? 0.0 : sum / totalCount;
+	}
+
+	// Writes the count, mean and the usual percentiles as the body of a JSON object
+	void writeJSONFields(std::ostream& os) const {
+		os << "\"count\": " << totalCount
+			<< ", \"mean\": " << getMean()
+			<< ", \"min\": " << getMin()
+			<< ", \"p50\": " << valueAtPercentile(50)
+			<< ", \"p90\": " << valueAtPercentile(90)
+			<< ", \"p99\": " << valueAtPercentile(99)
+			<< ", \"p99.9\": " << valueAtPercentile(99.9)
+			<< ", \"p99.99\": " << valueAtPercentile(99.99)
+			<< ", \"max\": " << getMax();
+	}
+};
+
+#endif
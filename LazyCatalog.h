@@ -0,0 +1,433 @@
+#ifndef LAZYCATALOG_H
+#define LAZYCATALOG_H
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "Book.h"
+#include "utilities.h"
+#include "TaskScheduler.h"
+
+/*
++ Lazy book catalog, for starting the library without waiting for bookData.txt to load. Opening it maps the file and
+makes one pass over the bytes, without building a single string: it notes where every 64th record starts (a sparse
+index of blocks), and puts a hash of each record's lower cased title and of its ISBN in a small table that points at
+the record's block. That takes a fraction of the time a full load does, and the library can serve from then on:
+
+	- A lookup that misses in the library asks the catalog, which finds the few blocks that might have the title (or
+	ISBN), reads just those records and hands back the one that matches, so only that book is loaded ahead of time.
+	- Everything else is handed out in file order as the library has time for it. Parsing runs ahead on the
+	background scheduler, a chunk of blocks at a time, so the library only has to insert what's been parsed.
+
++ Records come out exactly as loadBookData would read them (splitLine on each record, with quoted fields allowed to
+span lines like readRecord), and a record that's already been handed out on demand is skipped when its turn comes.
+
++ NOTE: The library still decides what happens to each record (e.g. a duplicate title is turned away), so it calls
+the catalog from its own thread only; the catalog's only other thread use is the parse jobs, which read the mapped
+file and nothing else.
+*/
+
+// A data file mapped read-only; shared with the parse jobs so it stays mapped while any of them is still running.
+// Where there's no mmap (anything but Linux) the whole file is read into memory instead.
+struct MappedDataFile {
+	const char* data = nullptr;
+	size_t size = 0;
+#ifndef __linux__
+	std::vector<char> contents;
+#endif
+
+	MappedDataFile() {}
+	MappedDataFile(const MappedDataFile&) = delete;
+	MappedDataFile& operator=(const MappedDataFile&) = delete;
+
+	~MappedDataFile() {
+#ifdef __linux__
+		if (data != nullptr) {
+			munmap(const_cast<char*>(data), size);
+		}
+#endif
+	}
+
+	bool open(const std::string& fileName) {
+#ifdef __linux__
+		int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat fileInfo;
+		bool opened = fstat(fd, &fileInfo) == 0;
+		size = opened ? static_cast<size_t>(fileInfo.st_size) : 0;
+		if (opened && size > 0) {
+			void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			opened = mapping != MAP_FAILED;
+			if (opened) {
+				data = static_cast<const char*>(mapping);
+				// We read it front to back, mostly
+				madvise(mapping, size, MADV_SEQUENTIAL);
+			}
+		}
+		::close(fd);
+		return opened;
+#else
+		std::ifstream dataFile(fileName, std::ios::binary | std::ios::ate);
+		if (!dataFile) {
+			return false;
+		}
+		size = static_cast<size_t>(dataFile.tellg());
+		contents.resize(size);
+		dataFile.seekg(0);
+		if (size > 0 && !dataFile.read(contents.data(), static_cast<std::streamsize>(size))) {
+			size = 0;
+			return false;
+		}
+		data = size > 0 ? contents.data() : nullptr;
+		return true;
+#endif
+	}
+};
+
+class LazyBookCatalog {
+public:
+	static const int recordsPerBlock = 64; // one sparse index entry per this many records
+	static const int blocksPerChunk = 64; // blocks parsed by each background job
+
+	// Fields a record can be looked up by
+	enum Field { TITLE_FIELD = 0, ISBN_FIELD = 2 };
+
+	// Reading records straight out of a mapped file; the delta import (CatalogSync.h) reads them the same way
+
+	// Where the record starting at position ends: the line break after it (or the end of the file), not counting line
+	// breaks inside a quoted field
+	static size_t recordEnd(const char* data, size_t position, size_t size, char delimiter) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(data + position, '\n', size - position));
+		size_t end = lineEnd != nullptr ? static_cast<size_t>(lineEnd - data) : size;
+		if (std::memchr(data + position, '"', end - position) == nullptr) {
+			return end;
+		}
+		bool inQuotes = endsInQuotedField(data + position, end - position, delimiter, false);
+		while (inQuotes && end < size) {
+			size_t lineStart = end + 1;
+			lineEnd = static_cast<const char*>(std::memchr(data + lineStart, '\n', size - lineStart));
+			end = lineEnd != nullptr ? static_cast<size_t>(lineEnd - data) : size;
+			inQuotes = endsInQuotedField(data + lineStart, end - lineStart, delimiter, true);
+		}
+		return end;
+	}
+
+	// Skips the line breaks (and blank lines) before the next record
+	static size_t skipLineBreaks(const char* data, size_t position, size_t size) {
+		while (position < size && (data[position] == '\n' || data[position] == '\r')) {
+			position += 1;
+		}
+		return position;
+	}
+
+	// Reads the record between start and end into a book the way loadBookData would; false if it isn't one
+	static bool parseRecord(const char* data, size_t start, size_t end, char delimiter, Book& book) {
+		std::vector<std::string> fields = splitLine(std::string(data + start, end - start), delimiter);
+		if (fields.size() < 4) {
+			return false;
+		}
+		book = {fields[0], fields[1], fields[2], std::stoi(fields[3])};
+		return true;
+	}
+
+	// Parses every record in a range of blocks; runs on the background scheduler
+	static std::vector<Book> parseBlocks(std::shared_ptr<MappedDataFile> file, char delimiter, size_t start, size_t end, size_t numRecords) {
+		std::vector<Book> books(numRecords);
+		size_t position = start;
+		for (size_t i = 0; i < numRecords && position < end; i++) {
+			size_t recordStop = recordEnd(file->data, position, file->size, delimiter);
+			if (!parseRecord(file->data, position, recordStop, delimiter, books[i])) {
+				books[i] = Book();
+			}
+			position = skipLineBreaks(file->data, recordStop, file->size);
+		}
+		return books;
+	}
+
+private:
+	// Slot of the title or ISBN table: the top half of the key's hash, and the block it's in plus one (0 for empty)
+	struct IndexSlot {
+		uint32_t tag;
+		uint32_t blockPlusOne;
+	};
+
+	std::shared_ptr<MappedDataFile> file;
+	char delimiter = ',';
+	std::vector<size_t> blockStarts; // where each block's first record starts
+	size_t numRecords = 0;
+	std::vector<uint64_t> handedOut; // one bit per record, for records handed out on demand
+	std::vector<IndexSlot> titleSlots;
+	std::vector<IndexSlot> isbnSlots;
+	uint64_t slotMask = 0;
+
+	TaskScheduler* scheduler = nullptr;
+	std::deque<TaskHandle<std::vector<Book>>> parsedChunks; // jobs for the chunks after the current one, in order
+	size_t nextChunkToParse = 0;
+	std::vector<Book> currentChunk;
+	size_t positionInChunk = 0;
+	size_t nextRecord = 0; // records before this one have all been handed out
+
+	// Hash of a title or ISBN field, without copying it; titles are hashed lower cased (the same as
+	// FNV1aHash::hash(lowerCaseString(title)))
+	static uint64_t hashField(const char* text, size_t length, bool lowerCase) {
+		uint64_t hashValue = 14695981039346656037ULL;
+		for (size_t i = 0; i < length; i++) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			hashValue ^= lowerCase ? static_cast<unsigned char>(tolower(c)) : c;
+			hashValue *= 1099511628211ULL;
+		}
+		return hashValue;
+	}
+
+	// Whether a record's title (ignoring case, with key lower cased) or ISBN is key, without parsing the record unless
+	// it has quotes in it
+	bool fieldMatches(size_t start, size_t end, Field field, const std::string& key) {
+		const char* data = file->data;
+		if (std::memchr(data + start, '"', end - start) != nullptr) {
+			std::vector<std::string> fields = splitLine(std::string(data + start, end - start), delimiter);
+			if (fields.size() <= static_cast<size_t>(field)) {
+				return false;
+			}
+			return field == TITLE_FIELD ? equalsIgnoringCase(fields[field], key) : fields[field] == key;
+		}
+		size_t position = start;
+		for (int i = 0; i < field; i++) {
+			const char* fieldEnd = static_cast<const char*>(std::memchr(data + position, delimiter, end - position));
+			if (fieldEnd == nullptr) {
+				return false;
+			}
+			position = static_cast<size_t>(fieldEnd - data) + 1;
+		}
+		const char* fieldEnd = static_cast<const char*>(std::memchr(data + position, delimiter, end - position));
+		size_t length = (fieldEnd != nullptr ? static_cast<size_t>(fieldEnd - data) : end) - position;
+		if (length != key.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < length; i++) {
+			unsigned char c = static_cast<unsigned char>(data[position + i]);
+			if ((field == TITLE_FIELD ? static_cast<unsigned char>(tolower(c)) : c) != static_cast<unsigned char>(key[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void addToIndex(std::vector<IndexSlot>& slots, uint64_t hashValue, size_t block) {
+		IndexSlot newSlot = { static_cast<uint32_t>(hashValue >> 32), static_cast<uint32_t>(block + 1) };
+		for (uint64_t slot = hashValue & slotMask; ; slot = (slot + 1) & slotMask) {
+			if (slots[slot].blockPlusOne == 0) {
+				slots[slot] = newSlot;
+				return;
+			}
+			if (slots[slot].tag == newSlot.tag && slots[slot].blockPlusOne == newSlot.blockPlusOne) {
+				return; // a title that shows up twice in the same block only needs the one slot
+			}
+		}
+	}
+
+	// Adds a record's title and ISBN to the tables
+	void indexRecord(size_t start, size_t end, size_t block) {
+		const char* data = file->data;
+		const char* fieldStart[3];
+		size_t fieldLength[3];
+		bool quoted = std::memchr(data + start, '"', end - start) != nullptr;
+		std::vector<std::string> fields;
+		if (quoted) {
+			// Rare enough that it isn't worth finding the fields by hand
+			fields = splitLine(std::string(data + start, end - start), delimiter);
+			fields.resize(std::max<size_t>(fields.size(), 3));
+			for (int i = 0; i < 3; i++) {
+				fieldStart[i] = fields[i].data();
+				fieldLength[i] = fields[i].size();
+			}
+		} else {
+			size_t position = start;
+			for (int i = 0; i < 3; i++) {
+				const char* fieldEnd = static_cast<const char*>(std::memchr(data + position, delimiter, end - position));
+				size_t stop = fieldEnd != nullptr ? static_cast<size_t>(fieldEnd - data) : end;
+				fieldStart[i] = data + position;
+				fieldLength[i] = stop - position;
+				position = stop < end ? stop + 1 : end;
+			}
+		}
+		addToIndex(titleSlots, hashField(fieldStart[TITLE_FIELD], fieldLength[TITLE_FIELD], true), block);
+		addToIndex(isbnSlots, hashField(fieldStart[ISBN_FIELD], fieldLength[ISBN_FIELD], false), block);
+	}
+
+	size_t numBlocks() {
+		return blockStarts.size();
+	}
+
+	size_t blockEnd(size_t block) {
+		return block + 1 < blockStarts.size() ? blockStarts[block + 1] : file->size;
+	}
+
+	size_t recordsInBlock(size_t block) {
+		return std::min<size_t>(recordsPerBlock, numRecords - block * recordsPerBlock);
+	}
+
+	// Queues parse jobs for the chunks after the current one, keeping a few in flight
+	void parseAhead() {
+		size_t numChunks = (numBlocks() + blocksPerChunk - 1) / blocksPerChunk;
+		size_t inFlight = scheduler != nullptr ? 2 * static_cast<size_t>(scheduler->getNumThreads()) : 1;
+		while (parsedChunks.size() < inFlight && nextChunkToParse < numChunks) {
+			size_t firstBlock = nextChunkToParse * blocksPerChunk;
+			size_t lastBlock = std::min(numBlocks(), firstBlock + blocksPerChunk) - 1;
+			size_t start = blockStarts[firstBlock];
+			size_t end = blockEnd(lastBlock);
+			size_t chunkRecords = std::min(numRecords, (lastBlock + 1) * recordsPerBlock) - firstBlock * recordsPerBlock;
+			std::shared_ptr<MappedDataFile> chunkFile = file;
+			char chunkDelimiter = delimiter;
+			parsedChunks.push_back(runInBackground(scheduler, [chunkFile, chunkDelimiter, start, end, chunkRecords]() {
+				return parseBlocks(chunkFile, chunkDelimiter, start, end, chunkRecords);
+			}, PRIORITY_LOW));
+			nextChunkToParse += 1;
+		}
+	}
+
+public:
+	LazyBookCatalog() {}
+	LazyBookCatalog(const LazyBookCatalog&) = delete;
+	LazyBookCatalog& operator=(const LazyBookCatalog&) = delete;
+
+	~LazyBookCatalog() {
+		for (size_t i = 0; i < parsedChunks.size(); i++) {
+			parsedChunks[i].cancel();
+		}
+	}
+
+	// Maps a book data file and indexes it; parse jobs go to the scheduler (nullptr parses each chunk when it's
+	// needed). Returns false if the file can't be read.
+	bool open(const std::string& fileName, char _delimiter, TaskScheduler* _scheduler) {
+		file = std::make_shared<MappedDataFile>();
+		if (!file->open(fileName)) {
+			return false;
+		}
+		delimiter = _delimiter;
+		scheduler = _scheduler;
+		// Find where each record starts first, so the tables can be sized for them
+		std::vector<size_t> recordStarts;
+		const char* data = file->data;
+		size_t position = skipLineBreaks(data, 0, file->size);
+		while (position < file->size) {
+			recordStarts.push_back(position);
+			position = skipLineBreaks(data, recordEnd(data, position, file->size, delimiter), file->size);
+		}
+		numRecords = recordStarts.size();
+		size_t numSlots = 2;
+		while (numSlots < 2 * numRecords) {
+			numSlots *= 2;
+		}
+		slotMask = numSlots - 1;
+		titleSlots.assign(numSlots, IndexSlot());
+		isbnSlots.assign(numSlots, IndexSlot());
+		handedOut.assign((numRecords + recordsPerBlock - 1) / recordsPerBlock, 0);
+		blockStarts.clear();
+		for (size_t i = 0; i < numRecords; i++) {
+			if (i % recordsPerBlock == 0) {
+				blockStarts.push_back(recordStarts[i]);
+			}
+			// The next record starts right after this one's line breaks; the title and ISBN don't care about a '\r'
+			size_t recordStop = i + 1 < numRecords ? recordStarts[i + 1] : file->size;
+			while (recordStop > recordStarts[i] && (data[recordStop - 1] == '\n' || data[recordStop - 1] == '\r')) {
+				recordStop -= 1;
+			}
+			indexRecord(recordStarts[i], recordStop, i / recordsPerBlock);
+		}
+		parseAhead();
+		return true;
+	}
+
+	size_t getNumRecords() {
+		return numRecords;
+	}
+
+	// Whether every record has been handed out
+	bool isDone() {
+		return nextRecord >= numRecords;
+	}
+
+	// Whether a record hasn't been handed out yet
+	bool isPending(size_t record) {
+		return record >= nextRecord && (handedOut[record / recordsPerBlock] & (uint64_t(1) << (record % recordsPerBlock))) == 0;
+	}
+
+	// Marks a record as handed out, so it's skipped when its turn comes
+	void markHandedOut(size_t record) {
+		handedOut[record / recordsPerBlock] |= uint64_t(1) << (record % recordsPerBlock);
+	}
+
+	/*
+	+ Calls visit(record, book) for each pending record whose title (given lower cased) or ISBN is key, in file order,
+	until visit returns false. Only the blocks the table points at are read, so this costs a few blocks' worth of
+	parsing however big the file is. Visiting doesn't hand a record out; call markHandedOut for that.
+	*/
+	template <class Visitor>
+	void forEachPendingMatch(Field field, const std::string& key, Visitor visit) {
+		if (isDone()) {
+			return;
+		}
+		const std::vector<IndexSlot>& slots = field == TITLE_FIELD ? titleSlots : isbnSlots;
+		uint64_t hashValue = hashField(key.data(), key.size(), field == TITLE_FIELD);
+		uint32_t tag = static_cast<uint32_t>(hashValue >> 32);
+		std::vector<size_t> blocks;
+		for (uint64_t slot = hashValue & slotMask; slots[slot].blockPlusOne != 0; slot = (slot + 1) & slotMask) {
+			size_t block = slots[slot].blockPlusOne - 1;
+			if (slots[slot].tag == tag && (block + 1) * recordsPerBlock > nextRecord) {
+				blocks.push_back(block);
+			}
+		}
+		std::sort(blocks.begin(), blocks.end());
+		blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+		for (size_t i = 0; i < blocks.size(); i++) {
+			size_t record = blocks[i] * recordsPerBlock;
+			size_t position = blockStarts[blocks[i]];
+			for (size_t j = 0; j < recordsInBlock(blocks[i]); j++, record++) {
+				size_t recordStop = recordEnd(file->data, position, file->size, delimiter);
+				Book book;
+				if (isPending(record) && fieldMatches(position, recordStop, field, key) &&
+					parseRecord(file->data, position, recordStop, delimiter, book) && !visit(record, book)) {
+					return;
+				}
+				position = skipLineBreaks(file->data, recordStop, file->size);
+			}
+		}
+	}
+
+	// Hands out the next pending record in file order; returns false when there are none left. Waits for the record's
+	// chunk to be parsed if it isn't yet.
+	bool nextBook(Book& book) {
+		while (nextRecord < numRecords) {
+			if (positionInChunk >= currentChunk.size()) {
+				parseAhead();
+				currentChunk = parsedChunks.front().get();
+				parsedChunks.pop_front();
+				positionInChunk = 0;
+				parseAhead();
+			}
+			size_t record = nextRecord;
+			nextRecord += 1;
+			Book& parsed = currentChunk[positionInChunk];
+			positionInChunk += 1;
+			if ((handedOut[record / recordsPerBlock] & (uint64_t(1) << (record % recordsPerBlock))) == 0 && !parsed.title.empty()) {
+				book = std::move(parsed);
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef LIBRARYFEDERATION_H
+#define LIBRARYFEDERATION_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "BookLibrary.h"
+
+/*
++ Federation of branch libraries. Each branch is its own BookLibrary (a shard of the whole catalog) with its own
+worker thread, and every operation on a branch runs on that branch's worker. Searches across the whole catalog send
+the same search to every branch at once and merge what comes back, so a search takes about as long as the slowest
+branch rather than the sum of all of them, and different branches never wait on each other.
+
++ NOTE: BookLibrary itself isn't thread safe, so a branch's library is only ever touched while holding that branch's
+mutex: the worker holds it while it runs a task, and a transfer between branches holds both branches' mutexes so
+the book is never in both branches or in neither.
+*/
+
+// One branch library and the worker thread that runs everything on it
+class LibraryBranch {
+private:
+	std::string name;
+	BookLibrary library;
+	std::mutex libraryMutex; // held while anything touches library
+	std::mutex queueMutex; // protects tasks and stopping
+	std::condition_variable taskAvailable;
+	std::deque<std::function<void()>> tasks;
+	bool stopping = false;
+	std::thread worker;
+
+	// Runs tasks in the order they were submitted until the branch is shut down
+	void workerLoop() {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty()) {
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			std::lock_guard<std::mutex> lock(libraryMutex);
+			task();
+		}
+	}
+
+public:
+	// Starts the branch's worker thread; on Linux the worker is pinned to the given core so that each branch keeps
+	// its part of the catalog in its own core's caches
+	LibraryBranch(std::string _name, int core) : name(_name) {
+		library.setVerbose(false);
+		worker = std::thread(&LibraryBranch::workerLoop, this);
+#ifdef __linux__
+		if (core >= 0) {
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			CPU_SET(core, &cpuSet);
+			pthread_setaffinity_np(worker.native_handle(), sizeof(cpu_set_t), &cpuSet);
+		}
+#else
+		(void)core;
+#endif
+	}
+
+	// Finishes the tasks that were already submitted, then stops the worker
+	~LibraryBranch() {
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopping = true;
+		}
+		taskAvailable.notify_one();
+		worker.join();
+	}
+
+	std::string getName() {
+		return name;
+	}
+
+	// Runs function(library) on the branch's worker, and returns a future for what it returns
+	template <class Function>
+	auto submit(Function function) -> std::future<decltype(function(std::declval<BookLibrary&>()))> {
+		typedef decltype(function(std::declval<BookLibrary&>())) Result;
+		std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(
+			[this, function]() mutable { return function(library); });
+		std::future<Result> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			tasks.push_back([task]() { (*task)(); });
+		}
+		taskAvailable.notify_one();
+		return result;
+	}
+
+	// Gives direct access to the library while holding its mutex; for operations that need more than one branch
+	std::mutex& getLibraryMutex() {
+		return libraryMutex;
+	}
+	BookLibrary& getLibraryUnlocked() {
+		return library;
+	}
+};
+
+// A book found by a federation-wide search, along with the branch that has it
+struct BranchBook {
+	int branchIndex;
+	Book book;
+};
+
+class LibraryFederation {
+private:
+	std::vector<std::unique_ptr<LibraryBranch>> branches;
+
+	// Sends the same search to every branch at once, then waits for all of them and merges the results
+	template <class Search>
+	std::vector<BranchBook> searchAllBranches(Search search) {
+		std::vector<std::future<std::vector<Book>>> pending;
+		for (size_t i = 0; i < branches.size(); i++) {
+			pending.push_back(branches[i]->submit(search));
+		}
+		std::vector<BranchBook> results;
+		for (size_t i = 0; i < pending.size(); i++) {
+			std::vector<Book> branchResults = pending[i].get();
+			for (size_t j = 0; j < branchResults.size(); j++) {
+				BranchBook found = { static_cast<int>(i), branchResults[j] };
+				results.push_back(found);
+			}
+		}
+		return results;
+	}
+
+public:
+	LibraryFederation() {}
+
+	// Creates a federation with the given branch names; with pinToCores each branch's worker gets its own core
+	// (wrapping around when there are more branches than cores)
+	LibraryFederation(std::vector<std::string> branchNames, bool pinToCores = true) {
+		for (size_t i = 0; i < branchNames.size(); i++) {
+			addBranch(branchNames[i], pinToCores);
+		}
+	}
+
+	// Adds a new, empty branch and returns its index
+	int addBranch(std::string name, bool pinToCore = true) {
+		int numCores = static_cast<int>(std::thread::hardware_concurrency());
+		int core = (pinToCore && numCores > 0) ? static_cast<int>(branches.size()) % numCores : -1;
+		branches.push_back(std::unique_ptr<LibraryBranch>(new LibraryBranch(name, core)));
+		return static_cast<int>(branches.size()) - 1;
+	}
+
+	int getNumBranches() {
+		return static_cast<int>(branches.size());
+	}
+
+	std::string getBranchName(int branchIndex) {
+		return branches[branchIndex]->getName();
+	}
+
+	// Runs function(library) on one branch's worker; use this for anything the federation doesn't wrap, like adding
+	// books or issuing them at a branch
+	template <class Function>
+	auto runOnBranch(int branchIndex, Function function) -> decltype(branches[branchIndex]->submit(function)) {
+		return branches[branchIndex]->submit(function);
+	}
+
+	// Issues a stack of books (titles or ISBNs) to a student at one branch, all or nothing (see BookLibrary::issueBooks).
+	// The batch is a single task on the branch's worker, so the branch is locked once for all of it.
+	std::future<BatchResult> issueBooks(int branchIndex, Student student, std::vector<std::string> items) {
+		return branches[branchIndex]->submit([student, items](BookLibrary& library) { return library.issueBooks(student, items); });
+	}
+
+	// Returns a stack of books from a student at one branch, all or nothing, as a single task like issueBooks
+	std::future<BatchResult> returnBooks(int branchIndex, Student student, std::vector<std::string> items) {
+		return branches[branchIndex]->submit([student, items](BookLibrary& library) { return library.returnBooks(student, items); });
+	}
+
+	// Takes a snapshot of one branch (see BookLibrary::takeSnapshot) as a task on its worker, so it's consistent with
+	// everything submitted before it. The report can then read it on its own thread while the branch carries on.
+	std::future<LibrarySnapshot> takeSnapshot(int branchIndex) {
+		return branches[branchIndex]->submit([](BookLibrary& library) { return library.takeSnapshot(); });
+	}
+
+	// Syncs one branch's books with a fresh book data file (see BookLibrary::syncBooks) as a single task on its worker
+	std::future<SyncReport> syncBooks(int branchIndex, std::string fileName, char delimiter) {
+		return branches[branchIndex]->submit([fileName, delimiter](BookLibrary& library) { return library.syncBooks(fileName, delimiter); });
+	}
+
+	// Edits a book in one branch (see BookLibrary::editBook) on its worker; the future says whether it was changed
+	std::future<bool> editBook(int branchIndex, std::string title, std::string newTitle, std::string newAuthor, std::string newISBN, int newNumPages) {
+		return branches[branchIndex]->submit([title, newTitle, newAuthor, newISBN, newNumPages](BookLibrary& library) {
+			return library.editBook(title, newTitle, newAuthor, newISBN, newNumPages);
+		});
+	}
+
+	// Finds a book by its title in every branch
+	std::vector<BranchBook> findByTitle(std::string title) {
+		return searchAllBranches([title](BookLibrary& library) {
+			std::vector<Book> found;
+			Book book = library.getBook(title);
+			if (book.ISBN != "") {
+				found.push_back(book);
+			}
+			return found;
+		});
+	}
+
+	// Finds a book by its ISBN in every branch
+	std::vector<BranchBook> findByISBN(std::string ISBN) {
+		return searchAllBranches([ISBN](BookLibrary& library) {
+			std::vector<Book> found;
+			Book book = library.getBookByISBN(ISBN);
+			if (book.ISBN != "") {
+				found.push_back(book);
+			}
+			return found;
+		});
+	}
+
+	// Finds every book by an author in every branch
+	std::vector<BranchBook> findByAuthor(std::string author) {
+		return searchAllBranches([author](BookLibrary& library) { return library.findBooksByAuthor(author); });
+	}
+
+	// Total number of books across all branches
+	int getNumBooks() {
+		std::vector<std::future<int>> pending;
+		for (size_t i = 0; i < branches.size(); i++) {
+			pending.push_back(branches[i]->submit([](BookLibrary& library) { return library.getNumBooks(); }));
+		}
+		int total = 0;
+		for (size_t i = 0; i < pending.size(); i++) {
+			total += pending[i].get();
+		}
+		return total;
+	}
+
+	// Moves a book from one branch to another. Both branches are locked for the whole move, so other threads see the
+	// book in exactly one of them. The book has to be on the shelf at the source, and the destination can't already
+	// have a book with that title; otherwise nothing changes and we return false.
+	bool transferBook(std::string title, int fromBranch, int toBranch) {
+		if (fromBranch == toBranch || fromBranch < 0 || toBranch < 0 || fromBranch >= getNumBranches() || toBranch >= getNumBranches()) {
+			return false;
+		}
+		// std::lock takes both mutexes without deadlocking against a transfer going the other way
+		std::unique_lock<std::mutex> fromLock(branches[fromBranch]->getLibraryMutex(), std::defer_lock);
+		std::unique_lock<std::mutex> toLock(branches[toBranch]->getLibraryMutex(), std::defer_lock);
+		std::lock(fromLock, toLock);
+		BookLibrary& source = branches[fromBranch]->getLibraryUnlocked();
+		BookLibrary& destination = branches[toBranch]->getLibraryUnlocked();
+		Book book = source.getBook(title);
+		if (book.ISBN == "" || !book.isAvailable || destination.getBook(title).ISBN != "") {
+			return false;
+		}
+		source.deleteBook(title);
+		destination.addBook(book.title, book.author, book.ISBN, book.numPages);
+		return true;
+	}
+};
+
+#endif
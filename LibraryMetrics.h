@@ -0,0 +1,296 @@
+#ifndef LIBRARYMETRICS_H
+#define LIBRARYMETRICS_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "LatencyHistogram.h"
+
+/*
++ Runtime metrics for the book library: how many times each operation ran and how long it took, plus what the
+hash table is doing internally (how many nodes each lookup walks, how full the buckets are, and how often it resized).
+
++ NOTE: Metrics are only compiled in when BOOKLIBRARY_METRICS is defined (for example with -DBOOKLIBRARY_METRICS).
+Otherwise the macros below expand to nothing and the metric members don't exist, so a normal build pays nothing for them.
+Bucket occupancy and resize counts don't need any instrumentation, so those are always available.
+*/
+
+// Operations in the library that we count and time
+enum LibraryOperation {
+	OP_GET_BOOK,
+	OP_ADD_BOOK,
+	OP_DELETE_BOOK,
+	OP_ISSUE_BOOK,
+	OP_RETURN_BOOK,
+	OP_ADD_STUDENT,
+	OP_DELETE_STUDENT,
+	OP_FIND_STUDENT,
+	OP_EDIT_BOOK,
+	NUM_LIBRARY_OPERATIONS
+};
+
+// Names used for each operation in the JSON and Prometheus output
+const char* const libraryOperationNames[NUM_LIBRARY_OPERATIONS] = {
+	"get_book", "add_book", "delete_book", "issue_book", "return_book", "add_student", "delete_student", "find_student",
+	"edit_book"
+};
+
+// Snapshot of what's going on inside a hash table
+struct HashTableStats {
+	int numBuckets = 0;
+	int numPairs = 0;
+	int emptyBuckets = 0; // buckets whose chain has no nodes
+	int longestChain = 0; // number of nodes in the longest chain
+	long long resizes = 0; // how many times the table grew
+	bool hasLookupStats = false; // whether the fields below were recorded (only with BOOKLIBRARY_METRICS)
+	long long lookups = 0; // chain walks done by insert/delete/update/get/exists
+	double meanChainWalk = 0; // average nodes looked at per lookup
+	uint64_t p99ChainWalk = 0;
+	uint64_t maxChainWalk = 0;
+};
+
+// Snapshot of a Bloom filter in front of one of the library's lookups
+struct BloomFilterStats {
+	long long capacity = 0; // keys the filter was sized for
+	long long bits = 0;
+	long long keys = 0; // keys added since the last rebuild
+	long long staleKeys = 0; // keys deleted since the last rebuild, which are still in the filter
+	long long queries = 0; // checks since the last rebuild
+	long long negatives = 0; // checks the filter answered by itself
+	long long falsePositives = 0; // checks the filter let through for keys that weren't there
+	double observedFalsePositiveRate = 0;
+	double estimatedFalsePositiveRate = 0; // from how full the filter is
+	long long rebuilds = 0;
+};
+
+// Snapshot of the hot title cache
+struct CacheStats {
+	int capacity = 0;
+	int entries = 0;
+	long long hits = 0;
+	long long misses = 0;
+	long long evictions = 0;
+	long long invalidations = 0; // entries removed because their book was deleted
+	double hitRate = 0;
+};
+
+// Counts and times every library operation
+class LibraryMetrics {
+private:
+	LatencyHistogram operationLatency[NUM_LIBRARY_OPERATIONS]; // nanoseconds for each call
+public:
+	void recordOperation(LibraryOperation op, uint64_t nanoseconds) {
+		operationLatency[op].recordValue(nanoseconds);
+	}
+
+	const LatencyHistogram& getOperationLatency(LibraryOperation op) const {
+		return operationLatency[op];
+	}
+
+	void reset() {
+		for (int i = 0; i < NUM_LIBRARY_OPERATIONS; i++) {
+			operationLatency[i].reset();
+		}
+	}
+};
+
+// Times the enclosing scope and records it for an operation when the scope ends
+class ScopedOperationTimer {
+private:
+	LibraryMetrics& metrics;
+	LibraryOperation op;
+	std::chrono::steady_clock::time_point start;
+public:
+	ScopedOperationTimer(LibraryMetrics& _metrics, LibraryOperation _op) : metrics(_metrics), op(_op) {
+		start = std::chrono::steady_clock::now();
+	}
+	~ScopedOperationTimer() {
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		metrics.recordOperation(op, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+	}
+};
+
+#ifdef BOOKLIBRARY_METRICS
+#define LIBRARY_TIME_OPERATION(metrics, op) ScopedOperationTimer operationTimer(metrics, op)
+#else
+#define LIBRARY_TIME_OPERATION(metrics, op)
+#endif
+
+// Writes the operation metrics and the stats of each named hash table as a JSON object,
+// and of each named Bloom filter and the title cache, if there are any
+void writeMetricsJSON(std::ostream& os, const LibraryMetrics* metrics, std::vector<std::string> tableNames, std::vector<HashTableStats> tableStats,
+	std::vector<std::string> filterNames = std::vector<std::string>(), std::vector<BloomFilterStats> filterStats = std::vector<BloomFilterStats>(),
+	const CacheStats* cacheStats = nullptr) {
+	os << "{" << std::endl;
+	os << "  \"metrics_enabled\": " << (metrics != nullptr ? "true" : "false") << "," << std::endl;
+	os << "  \"operations\": {";
+	for (int i = 0; metrics != nullptr && i < NUM_LIBRARY_OPERATIONS; i++) {
+		os << (i == 0 ? "" : ",") << std::endl << "    \"" << libraryOperationNames[i] << "\": {";
+		metrics->getOperationLatency(static_cast<LibraryOperation>(i)).writeJSONFields(os);
+		os << "}";
+	}
+	os << std::endl << "  }," << std::endl;
+	os << "  \"hash_tables\": {";
+	for (size_t i = 0; i < tableStats.size(); i++) {
+		const HashTableStats& stats = tableStats[i];
+		os << (i == 0 ? "" : ",") << std::endl << "    \"" << tableNames[i] << "\": {"
+			<< "\"buckets\": " << stats.numBuckets
+			<< ", \"pairs\": " << stats.numPairs
+			<< ", \"load_factor\": " << (stats.numBuckets > 0 ? static_cast<double>(stats.numPairs) / stats.numBuckets : 0.0)
+			<< ", \"empty_buckets\": " << stats.emptyBuckets
+			<< ", \"longest_chain\": " << stats.longestChain
+			<< ", \"resizes\": " << stats.resizes;
+		if (stats.hasLookupStats) {
+			os << ", \"lookups\": " << stats.lookups
+				<< ", \"mean_chain_walk\": " << stats.meanChainWalk
+				<< ", \"p99_chain_walk\": " << stats.p99ChainWalk
+				<< ", \"max_chain_walk\": " << stats.maxChainWalk;
+		}
+		os << "}";
+	}
+	os << std::endl << "  }";
+	if (!filterStats.empty()) {
+		os << "," << std::endl << "  \"bloom_filters\": {";
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			const BloomFilterStats& stats = filterStats[i];
+			os << (i == 0 ? "" : ",") << std::endl << "    \"" << filterNames[i] << "\": {"
+				<< "\"capacity\": " << stats.capacity
+				<< ", \"bits\": " << stats.bits
+				<< ", \"keys\": " << stats.keys
+				<< ", \"stale_keys\": " << stats.staleKeys
+				<< ", \"queries\": " << stats.queries
+				<< ", \"negatives\": " << stats.negatives
+				<< ", \"false_positives\": " << stats.falsePositives
+				<< ", \"observed_false_positive_rate\": " << stats.observedFalsePositiveRate
+				<< ", \"estimated_false_positive_rate\": " << stats.estimatedFalsePositiveRate
+				<< ", \"rebuilds\": " << stats.rebuilds << "}";
+		}
+		os << std::endl << "  }";
+	}
+	if (cacheStats != nullptr) {
+		os << "," << std::endl << "  \"title_cache\": {"
+			<< "\"capacity\": " << cacheStats->capacity
+			<< ", \"entries\": " << cacheStats->entries
+			<< ", \"hits\": " << cacheStats->hits
+			<< ", \"misses\": " << cacheStats->misses
+			<< ", \"hit_rate\": " << cacheStats->hitRate
+			<< ", \"evictions\": " << cacheStats->evictions
+			<< ", \"invalidations\": " << cacheStats->invalidations << "}";
+	}
+	os << std::endl << "}" << std::endl;
+}
+
+// Writes the same information in the Prometheus text exposition format
+void writeMetricsPrometheus(std::ostream& os, const LibraryMetrics* metrics, std::vector<std::string> tableNames, std::vector<HashTableStats> tableStats,
+	std::vector<std::string> filterNames = std::vector<std::string>(), std::vector<BloomFilterStats> filterStats = std::vector<BloomFilterStats>(),
+	const CacheStats* cacheStats = nullptr) {
+	if (metrics != nullptr) {
+		const double quantiles[4] = { 50, 90, 99, 99.9 };
+		os << "# HELP booklibrary_operation_latency_seconds Latency of library operations." << std::endl;
+		os << "# TYPE booklibrary_operation_latency_seconds summary" << std::endl;
+		for (int i = 0; i < NUM_LIBRARY_OPERATIONS; i++) {
+			const LatencyHistogram& latency = metrics->getOperationLatency(static_cast<LibraryOperation>(i));
+			std::string label = std::string("operation=\"") + libraryOperationNames[i] + "\"";
+			for (int j = 0; j < 4; j++) {
+				os << "booklibrary_operation_latency_seconds{" << label << ",quantile=\"" << quantiles[j] / 100 << "\"} "
+					<< latency.valueAtPercentile(quantiles[j]) / 1e9 << std::endl;
+			}
+			os << "booklibrary_operation_latency_seconds_sum{" << label << "} " << latency.getMean() * latency.getTotalCount() / 1e9 << std::endl;
+			os << "booklibrary_operation_latency_seconds_count{" << label << "} " << latency.getTotalCount() << std::endl;
+		}
+	}
+	os << "# HELP booklibrary_hashtable_buckets Number of buckets in the hash table." << std::endl;
+	os << "# TYPE booklibrary_hashtable_buckets gauge" << std::endl;
+	for (size_t i = 0; i < tableStats.size(); i++) {
+		os << "booklibrary_hashtable_buckets{table=\"" << tableNames[i] << "\"} " << tableStats[i].numBuckets << std::endl;
+	}
+	os << "# HELP booklibrary_hashtable_pairs Number of key-value pairs in the hash table." << std::endl;
+	os << "# TYPE booklibrary_hashtable_pairs gauge" << std::endl;
+	for (size_t i = 0; i < tableStats.size(); i++) {
+		os << "booklibrary_hashtable_pairs{table=\"" << tableNames[i] << "\"} " << tableStats[i].numPairs << std::endl;
+	}
+	os << "# HELP booklibrary_hashtable_empty_buckets Number of buckets with an empty chain." << std::endl;
+	os << "# TYPE booklibrary_hashtable_empty_buckets gauge" << std::endl;
+	for (size_t i = 0; i < tableStats.size(); i++) {
+		os << "booklibrary_hashtable_empty_buckets{table=\"" << tableNames[i] << "\"} " << tableStats[i].emptyBuckets << std::endl;
+	}
+	os << "# HELP booklibrary_hashtable_longest_chain Number of nodes in the longest chain." << std::endl;
+	os << "# TYPE booklibrary_hashtable_longest_chain gauge" << std::endl;
+	for (size_t i = 0; i < tableStats.size(); i++) {
+		os << "booklibrary_hashtable_longest_chain{table=\"" << tableNames[i] << "\"} " << tableStats[i].longestChain << std::endl;
+	}
+	os << "# HELP booklibrary_hashtable_resizes_total Number of times the hash table grew." << std::endl;
+	os << "# TYPE booklibrary_hashtable_resizes_total counter" << std::endl;
+	for (size_t i = 0; i < tableStats.size(); i++) {
+		os << "booklibrary_hashtable_resizes_total{table=\"" << tableNames[i] << "\"} " << tableStats[i].resizes << std::endl;
+	}
+	if (metrics != nullptr) {
+		os << "# HELP booklibrary_hashtable_lookups_total Number of chain walks done by the hash table." << std::endl;
+		os << "# TYPE booklibrary_hashtable_lookups_total counter" << std::endl;
+		for (size_t i = 0; i < tableStats.size(); i++) {
+			os << "booklibrary_hashtable_lookups_total{table=\"" << tableNames[i] << "\"} " << tableStats[i].lookups << std::endl;
+		}
+		os << "# HELP booklibrary_hashtable_chain_walk Nodes looked at per lookup." << std::endl;
+		os << "# TYPE booklibrary_hashtable_chain_walk gauge" << std::endl;
+		for (size_t i = 0; i < tableStats.size(); i++) {
+			std::string label = "table=\"" + tableNames[i] + "\"";
+			os << "booklibrary_hashtable_chain_walk{" << label << ",stat=\"mean\"} " << tableStats[i].meanChainWalk << std::endl;
+			os << "booklibrary_hashtable_chain_walk{" << label << ",stat=\"p99\"} " << tableStats[i].p99ChainWalk << std::endl;
+			os << "booklibrary_hashtable_chain_walk{" << label << ",stat=\"max\"} " << tableStats[i].maxChainWalk << std::endl;
+		}
+	}
+	if (!filterStats.empty()) {
+		os << "# HELP booklibrary_bloom_queries_total Checks made against the Bloom filter since it was last rebuilt." << std::endl;
+		os << "# TYPE booklibrary_bloom_queries_total counter" << std::endl;
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			os << "booklibrary_bloom_queries_total{filter=\"" << filterNames[i] << "\"} " << filterStats[i].queries << std::endl;
+		}
+		os << "# HELP booklibrary_bloom_negatives_total Checks the Bloom filter answered without the lookup behind it." << std::endl;
+		os << "# TYPE booklibrary_bloom_negatives_total counter" << std::endl;
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			os << "booklibrary_bloom_negatives_total{filter=\"" << filterNames[i] << "\"} " << filterStats[i].negatives << std::endl;
+		}
+		os << "# HELP booklibrary_bloom_false_positives_total Checks the Bloom filter let through for keys that weren't there." << std::endl;
+		os << "# TYPE booklibrary_bloom_false_positives_total counter" << std::endl;
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			os << "booklibrary_bloom_false_positives_total{filter=\"" << filterNames[i] << "\"} " << filterStats[i].falsePositives << std::endl;
+		}
+		os << "# HELP booklibrary_bloom_false_positive_rate False positive rate of the Bloom filter." << std::endl;
+		os << "# TYPE booklibrary_bloom_false_positive_rate gauge" << std::endl;
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			std::string label = "filter=\"" + filterNames[i] + "\"";
+			os << "booklibrary_bloom_false_positive_rate{" << label << ",source=\"observed\"} " << filterStats[i].observedFalsePositiveRate << std::endl;
+			os << "booklibrary_bloom_false_positive_rate{" << label << ",source=\"estimated\"} " << filterStats[i].estimatedFalsePositiveRate << std::endl;
+		}
+		os << "# HELP booklibrary_bloom_keys Keys in the Bloom filter, including deleted ones it still has." << std::endl;
+		os << "# TYPE booklibrary_bloom_keys gauge" << std::endl;
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			os << "booklibrary_bloom_keys{filter=\"" << filterNames[i] << "\"} " << filterStats[i].keys << std::endl;
+		}
+		os << "# HELP booklibrary_bloom_rebuilds_total Number of times the Bloom filter was rebuilt." << std::endl;
+		os << "# TYPE booklibrary_bloom_rebuilds_total counter" << std::endl;
+		for (size_t i = 0; i < filterStats.size(); i++) {
+			os << "booklibrary_bloom_rebuilds_total{filter=\"" << filterNames[i] << "\"} " << filterStats[i].rebuilds << std::endl;
+		}
+	}
+	if (cacheStats != nullptr) {
+		os << "# HELP booklibrary_title_cache_lookups_total Title lookups that went through the hot title cache." << std::endl;
+		os << "# TYPE booklibrary_title_cache_lookups_total counter" << std::endl;
+		os << "booklibrary_title_cache_lookups_total{result=\"hit\"} " << cacheStats->hits << std::endl;
+		os << "booklibrary_title_cache_lookups_total{result=\"miss\"} " << cacheStats->misses << std::endl;
+		os << "# HELP booklibrary_title_cache_hit_rate Fraction of title lookups answered by the hot title cache." << std::endl;
+		os << "# TYPE booklibrary_title_cache_hit_rate gauge" << std::endl;
+		os << "booklibrary_title_cache_hit_rate " << cacheStats->hitRate << std::endl;
+		os << "# HELP booklibrary_title_cache_evictions_total Entries the hot title cache evicted to make room." << std::endl;
+		os << "# TYPE booklibrary_title_cache_evictions_total counter" << std::endl;
+		os << "booklibrary_title_cache_evictions_total " << cacheStats->evictions << std::endl;
+		os << "# HELP booklibrary_title_cache_invalidations_total Entries removed because their book was deleted." << std::endl;
+		os << "# TYPE booklibrary_title_cache_invalidations_total counter" << std::endl;
+		os << "booklibrary_title_cache_invalidations_total " << cacheStats->invalidations << std::endl;
+		os << "# HELP booklibrary_title_cache_entries Entries in the hot title cache." << std::endl;
+		os << "# TYPE booklibrary_title_cache_entries gauge" << std::endl;
+		os << "booklibrary_title_cache_entries " << cacheStats->entries << std::endl;
+	}
+}
+
+#endif
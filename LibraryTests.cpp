@@ -0,0 +1,552 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include "BookLibrary.h"
+#include "dataLoader.h"
+#include "utilities.h"
+
+/*
++ Regression checks for the parts of the library that are easy to get subtly wrong: reading data files (quotes, line
+breaks in fields), bringing the books in line with a fresh file, books that share an ISBN, growing hash tables, due
+dates, holds, batches, snapshots and recorded traces. Each check builds its own small library and data
+files, so they don't depend on bookData.txt. The program prints each check that fails and exits with 1 if any did.
+
++ Usage:
+	LibraryTests
+*/
+
+int numFailures = 0;
+
+// Reports a check that didn't hold
+void check(bool condition, const std::string& description) {
+	if (!condition) {
+		std::cout << "FAILED: " << description << std::endl;
+		numFailures += 1;
+	}
+}
+
+// Writes text to a file as it is, so the checks control every quote and line break
+void writeFile(const std::string& fileName, const std::string& text) {
+	std::ofstream dataFile(fileName, std::ios::binary);
+	dataFile << text;
+}
+
+// Whether a library has exactly these books (title, author, ISBN and pages), in title order
+bool hasBooks(BookLibrary& library, std::vector<Book> expected) {
+	std::vector<Book> books = library.getAllBooks();
+	mergeSortInPlace(expected, true);
+	if (books.size() != expected.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < books.size(); i++) {
+		if (books[i].title != expected[i].title || books[i].author != expected[i].author || books[i].ISBN != expected[i].ISBN ||
+			books[i].numPages != expected[i].numPages) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// A quote in the middle of an unquoted field is just a character; only a field that starts with one is quoted. The
+// file is read by the eager loader and the lazy catalog, then exported and read back in.
+void testLoaderRoundTrip() {
+	std::string fileName = "libraryTestsQuotes.txt";
+	std::string exportName = "libraryTestsQuotesExport.txt";
+	writeFile(fileName,
+		"The 12\" Single,Someone,111,10\n"
+		"Plain Title,Author \"Nick\" Name,222,20\n"
+		"\"Quoted, With Comma\",A,333,30\n"
+		"\"Two\nLines\",B,444,40\n"
+		"\"She said \"\"hi\"\"\",C,555,50\n"
+		"Last Book,D,666,60\n");
+	std::vector<Book> expected = {
+		{"The 12\" Single", "Someone", "111", 10},
+		{"Plain Title", "Author \"Nick\" Name", "222", 20},
+		{"Quoted, With Comma", "A", "333", 30},
+		{"Two\nLines", "B", "444", 40},
+		{"She said \"hi\"", "C", "555", 50},
+		{"Last Book", "D", "666", 60}
+	};
+
+	BookLibrary eager;
+	eager.setVerbose(false);
+	loadBookData(eager, fileName, ',');
+	check(hasBooks(eager, expected), "loadBookData reads stray quotes in unquoted fields as characters");
+
+	BookLibrary lazy;
+	lazy.setVerbose(false);
+	lazy.startLoadingBooks(fileName, ',');
+	check(lazy.getBook("the 12\" single").ISBN == "111", "the lazy catalog finds a title with a stray quote");
+	check(lazy.getBook("Last Book").ISBN == "666", "a stray quote doesn't swallow the records after it");
+	lazy.finishLoadingBooks();
+	check(hasBooks(lazy, expected), "the lazy catalog reads the same books as loadBookData");
+
+	SyncReport report = eager.syncBooks(fileName, ',');
+	check(report.applied && report.numUnchanged == 6 && report.changes.empty(), "syncing with the same file changes nothing");
+
+	eager.exportBooks(exportName, EXPORT_CSV);
+	BookLibrary reloaded;
+	reloaded.setVerbose(false);
+	loadBookData(reloaded, exportName, ',');
+	check(hasBooks(reloaded, expected), "an exported book file loads back in unchanged");
+
+	std::remove(fileName.c_str());
+	std::remove(exportName.c_str());
+}
+
+// Loads a book file into a library, with its status messages off
+void loadLibrary(BookLibrary& library, const std::string& fileName) {
+	library.setVerbose(false);
+	loadBookData(library, fileName, ',');
+}
+
+// Renames in a sync are checked against the titles every book will end up with, so chains and cycles of renames work
+// whatever order their records are in, and only real clashes are rejected
+void testSyncRenames() {
+	std::string oldName = "libraryTestsSyncOld.txt";
+	std::string newName = "libraryTestsSyncNew.txt";
+	writeFile(oldName,
+		"X,A,1,10\n" "Y,B,2,10\n" "P,C,3,10\n" "Q,D,4,10\n" "R1,E,5,10\n" "R2,F,6,10\n" "R3,G,7,10\n");
+	// A takes B's title before B's record gives it up; C and D swap; E, F and G rotate
+	writeFile(newName,
+		"Y,A,1,10\n" "Z,B,2,10\n" "q,C,3,10\n" "P,D,4,10\n" "R2,E,5,10\n" "R3,F,6,10\n" "R1,G,7,10\n");
+	BookLibrary library;
+	loadLibrary(library, oldName);
+	library.addStudent("Test", "Student", "1");
+	Student student = library.getLibraryStudents()[0];
+	library.issueBook(library.getBook("X"), student);
+	library.issueBook(library.getBook("P"), student);
+	SyncReport report = library.syncBooks(newName, ',');
+	BookLibrary reloaded;
+	loadLibrary(reloaded, newName);
+	check(report.numUpdated == 7 && report.numRejected == 0, "chained, swapped and rotated renames are all applied");
+	check(hasBooks(library, reloaded.getAllBooks()), "the synced books match a fresh load of the file");
+	check(library.getBookByISBN("1").title == "Y" && !library.getBook("Y").isAvailable, "a renamed book keeps its loan");
+	check(library.getBook("q").author == "C" && library.getBook("P").author == "D", "title lookups follow a swap");
+	std::vector<issuedBookEntry> loans = library.getAllIssuedBookEntries();
+	check(loans.size() == 2 && loans[0].issuedBook.title == "Y" && loans[1].issuedBook.title == "q", "the loans show the new titles");
+
+	// Real clashes: a title a book is keeping, two records wanting the same title, and a rename that was counting on
+	// a title whose rename was rejected
+	writeFile(oldName, "K,A,1,10\n" "M,B,2,10\n" "N,C,3,10\n" "S,D,4,10\n" "T,E,5,10\n");
+	writeFile(newName, "K,A,1,10\n" "K,B,2,10\n" "W,C,3,10\n" "W,D,4,10\n" "M,E,5,10\n");
+	BookLibrary clashing;
+	loadLibrary(clashing, oldName);
+	report = clashing.syncBooks(newName, ',');
+	check(report.numUpdated == 1 && report.numRejected == 3, "only the renames that really clash are rejected");
+	check(clashing.getBook("W").ISBN == "3" && clashing.getBook("S").ISBN == "4", "the first record that wants a title gets it");
+	check(clashing.getBook("M").ISBN == "2" && clashing.getBook("T").ISBN == "5", "a rename waits on the title it wanted being given up");
+
+	std::remove(oldName.c_str());
+	std::remove(newName.c_str());
+}
+
+// Books can share an ISBN. When the one the ISBN index points at is deleted or given another ISBN, lookups by ISBN
+// find the next book with that ISBN instead of nothing
+void testSharedISBNs() {
+	for (int bloom = 0; bloom < 2; bloom++) {
+		BookLibrary library;
+		library.setVerbose(false);
+		library.enableBloomFilters(bloom == 1);
+		library.addBook("A", "Author", "1", 10);
+		library.addBook("B", "Author", "1", 20);
+		library.addBook("C", "Author", "1", 30);
+		int idOfB = library.getBook("B").bookID;
+		library.deleteBook("A");
+		check(library.getBookByISBN("1").title == "B", "deleting the book an ISBN finds hands the ISBN to the next book with it");
+		library.editBook("B", "B", "Author", "2", 20);
+		check(library.getBookByISBN("1").title == "C" && library.getBookByISBN("2").title == "B",
+			"giving a book a new ISBN hands its old one to the next book with it");
+		library.editBook("B", "B", "Author", "1", 20);
+		library.deleteBook("C");
+		check(library.getBookByISBN("1").title == "B", "a book that gets a shared ISBN back can take it over again");
+		library.addStudent("Test", "Student", "1");
+		Student student = library.getLibraryStudents()[0];
+		check(library.issueBooks(student, { "1" }).applied, "a batch finds a book by an ISBN it took over");
+		library.returnBook(library.getBook("B"), student);
+
+		// A sync matches the book by the ISBN it took over, so it keeps its ID
+		std::string fileName = "libraryTestsSharedISBN.txt";
+		writeFile(fileName, "B,Author,1,20\n");
+		SyncReport report = library.syncBooks(fileName, ',');
+		check(report.numUnchanged == 1 && report.numAdded == 0 && report.numRemoved == 0 && library.getBook("B").bookID == idOfB,
+			"a sync finds a book by an ISBN it took over");
+		library.deleteBook("B");
+		check(library.getBookByISBN("1").ISBN == "", "an ISBN is gone once every book with it is");
+		std::remove(fileName.c_str());
+	}
+}
+
+// A hash table grows by moving its nodes to new buckets. Every key is still found, iterated over once and removable
+// after a grow, and a pointer to a value taken before the grow still points at it
+template <class Table>
+void checkGrowingTable(Table& table, const std::string& name) {
+	const int numKeys = 5000;
+	int* firstValue = table.insertPairAndFind("key 0", 0);
+	for (int i = 1; i < numKeys; i++) {
+		table.insertPair("key " + std::to_string(i), i);
+	}
+	HashTableStats stats = table.getStats();
+	check(stats.resizes > 0 && stats.numBuckets >= numKeys / 2, name + " grows as keys are added");
+	check(stats.numPairs == numKeys && table.findValue("key 0") == firstValue && *firstValue == 0,
+		name + " keeps values at the same address when it grows");
+	bool allFound = true;
+	for (int i = 0; i < numKeys; i++) {
+		int* value = table.findValue("key " + std::to_string(i));
+		allFound = allFound && value != nullptr && *value == i;
+	}
+	check(allFound && !table.isExistingKey("key " + std::to_string(numKeys)), name + " finds every key after growing");
+	std::vector<int> timesVisited(numKeys, 0);
+	table.forEachPair([&timesVisited](const std::string&, int value) { timesVisited[value] += 1; });
+	check(std::count(timesVisited.begin(), timesVisited.end(), 1) == numKeys, name + " visits every pair once after growing");
+	bool allRemoved = true;
+	for (int i = 0; i < numKeys; i += 2) {
+		allRemoved = allRemoved && table.deletePair("key " + std::to_string(i));
+	}
+	bool restFound = true;
+	for (int i = 0; i < numKeys; i++) {
+		restFound = restFound && table.isExistingKey("key " + std::to_string(i)) == (i % 2 == 1);
+	}
+	check(allRemoved && restFound && table.getNumPairs() == numKeys / 2, name + " removes keys after growing");
+}
+
+void testHashTableGrowth() {
+	HashTable<int> primeTable;
+	checkGrowingTable(primeTable, "a prime bucket table");
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> powerOfTwoTable(8);
+	checkGrowingTable(powerOfTwoTable, "a power of two bucket table");
+}
+
+// Loans come due a loan period after they're issued, by the library's clock, and the due date reports follow renewals
+// and returns
+void testDueDates() {
+	BookLibrary library;
+	library.setVerbose(false);
+	long long now = 1000000000;
+	library.setClock([&now]() { return now; });
+	library.setLoanPeriodDays(14);
+	const long long day = 24 * 60 * 60;
+	library.addBook("A", "Author", "1", 10);
+	library.addBook("B", "Author", "2", 10);
+	library.addStudent("Test", "Student", "1");
+	Student student = library.getLibraryStudents()[0];
+	library.issueBook(library.getBook("A"), student);
+	now += day;
+	library.issueBook(library.getBook("B"), student);
+
+	now += 13 * day - 60 * 60;
+	check(library.getNumOverdueLoans() == 0, "a loan isn't overdue an hour before it's due");
+	std::vector<issuedBookEntry> dueSoon = library.getLoansDueWithin(2 * 60 * 60);
+	check(dueSoon.size() == 1 && dueSoon[0].issuedBook.title == "A", "a loan shows up as due soon before it's overdue");
+	now += 60 * 60 + 2 * 60;
+	std::vector<issuedBookEntry> overdue = library.getOverdueLoans();
+	check(overdue.size() == 1 && overdue[0].issuedBook.title == "A", "a loan is overdue a couple of minutes after it's due");
+	check(library.renewLoan(library.getBook("A"), student) && library.getNumOverdueLoans() == 0, "renewing a loan takes it out of the overdue ones");
+
+	now += day;
+	overdue = library.getOverdueLoans();
+	check(overdue.size() == 1 && overdue[0].issuedBook.title == "B", "the next loan comes due on its own day");
+	library.returnBook(library.getBook("B"), student);
+	check(library.getNumOverdueLoans() == 0, "returning an overdue book takes it out of the overdue ones");
+	now += 13 * day + 2 * 60;
+	check(library.getNumOverdueLoans() == 1, "a renewed loan comes due a loan period after the renewal");
+}
+
+// Returning a book that students are waiting for hands it straight to the first one in line: higher priorities first,
+// then in the order the holds were placed
+void testHoldHandOff() {
+	BookLibrary library;
+	library.setVerbose(false);
+	library.addBook("A", "Author", "1", 10);
+	std::vector<Student> students;
+	for (int i = 0; i < 4; i++) {
+		library.addStudent("Student", std::to_string(i), std::to_string(i + 1));
+		students.push_back(library.getLibraryStudents()[i]);
+	}
+	check(!library.placeHold(library.getBook("A"), students[1]), "a book on the shelf can't be held");
+	library.issueBook(library.getBook("A"), students[0]);
+	library.placeHold(library.getBook("A"), students[1]);
+	library.placeHold(library.getBook("A"), students[2]);
+	library.placeHold(library.getBook("A"), students[3], 1);
+	check(!library.placeHold(library.getBook("A"), students[1]), "a student can't hold the same book twice");
+	check(library.getNumHolds(library.getBook("A")) == 3 && library.getHoldPosition(library.getBook("A"), students[3]) == 1 &&
+		library.getHoldPosition(library.getBook("A"), students[2]) == 3, "a higher priority hold goes ahead of the others");
+
+	library.returnBook(library.getBook("A"), students[0]);
+	check(library.isIssuedTo(library.getBook("A"), students[3]) && library.getNumHolds(library.getBook("A")) == 2,
+		"a returned book goes to the first student in line");
+	check(!library.renewLoan(library.getBook("A"), students[3]), "a loan can't be renewed while others are waiting");
+	library.returnBook(library.getBook("A"), students[3]);
+	check(library.isIssuedTo(library.getBook("A"), students[1]), "holds with the same priority are served in order");
+	check(library.cancelHold(library.getBook("A"), students[2]) && library.getNumHolds(library.getBook("A")) == 0,
+		"a student can take themselves off a waitlist");
+	library.returnBook(library.getBook("A"), students[1]);
+	check(library.getBook("A").isAvailable && library.getNumIssuedBooks() == 0, "a book nobody is waiting for goes back on the shelf");
+}
+
+// A batch of issues or returns is all or nothing: if any item can't be done, none of them are
+void testBatches() {
+	BookLibrary library;
+	library.setVerbose(false);
+	library.addBook("A", "Author", "1", 10);
+	library.addBook("B", "Author", "2", 10);
+	library.addBook("C", "Author", "3", 10);
+	library.addStudent("Test", "Student", "1");
+	library.addStudent("Other", "Student", "2");
+	Student student = library.getLibraryStudents()[0];
+	Student other = library.getLibraryStudents()[1];
+	library.issueBook(library.getBook("C"), other);
+
+	BatchResult result = library.issueBooks(student, { "A", "B", "Missing" });
+	check(!result.applied && result.failedItem == 2 && library.getNumIssuedBooks() == 1 && library.getBook("A").isAvailable,
+		"a batch with a book that isn't there issues nothing");
+	result = library.issueBooks(student, { "A", "C" });
+	check(!result.applied && result.failedItem == 1 && library.getBook("A").isAvailable, "a batch with a book that's out issues nothing");
+	result = library.issueBooks(student, { "A", "1" });
+	check(!result.applied && library.getBook("A").isAvailable, "a batch with the same book twice issues nothing");
+	result = library.issueBooks(student, { "a", "2" });
+	check(result.applied && library.isIssuedTo(library.getBook("A"), student) && library.isIssuedTo(library.getBook("B"), student),
+		"a batch issues every book, by title or ISBN");
+
+	result = library.returnBooks(student, { "A", "C" });
+	check(!result.applied && result.failedItem == 1 && library.isIssuedTo(library.getBook("A"), student),
+		"a batch with a book that isn't issued to the student returns nothing");
+	result = library.returnBooks(student, { "B", "A" });
+	check(result.applied && library.getBook("A").isAvailable && library.getBook("B").isAvailable && library.getNumIssuedBooks() == 1,
+		"a batch returns every book");
+}
+
+// Titles of a snapshot's books, in title order, each marked with whether it's on the shelf
+std::vector<std::string> describeBooks(const std::vector<Book>& books) {
+	std::vector<std::string> descriptions;
+	for (size_t i = 0; i < books.size(); i++) {
+		descriptions.push_back(books[i].title + (books[i].isAvailable ? " on the shelf" : " out"));
+	}
+	return descriptions;
+}
+
+// A snapshot keeps showing the library as it was when it was taken, whatever changes after that
+void testSnapshotIsolation() {
+	BookLibrary library;
+	library.setVerbose(false);
+	library.addBook("A", "Author", "1", 10);
+	library.addBook("B", "Author", "2", 20);
+	library.addBook("C", "Author", "3", 30);
+	library.addStudent("Test", "Student", "1");
+	Student student = library.getLibraryStudents()[0];
+	library.issueBook(library.getBook("A"), student);
+	LibrarySnapshot before = library.takeSnapshot();
+	std::vector<std::string> booksBefore = { "A out", "B on the shelf", "C on the shelf" };
+
+	library.returnBook(library.getBook("A"), student);
+	library.issueBook(library.getBook("B"), student);
+	library.deleteBook("C");
+	library.addBook("D", "Author", "4", 40);
+	library.editBook("B", "B2", "Someone Else", "5", 50);
+	library.addStudent("New", "Student", "2");
+	check(describeBooks(before.getAllBooks()) == booksBefore, "a snapshot's books don't change");
+	std::vector<issuedBookEntry> loansBefore = before.getAllIssuedBookEntries();
+	check(loansBefore.size() == 1 && loansBefore[0].issuedBook.title == "A", "a snapshot's loans don't change");
+	check(before.getLibraryStudents().size() == 1, "a snapshot's students don't change");
+	bool detailsKept = true;
+	before.forEachBook([&detailsKept](const Book& book) {
+		detailsKept = detailsKept && book.author == "Author" && book.numPages == (book.title[0] - 'A' + 1) * 10;
+	});
+	check(detailsKept, "a snapshot keeps an edited book's old details");
+
+	LibrarySnapshot after = library.takeSnapshot();
+	check(describeBooks(after.getAllBooks()) == std::vector<std::string>({ "A on the shelf", "B2 out", "D on the shelf" }) &&
+		after.getLibraryStudents().size() == 2, "a new snapshot shows the changes");
+}
+
+// Runs a recorded operation (only the kinds testTraceRoundTrip records) on a library; returns whether it succeeded
+bool replayRecord(BookLibrary& library, const TraceRecord& record) {
+	const std::vector<std::string>& arguments = record.arguments;
+	switch (record.op) {
+		case TRACE_ADD_BOOK: {
+			int numBooks = library.getNumBooks();
+			library.addBook(arguments[0], arguments[1], arguments[2], static_cast<int>(record.number));
+			return library.getNumBooks() > numBooks;
+		}
+		case TRACE_ADD_STUDENT: {
+			int numStudents = library.getNumStudents();
+			library.addStudent(arguments[0], arguments[1], arguments[2]);
+			return library.getNumStudents() > numStudents;
+		}
+		case TRACE_GET_BOOK:
+			return library.getBook(arguments[0]).ISBN != "";
+		case TRACE_ISSUE_BOOK: {
+			int numIssued = library.getNumIssuedBooks();
+			library.issueBook(library.getBook(arguments[0]), Student(arguments[1], arguments[2], arguments[3]));
+			return library.getNumIssuedBooks() > numIssued;
+		}
+		case TRACE_RETURN_BOOK: {
+			Student student(arguments[1], arguments[2], arguments[3]);
+			bool wasIssued = library.isIssuedTo(library.getBook(arguments[0]), student);
+			library.returnBook(library.getBook(arguments[0]), student);
+			return wasIssued;
+		}
+		case TRACE_EDIT_BOOK:
+			return library.editBook(arguments[0], arguments[1], arguments[2], arguments[3], static_cast<int>(record.number));
+		case TRACE_ISSUE_BOOKS:
+			return library.issueBooks(Student(arguments[0], arguments[1], arguments[2]),
+				std::vector<std::string>(arguments.begin() + 3, arguments.end())).applied;
+		default:
+			return false;
+	}
+}
+
+// A recorded trace reads back with every operation's arguments, outcome and clock time, and replaying it on an empty
+// library ends up with the same books and loans
+void testTraceRoundTrip() {
+	std::string traceName = "libraryTestsTrace.bltrace";
+	BookLibrary library;
+	library.setVerbose(false);
+	long long now = 1000000000;
+	library.setClock([&now]() { return now; });
+	check(library.startTrace(traceName), "a trace can be started");
+	library.addBook("A", "Author", "1", 10);
+	library.addBook("B", "Author", "2", 20);
+	library.addBook("A", "Duplicate", "3", 30);
+	library.addStudent("Test", "Student", "1");
+	Student student = library.getLibraryStudents()[0];
+	Book copyOfA = library.getBook("A");
+	now += 60;
+	library.getBook("Missing");
+	library.issueBook(copyOfA, student);
+	now += 3600;
+	library.editBook("a", "A2", "New Author", "9", 11);
+	library.returnBook(copyOfA, student);
+	now -= 30;
+	library.issueBooks(student, { "B", "9" });
+	check(library.stopTrace() == 10, "every outside operation is recorded");
+
+	// What each record should hold: the operation, whether it succeeded, the clock and the arguments
+	struct ExpectedRecord {
+		TraceOperation op;
+		bool succeeded;
+		long long clockTime;
+		std::vector<std::string> arguments;
+		long long number;
+	};
+	long long start = 1000000000;
+	std::vector<ExpectedRecord> expected = {
+		{ TRACE_ADD_BOOK, true, start, { "A", "Author", "1" }, 10 },
+		{ TRACE_ADD_BOOK, true, start, { "B", "Author", "2" }, 20 },
+		{ TRACE_ADD_BOOK, false, start, { "A", "Duplicate", "3" }, 30 },
+		{ TRACE_ADD_STUDENT, true, start, { "Test", "Student", "1" }, 0 },
+		// Copying A with getBook is an operation too
+		{ TRACE_GET_BOOK, true, start, { "A" }, 0 },
+		{ TRACE_GET_BOOK, false, start + 60, { "Missing" }, 0 },
+		{ TRACE_ISSUE_BOOK, true, start + 60, { "A", "Test", "Student", "1" }, 0 },
+		{ TRACE_EDIT_BOOK, true, start + 3660, { "a", "A2", "New Author", "9" }, 11 },
+		// The return is recorded with the book's title as it is now, not the caller's old copy
+		{ TRACE_RETURN_BOOK, true, start + 3660, { "A2", "Test", "Student", "1" }, 0 },
+		{ TRACE_ISSUE_BOOKS, true, start + 3630, { "Test", "Student", "1", "B", "9" }, 0 }
+	};
+	OperationTraceReader reader;
+	check(reader.open(traceName), "a recorded trace can be opened");
+	std::vector<TraceRecord> records;
+	TraceRecord record;
+	while (reader.next(record)) {
+		records.push_back(record);
+	}
+	check(!reader.hasError() && records.size() == expected.size(), "a recorded trace reads back to the end");
+	bool recordsMatch = records.size() == expected.size();
+	for (size_t i = 0; recordsMatch && i < expected.size(); i++) {
+		const TraceRecord& got = records[i];
+		const ExpectedRecord& want = expected[i];
+		recordsMatch = got.op == want.op && got.succeeded == want.succeeded && got.clockTime == want.clockTime &&
+			got.arguments == want.arguments && (!traceHasNumber[got.op] || got.number == want.number);
+	}
+	check(recordsMatch, "each record has its operation, outcome, clock and arguments");
+
+	BookLibrary replayed;
+	replayed.setVerbose(false);
+	bool outcomesMatch = true;
+	for (size_t i = 0; i < records.size(); i++) {
+		if (replayRecord(replayed, records[i]) != records[i].succeeded) {
+			outcomesMatch = false;
+		}
+	}
+	check(outcomesMatch, "replaying a trace gives every operation the same outcome");
+	check(hasBooks(replayed, library.getAllBooks()) && replayed.getNumIssuedBooks() == 2 &&
+		replayed.isIssuedTo(replayed.getBook("A2"), student), "replaying a trace ends with the same books and loans");
+	std::remove(traceName.c_str());
+}
+
+// Editing a book's title, ISBN and page count at once moves it in every index, whichever of the optional ones are on
+// (0 is none, 1 is the Bloom filters and a warm title cache, 2 is a frozen catalog), and a copy of the book from
+// before the edit can still be returned
+void testEditBook() {
+	for (int mode = 0; mode < 3; mode++) {
+		BookLibrary library;
+		library.setVerbose(false);
+		library.enableTitleCache(mode == 1);
+		library.enableBloomFilters(mode == 1);
+		library.addBook("Old Title", "Old Author", "100", 10);
+		library.addBook("Other", "Author", "200", 20);
+		library.addStudent("Test", "Student", "1");
+		Student student = library.getLibraryStudents()[0];
+		if (mode == 1) {
+			for (int i = 0; i < 3; i++) {
+				library.getBook("Old Title");
+			}
+			check(library.getTitleCacheStats().hits > 0, "looking a title up again finds it in the title cache");
+		}
+		if (mode == 2) {
+			library.freezeCatalog();
+		}
+		Book oldCopy = library.getBook("Old Title");
+		library.issueBook(oldCopy, student);
+
+		check(library.editBook("old title", "New Title", "New Author", "300", 11), "a book can be edited by its title in any case");
+		Book edited = library.getBook("NEW TITLE");
+		check(edited.title == "New Title" && edited.author == "New Author" && edited.ISBN == "300" && edited.numPages == 11 &&
+			edited.bookID == oldCopy.bookID, "an edited book is found by its new title, ignoring case, and keeps its ID");
+		check(library.getBook("Old Title").ISBN == "" && library.getBook("old title").ISBN == "",
+			"an edited book isn't found by its old title any more");
+		check(library.getBookByISBN("300").title == "New Title" && library.getBookByISBN("100").ISBN == "",
+			"an edited book is found by its new ISBN and not its old one");
+		BookQuery oldPages;
+		oldPages.minPages = 10;
+		oldPages.maxPages = 10;
+		BookQuery newPages;
+		newPages.minPages = 11;
+		newPages.maxPages = 11;
+		check(library.countBooks(oldPages) == 0 && library.countBooks(newPages) == 1 &&
+			library.findBooks(newPages).size() == 1 && library.findBooks(newPages)[0].title == "New Title",
+			"an edited book is counted and found by its new page count only");
+		check(library.getBook("Other").ISBN == "200" && library.getBookByISBN("200").title == "Other",
+			"editing a book leaves the other books where they were");
+		check(library.isIssuedTo(oldCopy, student), "a loan follows a book through an edit");
+
+		library.returnBook(oldCopy, student);
+		check(library.getNumIssuedBooks() == 0 && !library.isIssuedTo(edited, student),
+			"a book can be returned with a copy from before it was edited");
+		check(library.getBook("Old Title").ISBN == "" && library.getBook("New Title").ISBN == "300",
+			"returning an edited book doesn't bring back its old title");
+	}
+}
+
+int main() {
+	testLoaderRoundTrip();
+	testSyncRenames();
+	testSharedISBNs();
+	testHashTableGrowth();
+	testDueDates();
+	testHoldHandOff();
+	testBatches();
+	testSnapshotIsolation();
+	testTraceRoundTrip();
+	testEditBook();
+	if (numFailures > 0) {
+		std::cout << "Library Tests: " << numFailures << " check(s) failed!" << std::endl;
+		return 1;
+	}
+	std::cout << "Library Tests: All checks passed!" << std::endl;
+	return 0;
+}
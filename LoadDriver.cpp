@@ -0,0 +1,239 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include "BookLibrary.h"
+#include "dataLoader.h"
+#include "LatencyHistogram.h"
+#include "utilities.h"
+
+/*
++ Replays an operation trace made by WorkloadGenerator against a BookLibrary loaded from the same data files,
+and reports the throughput along with latency percentiles for each kind of operation. Each operation is timed
+the way the desk would do it: an issue or return includes looking the book up first.
+
++ Usage:
+	LoadDriver [--books bookData.txt] [--students studentData.txt] [--trace trace.txt] [--json <outputFile>] [--freeze] [--bloom] [--no-cache]
+	           [--record <binaryTrace>] [--lazy]
+
+	--freeze     Freeze the catalog after loading it, so title lookups go through the perfect hash
+	--bloom      Put Bloom filters in front of the title, ISBN and student ID lookups (and report how they did)
+	--no-cache   Turn off the hot title cache
+	--record     Record the library operations the replay makes to a binary trace, for TraceReplay
+	--lazy       Start replaying as soon as the book file is indexed: books are loaded when they're looked up, and the
+	             rest are added between operations. That time is reported on its own (lazy_load_seconds) and left
+	             out of the replay time and throughput; a lookup that loads its book is timed as part of it.
+*/
+
+// Names of the operations a trace can contain; the index is used to pick the histogram
+const std::vector<std::string> operationNames = { "search", "miss", "issue", "return" };
+
+// Right aligns text in a column of the given width
+std::string padLeft(std::string text, size_t width) {
+	if (text.length() >= width) {
+		return text;
+	}
+	return std::string(width - text.length(), ' ') + text;
+}
+
+int main(int argc, char* argv[]) {
+	std::string bookFileName = "bookData.txt";
+	std::string studentFileName = "studentData.txt";
+	std::string traceFileName = "trace.txt";
+	std::string jsonFileName;
+	std::string recordFileName;
+	bool freeze = false;
+	bool bloom = false;
+	bool titleCache = true;
+	bool lazy = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--freeze") {
+			freeze = true;
+			continue;
+		}
+		if (arg == "--bloom") {
+			bloom = true;
+			continue;
+		}
+		if (arg == "--no-cache") {
+			titleCache = false;
+			continue;
+		}
+		if (arg == "--lazy") {
+			lazy = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cerr << "Usage: " << argv[0] << " [--books file] [--students file] [--trace file] [--json outputFile] [--freeze] [--bloom] [--no-cache] [--record file] [--lazy]" << std::endl;
+			return 2;
+		}
+		if (arg == "--books") {
+			bookFileName = argv[++i];
+		} else if (arg == "--students") {
+			studentFileName = argv[++i];
+		} else if (arg == "--trace") {
+			traceFileName = argv[++i];
+		} else if (arg == "--json") {
+			jsonFileName = argv[++i];
+		} else if (arg == "--record") {
+			recordFileName = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--books file] [--students file] [--trace file] [--json outputFile] [--freeze] [--bloom] [--no-cache] [--record file] [--lazy]" << std::endl;
+			return 2;
+		}
+	}
+
+	TaskScheduler backgroundScheduler(1);
+	BookLibrary library;
+	library.setVerbose(false);
+	library.setBackgroundScheduler(&backgroundScheduler);
+	library.enableBloomFilters(bloom);
+	library.enableTitleCache(titleCache);
+	auto loadStart = std::chrono::steady_clock::now();
+	if (lazy) {
+		if (!library.startLoadingBooks(bookFileName, ',')) {
+			return 2;
+		}
+	} else {
+		loadBookData(library, bookFileName, ',');
+	}
+	loadStudentData(library, studentFileName, ',');
+	if (freeze) {
+		library.freezeCatalog();
+	}
+	double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+	std::cerr << "Load Driver: Loaded data files in " << loadSeconds << " s" << std::endl;
+
+	// Fetch the students once and index them by ID, so finding the student isn't part of what we time
+	std::vector<Student> allStudents = library.getLibraryStudents();
+	std::unordered_map<std::string, Student> studentsByID;
+	for (size_t i = 0; i < allStudents.size(); i++) {
+		studentsByID[allStudents[i].getStudentID()] = allStudents[i];
+	}
+
+	// Read the whole trace before replaying it, so reading the file isn't timed either
+	std::ifstream traceFile(traceFileName);
+	std::vector<std::vector<std::string>> operations;
+	std::string currentLine;
+	while (std::getline(traceFile, currentLine)) {
+		std::vector<std::string> fields = splitLine(currentLine, ',');
+		if (!fields.empty()) {
+			operations.push_back(fields);
+		}
+	}
+	if (operations.empty()) {
+		std::cerr << "Load Driver: Trace '" << traceFileName << "' has no operations!" << std::endl;
+		return 2;
+	}
+
+	if (!recordFileName.empty() && !library.startTrace(recordFileName)) {
+		return 2;
+	}
+	std::vector<LatencyHistogram> histograms(operationNames.size());
+	long long skipped = 0;
+	std::chrono::steady_clock::duration lazyLoadTime(0); // time spent adding the catalog's books between operations
+	auto replayStart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < operations.size(); i++) {
+		const std::vector<std::string>& fields = operations[i];
+		size_t kind = 0;
+		while (kind < operationNames.size() && operationNames[kind] != fields[0]) {
+			kind += 1;
+		}
+		if (kind == operationNames.size() || fields.size() < 2 || (kind >= 2 && fields.size() < 3)) {
+			skipped += 1;
+			continue;
+		}
+		Student student;
+		if (kind >= 2) {
+			auto found = studentsByID.find(fields[2]);
+			if (found == studentsByID.end()) {
+				skipped += 1;
+				continue;
+			}
+			student = found->second;
+		}
+		auto start = std::chrono::steady_clock::now();
+		Book targetBook = library.getBook(fields[1]);
+		if (kind == 2 && targetBook.ISBN != "") {
+			library.issueBook(targetBook, student);
+		} else if (kind == 3 && targetBook.ISBN != "") {
+			library.returnBook(targetBook, student);
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		histograms[kind].recordValue(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		if (lazy) {
+			auto loadingStart = std::chrono::steady_clock::now();
+			library.continueLoadingBooks(std::chrono::microseconds(50));
+			lazyLoadTime += std::chrono::steady_clock::now() - loadingStart;
+		}
+	}
+	// The books added between operations aren't part of the replay, so their time is left out of it (and throughput)
+	double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart - lazyLoadTime).count();
+	if (lazy) {
+		std::cerr << "Load Driver: Added catalog books between operations for " << std::chrono::duration<double>(lazyLoadTime).count()
+			<< " s (not counted in the replay time)" << std::endl;
+	}
+	if (!recordFileName.empty()) {
+		std::cerr << "Load Driver: Recorded " << library.stopTrace() << " operations to '" << recordFileName << "'" << std::endl;
+	}
+
+	LatencyHistogram allOperations;
+	for (size_t i = 0; i < histograms.size(); i++) {
+		allOperations.add(histograms[i]);
+	}
+	long long replayed = allOperations.getTotalCount();
+
+	// Human readable summary on stderr, and JSON for saving and comparing runs
+	std::cerr << "Load Driver: Replayed " << replayed << " operations (" << skipped << " skipped) in " << replaySeconds
+		<< " s, " << (replaySeconds > 0 ? replayed / replaySeconds : 0) << " ops/s" << std::endl;
+	std::cerr << "Latency (ns)" << padLeft("count", 10) << " " << padLeft("p50", 10) << " " << padLeft("p99", 10)
+		<< " " << padLeft("p99.9", 10) << " " << padLeft("max", 10) << std::endl;
+	for (size_t i = 0; i <= histograms.size(); i++) {
+		const LatencyHistogram& histogram = i < histograms.size() ? histograms[i] : allOperations;
+		std::string name = i < histograms.size() ? operationNames[i] : "all";
+		name.resize(12, ' ');
+		std::cerr << name << padLeft(std::to_string(histogram.getTotalCount()), 10);
+		uint64_t values[4] = { histogram.valueAtPercentile(50), histogram.valueAtPercentile(99), histogram.valueAtPercentile(99.9), histogram.getMax() };
+		for (int j = 0; j < 4; j++) {
+			std::cerr << " " << padLeft(std::to_string(values[j]), 10);
+		}
+		std::cerr << std::endl;
+	}
+	// How much the Bloom filters saved; the stats are since each filter was last rebuilt
+	std::vector<BloomFilterStats> filterStats = library.getBloomFilterStats();
+	const char* const filterNames[3] = { "title", "isbn", "studentID" };
+	for (size_t i = 0; i < filterStats.size(); i++) {
+		std::cerr << "Bloom filter " << filterNames[i] << ": " << filterStats[i].negatives << " of " << filterStats[i].queries
+			<< " checks answered by the filter, false positive rate " << filterStats[i].observedFalsePositiveRate
+			<< ", rebuilt " << filterStats[i].rebuilds << " times" << std::endl;
+	}
+	if (titleCache) {
+		CacheStats cacheStats = library.getTitleCacheStats();
+		std::cerr << "Title cache: hit rate " << cacheStats.hitRate << " (" << cacheStats.hits << " hits, " << cacheStats.misses
+			<< " misses), " << cacheStats.evictions << " evictions" << std::endl;
+	}
+
+	std::ofstream jsonFile;
+	if (!jsonFileName.empty()) {
+		jsonFile.open(jsonFileName);
+	}
+	std::ostream& os = jsonFileName.empty() ? std::cout : jsonFile;
+	os << "{\"load_seconds\": " << loadSeconds
+		<< ", \"replay_seconds\": " << replaySeconds
+		<< ", \"lazy_load_seconds\": " << std::chrono::duration<double>(lazyLoadTime).count()
+		<< ", \"operations\": " << replayed
+		<< ", \"skipped\": " << skipped
+		<< ", \"throughput_ops_per_sec\": " << (replaySeconds > 0 ? replayed / replaySeconds : 0)
+		<< ", \"latency_ns\": {" << std::endl;
+	for (size_t i = 0; i <= histograms.size(); i++) {
+		const LatencyHistogram& histogram = i < histograms.size() ? histograms[i] : allOperations;
+		os << "  \"" << (i < histograms.size() ? operationNames[i] : "all") << "\": {";
+		histogram.writeJSONFields(os);
+		os << "}" << (i < histograms.size() ? "," : "") << std::endl;
+	}
+	os << "}}" << std::endl;
+	return 0;
+}
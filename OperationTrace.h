@@ -0,0 +1,335 @@
+#ifndef OPERATIONTRACE_H
+#define OPERATIONTRACE_H
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "HashTable.h"
+#include "CatalogExport.h"
+
+/*
++ Operation traces: a compact binary record of every BookLibrary operation, with its arguments, what it returned, how
+long it took, and the library's clock when it ran. A library records one after startTrace is called, and the
+TraceReplay program runs a trace again against a fresh library built from the same data files, so a slowdown seen at
+the desk can be reproduced and bisected offline.
+
++ File layout: the 8 byte magic "BLTRACE1", then one record after another, each:
+
+	- 1 byte: the TraceOperation, with the top bit set if the operation succeeded (found the book, issued it, ...)
+	- varint: how long the operation took, in nanoseconds
+	- zigzag varint: the library's clock (seconds since the epoch) minus the clock of the record before
+	- each string argument as a varint string number (how many depends on the operation; the batch operations write
+	a varint count first). Strings are numbered in the order they first show up; a number that hasn't been used yet
+	is followed by the string itself (varint length, then the bytes), and after that the number alone stands for it.
+	Titles and student IDs repeat a lot, so most arguments take a byte or two.
+	- a zigzag varint for the operations that have a number (pages for addBook and editBook, priority for placeHold)
+
++ NOTE: Only the operations called from outside the library are recorded. An operation the library calls itself, like
+the issueBook that hands a returned book to the next student on its waitlist, is part of the outer operation's record,
+and it happens again on its own when that operation is replayed.
+*/
+
+enum TraceOperation {
+	TRACE_GET_BOOK,
+	TRACE_GET_BOOK_BY_ISBN,
+	TRACE_ADD_BOOK,
+	TRACE_DELETE_BOOK,
+	TRACE_ISSUE_BOOK,
+	TRACE_RETURN_BOOK,
+	TRACE_RENEW_LOAN,
+	TRACE_PLACE_HOLD,
+	TRACE_CANCEL_HOLD,
+	TRACE_ADD_STUDENT,
+	TRACE_DELETE_STUDENT,
+	TRACE_FIND_STUDENT,
+	TRACE_ISSUE_BOOKS,
+	TRACE_RETURN_BOOKS,
+	TRACE_EDIT_BOOK,
+	NUM_TRACE_OPERATIONS
+};
+
+// Names used for each operation in the replay report, matching the ones in LibraryMetrics.h where there is one
+const char* const traceOperationNames[NUM_TRACE_OPERATIONS] = {
+	"get_book", "get_book_by_isbn", "add_book", "delete_book", "issue_book", "return_book", "renew_loan",
+	"place_hold", "cancel_hold", "add_student", "delete_student", "find_student", "issue_books", "return_books",
+	"edit_book"
+};
+
+// String arguments each operation has: a book's title (or ISBN), a student's first name, last name and ID, a new
+// book's title, author and ISBN, or an edited book's title and then its new title, author and ISBN. -1 is any number of them (a student's names and ID, then the titles or ISBNs of a
+// batch), with the count written first.
+const int traceArgumentCounts[NUM_TRACE_OPERATIONS] = { 1, 1, 3, 1, 4, 4, 4, 4, 4, 3, 1, 1, -1, -1, 4 };
+
+// Whether each operation has a number after its strings
+const bool traceHasNumber[NUM_TRACE_OPERATIONS] = { false, false, true, false, false, false, false, true, false, false, false, false, false, false, true };
+
+// One recorded operation
+struct TraceRecord {
+	TraceOperation op = TRACE_GET_BOOK;
+	bool succeeded = false;
+	uint64_t nanoseconds = 0;
+	long long clockTime = 0; // the library's clock when the operation ran
+	std::vector<std::string> arguments;
+	long long number = 0;
+};
+
+// Writes trace records to a file as they happen
+class OperationTraceWriter {
+private:
+	BufferedFileWriter writer;
+	HashTable<long long, std::string, FNV1aHash, PowerOfTwoBucketCount> stringNumbers;
+	long long numStrings = 0;
+	long long lastClockTime = 0;
+	long long numRecords = 0;
+	int depth = 0; // operations in progress, so the ones the library calls itself aren't recorded
+
+	void appendVarint(uint64_t value) {
+		while (value >= 0x80) {
+			writer.append(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		writer.append(static_cast<char>(value));
+	}
+
+	void appendZigzag(long long value) {
+		appendVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+	}
+
+	void appendString(const std::string& text) {
+		long long* number = stringNumbers.findValue(text);
+		if (number != nullptr) {
+			appendVarint(static_cast<uint64_t>(*number));
+			return;
+		}
+		stringNumbers.insertPair(text, numStrings);
+		appendVarint(static_cast<uint64_t>(numStrings));
+		numStrings += 1;
+		appendVarint(text.size());
+		writer.append(text);
+	}
+
+public:
+	OperationTraceWriter() {}
+
+	// Starts a new trace file; returns false if it can't be created
+	bool open(const std::string& fileName) {
+		stringNumbers.destroyHashTable();
+		numStrings = 0;
+		lastClockTime = 0;
+		numRecords = 0;
+		depth = 0;
+		if (!writer.open(fileName)) {
+			return false;
+		}
+		writer.append("BLTRACE1", 8);
+		return true;
+	}
+
+	// Writes out the rest of the trace; returns false if any of it couldn't be written
+	bool close() {
+		return writer.close();
+	}
+
+	// Called when an operation starts; returns whether it's an outer one, which should be recorded
+	bool beginOperation() {
+		depth += 1;
+		return depth == 1;
+	}
+
+	void endOperation() {
+		depth -= 1;
+	}
+
+	void write(const TraceRecord& record) {
+		writer.append(static_cast<char>(record.op | (record.succeeded ? 0x80 : 0)));
+		appendVarint(record.nanoseconds);
+		appendZigzag(record.clockTime - lastClockTime);
+		lastClockTime = record.clockTime;
+		if (traceArgumentCounts[record.op] < 0) {
+			appendVarint(record.arguments.size());
+		}
+		for (size_t i = 0; i < record.arguments.size(); i++) {
+			appendString(record.arguments[i]);
+		}
+		if (traceHasNumber[record.op]) {
+			appendZigzag(record.number);
+		}
+		numRecords += 1;
+	}
+
+	long long getNumRecords() {
+		return numRecords;
+	}
+};
+
+// Reads a whole trace file into memory and hands out its records in order
+class OperationTraceReader {
+private:
+	std::vector<char> data;
+	size_t position = 0;
+	std::vector<std::string> strings;
+	long long lastClockTime = 0;
+	bool corrupt = false;
+
+	bool readVarint(uint64_t& value) {
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (position >= data.size()) {
+				return false;
+			}
+			unsigned char byte = static_cast<unsigned char>(data[position++]);
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool readZigzag(long long& value) {
+		uint64_t encoded;
+		if (!readVarint(encoded)) {
+			return false;
+		}
+		value = static_cast<long long>(encoded >> 1) ^ -static_cast<long long>(encoded & 1);
+		return true;
+	}
+
+	bool readString(std::string& text) {
+		uint64_t number;
+		if (!readVarint(number) || number > strings.size()) {
+			return false;
+		}
+		if (number < strings.size()) {
+			text = strings[number];
+			return true;
+		}
+		uint64_t length;
+		if (!readVarint(length) || length > data.size() - position) {
+			return false;
+		}
+		text.assign(data.data() + position, length);
+		position += length;
+		strings.push_back(text);
+		return true;
+	}
+
+public:
+	OperationTraceReader() {}
+
+	// Reads a trace file; returns false if it can't be read or isn't a trace
+	bool open(const std::string& fileName) {
+		std::ifstream traceFile(fileName, std::ios::binary);
+		if (!traceFile) {
+			return false;
+		}
+		data.assign(std::istreambuf_iterator<char>(traceFile), std::istreambuf_iterator<char>());
+		position = 8;
+		strings.clear();
+		lastClockTime = 0;
+		corrupt = false;
+		return data.size() >= 8 && std::string(data.data(), 8) == "BLTRACE1";
+	}
+
+	// Reads the next record; returns false at the end of the trace, or at a record that's cut off or doesn't make
+	// sense (hasError tells which)
+	bool next(TraceRecord& record) {
+		if (position >= data.size() || corrupt) {
+			return false;
+		}
+		unsigned char opByte = static_cast<unsigned char>(data[position++]);
+		int op = opByte & 0x7F;
+		long long clockDelta;
+		corrupt = op >= NUM_TRACE_OPERATIONS || !readVarint(record.nanoseconds) || !readZigzag(clockDelta);
+		if (corrupt) {
+			return false;
+		}
+		record.op = static_cast<TraceOperation>(op);
+		record.succeeded = (opByte & 0x80) != 0;
+		lastClockTime += clockDelta;
+		record.clockTime = lastClockTime;
+		uint64_t numArguments = static_cast<uint64_t>(traceArgumentCounts[op]);
+		if (traceArgumentCounts[op] < 0) {
+			// Every argument takes at least a byte, which bounds a count that's been damaged
+			corrupt = !readVarint(numArguments) || numArguments > data.size() - position;
+		}
+		record.arguments.resize(corrupt ? 0 : numArguments);
+		for (size_t i = 0; i < record.arguments.size() && !corrupt; i++) {
+			corrupt = !readString(record.arguments[i]);
+		}
+		record.number = 0;
+		if (!corrupt && traceHasNumber[op]) {
+			corrupt = !readZigzag(record.number);
+		}
+		return !corrupt;
+	}
+
+	// Whether reading stopped at a damaged record rather than the end of the file (e.g. the program recording it crashed)
+	bool hasError() {
+		return corrupt;
+	}
+};
+
+/*
++ Records one library operation for the length of a scope, when the library is recording a trace: the arguments are
+copied when it starts, and the record is written with its time when the scope ends. When the library isn't recording,
+the writer is nullptr and this does nothing, so the arguments aren't even copied.
+*/
+class TracedOperation {
+private:
+	OperationTraceWriter* writer;
+	bool recording = false;
+	TraceRecord record;
+	std::chrono::steady_clock::time_point start;
+
+	void addArgument(const std::string& argument) {
+		record.arguments.push_back(argument);
+	}
+
+	void addArgument(const std::vector<std::string>& arguments) {
+		record.arguments.insert(record.arguments.end(), arguments.begin(), arguments.end());
+	}
+
+	void addArgument(long long number) {
+		record.number = number;
+	}
+
+public:
+	template <class... Arguments>
+	TracedOperation(OperationTraceWriter* _writer, TraceOperation op, const std::function<long long()>& clock, const Arguments&... arguments) : writer(_writer) {
+		if (writer == nullptr) {
+			return;
+		}
+		recording = writer->beginOperation();
+		if (recording) {
+			record.op = op;
+			record.clockTime = clock();
+			(addArgument(arguments), ...);
+			start = std::chrono::steady_clock::now();
+		}
+	}
+
+	TracedOperation(const TracedOperation&) = delete;
+	TracedOperation& operator=(const TracedOperation&) = delete;
+
+	~TracedOperation() {
+		if (writer == nullptr) {
+			return;
+		}
+		if (recording) {
+			auto elapsed = std::chrono::steady_clock::now() - start;
+			record.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+			writer->write(record);
+		}
+		writer->endOperation();
+	}
+
+	// Marks the operation as having done what it was asked to
+	void succeeded(bool _succeeded = true) {
+		record.succeeded = _succeeded;
+	}
+};
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef PERFECTHASHTABLE_H
+#define PERFECTHASHTABLE_H
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "HashTable.h"
+#include "BitOps.h"
+
+/*
++ Read-only hash table for a set of keys that won't change, built around a minimal perfect hash function in the
+style of BBHash. A minimal perfect hash maps each of the n keys to its own index in 0..n-1, so the keys and values
+are packed into two arrays of exactly n slots, and a lookup checks exactly one slot.
+
++ How the hash function is built: at level 0 every key is hashed into a bit array with gamma * n bits. Keys that
+landed on a bit by themselves get that bit set, and keys that collided with another key are retried at level 1 with
+a different hash and a bit array sized for just those keys, and so on. A key's index is the number of set bits before
+its bit across all the levels (a rank), which the rankCounts make quick to find. The few keys still colliding after
+maxLevels levels go in a small ordinary HashTable.
+
++ NOTE: With gamma = 1 this takes about 3 bits per key on top of the keys and values themselves. Building a level
+only needs atomic ORs into the bit arrays, so each level is built by several threads at once.
+*/
+template <class U>
+class PerfectHashTable {
+private:
+	static const int maxLevels = 24; // levels before the remaining keys go into fallbackIndexes
+	static const int wordsPerRankBlock = 8; // 64-bit words between saved rank counts (512 bits)
+
+	struct Level {
+		uint64_t numBits = 0;
+		std::vector<uint64_t> words; // bits of the keys that landed alone at this level
+		std::vector<uint32_t> rankCounts; // set bits in all earlier levels and blocks, at the start of each block
+	};
+
+	std::vector<Level> levels;
+	HashTable<int, std::string, FNV1aHash, PowerOfTwoBucketCount> fallbackIndexes; // keys that never landed alone
+	std::vector<std::string> keys; // keys[i] is the key whose index is i
+	std::vector<U> values; // values[i] is the value for keys[i]
+	uint32_t numLevelKeys = 0; // keys placed by the levels; fallback indexes come after these
+	bool built = false;
+
+	// Spreads a key's hash differently for each level (the splitmix64 finalizer)
+	static uint64_t levelHash(uint64_t keyHash, int level) {
+		uint64_t hashValue = keyHash + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(level + 1);
+		hashValue = (hashValue ^ (hashValue >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		hashValue = (hashValue ^ (hashValue >> 27)) * 0x94D049BB133111EBULL;
+		return hashValue ^ (hashValue >> 31);
+	}
+
+	// Bit that a key's hash lands on at a level; multiplying and keeping the high half maps the hash onto 0..numBits-1
+	// without the cost of a division
+	static uint64_t levelBit(uint64_t keyHash, int level, uint64_t numBits) {
+		return multiplyHigh(levelHash(keyHash, level), numBits);
+	}
+
+	// Runs work(begin, end) over 0..count split between numThreads threads
+	template <class Work>
+	static void runInParallel(size_t count, int numThreads, Work work) {
+		if (numThreads <= 1 || count < 4096) {
+			work(0, count);
+			return;
+		}
+		std::vector<std::thread> threads;
+		size_t chunk = (count + numThreads - 1) / numThreads;
+		for (int t = 0; t < numThreads; t++) {
+			size_t begin = chunk * t;
+			size_t end = begin + chunk < count ? begin + chunk : count;
+			if (begin >= end) {
+				break;
+			}
+			threads.push_back(std::thread(work, begin, end));
+		}
+		for (size_t t = 0; t < threads.size(); t++) {
+			threads[t].join();
+		}
+	}
+
+	// Index for a key's hash, or -1 if it's not one of the levels' keys
+	long long levelIndex(uint64_t keyHash) const {
+		for (size_t l = 0; l < levels.size(); l++) {
+			const Level& level = levels[l];
+			uint64_t bit = levelBit(keyHash, static_cast<int>(l), level.numBits);
+			size_t word = bit >> 6;
+			uint64_t mask = uint64_t(1) << (bit & 63);
+			if (level.words[word] & mask) {
+				// Rank: the saved count for the block, plus the set bits in the block before this one
+				uint64_t rank = level.rankCounts[word / wordsPerRankBlock];
+				for (size_t w = word - word % wordsPerRankBlock; w < word; w++) {
+					rank += countBits(level.words[w]);
+				}
+				rank += countBits(level.words[word] & (mask - 1));
+				return static_cast<long long>(rank);
+			}
+		}
+		return -1;
+	}
+
+	// Slot that a key would be in, or -1 if it can't be one of the keys
+	long long findSlot(const std::string& key) {
+		if (!built) {
+			return -1;
+		}
+		long long index = levelIndex(FNV1aHash::hash(key));
+		if (index < 0) {
+			int* fallbackIndex = fallbackIndexes.findValue(key);
+			if (fallbackIndex == nullptr) {
+				return -1;
+			}
+			index = *fallbackIndex;
+		}
+		// Keys that aren't in the table still hash to some slot, so check that it's really this key
+		if (keys[index] != key) {
+			return -1;
+		}
+		return index;
+	}
+
+public:
+	PerfectHashTable() {}
+
+	// Builds the table from the given keys and values (which have to be the same length, and the keys all different),
+	// replacing whatever was in it, using up to numThreads threads. gamma is the bits per key of each level's bit array;
+	// larger is faster to build and look up but takes more space.
+	void build(const std::vector<std::string>& newKeys, const std::vector<U>& newValues, int numThreads = 1, double gamma = 1.0) {
+		clear();
+		size_t numKeys = newKeys.size();
+		std::vector<uint64_t> keyHashes(numKeys);
+		runInParallel(numKeys, numThreads, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				keyHashes[i] = FNV1aHash::hash(newKeys[i]);
+			}
+		});
+
+		// Positions (in newKeys) of the keys that still need a level
+		std::vector<uint32_t> remaining(numKeys);
+		for (size_t i = 0; i < numKeys; i++) {
+			remaining[i] = static_cast<uint32_t>(i);
+		}
+		uint64_t setBitsSoFar = 0;
+		for (int l = 0; l < maxLevels && !remaining.empty(); l++) {
+			Level level;
+			uint64_t numWords = (static_cast<uint64_t>(remaining.size() * gamma) + 63) / 64;
+			if (numWords == 0) {
+				numWords = 1;
+			}
+			level.numBits = numWords * 64;
+			// Mark every bit that one key lands on, and separately every bit that more than one key lands on
+			std::vector<std::atomic<uint64_t>> seen(numWords);
+			std::vector<std::atomic<uint64_t>> collided(numWords);
+			for (uint64_t w = 0; w < numWords; w++) {
+				seen[w].store(0, std::memory_order_relaxed);
+				collided[w].store(0, std::memory_order_relaxed);
+			}
+			runInParallel(remaining.size(), numThreads, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					uint64_t bit = levelBit(keyHashes[remaining[i]], l, level.numBits);
+					uint64_t mask = uint64_t(1) << (bit & 63);
+					if (seen[bit >> 6].fetch_or(mask, std::memory_order_relaxed) & mask) {
+						collided[bit >> 6].fetch_or(mask, std::memory_order_relaxed);
+					}
+				}
+			});
+			level.words.resize(numWords);
+			level.rankCounts.resize((numWords + wordsPerRankBlock - 1) / wordsPerRankBlock);
+			for (uint64_t w = 0; w < numWords; w++) {
+				if (w % wordsPerRankBlock == 0) {
+					level.rankCounts[w / wordsPerRankBlock] = static_cast<uint32_t>(setBitsSoFar);
+				}
+				level.words[w] = seen[w].load(std::memory_order_relaxed) & ~collided[w].load(std::memory_order_relaxed);
+				setBitsSoFar += countBits(level.words[w]);
+			}
+			// Keys that collided try again at the next level
+			std::vector<uint32_t> collidedKeys;
+			for (size_t i = 0; i < remaining.size(); i++) {
+				uint64_t bit = levelBit(keyHashes[remaining[i]], l, level.numBits);
+				if (collided[bit >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (bit & 63))) {
+					collidedKeys.push_back(remaining[i]);
+				}
+			}
+			remaining.swap(collidedKeys);
+			levels.push_back(std::move(level));
+		}
+		numLevelKeys = static_cast<uint32_t>(setBitsSoFar);
+
+		// Put every key and value in its slot; different keys have different slots, so threads never share one
+		keys.resize(numKeys);
+		values.resize(numKeys);
+		for (size_t i = 0; i < remaining.size(); i++) {
+			fallbackIndexes.insertPair(newKeys[remaining[i]], static_cast<int>(numLevelKeys + i));
+			keys[numLevelKeys + i] = newKeys[remaining[i]];
+			values[numLevelKeys + i] = newValues[remaining[i]];
+		}
+		runInParallel(numKeys, numThreads, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				long long index = levelIndex(keyHashes[i]);
+				if (index >= 0) {
+					keys[index] = newKeys[i];
+					values[index] = newValues[i];
+				}
+			}
+		});
+		built = true;
+	}
+
+	// Empties the table; lookups miss until it's built again
+	void clear() {
+		levels.clear();
+		fallbackIndexes.destroyHashTable();
+		keys.clear();
+		values.clear();
+		numLevelKeys = 0;
+		built = false;
+	}
+
+	bool isBuilt() {
+		return built;
+	}
+
+	// Returns a pointer to the value stored with the given key, or a nullptr if there isn't one. The keys can't change,
+	// but the values can be updated through the pointer.
+	U* findValue(const std::string& key) {
+		long long index = findSlot(key);
+		if (index < 0) {
+			return nullptr;
+		}
+		return &values[index];
+	}
+
+	// Returns a pointer to the value in the slot the key maps to, without checking that the key is really in the table.
+	// For values that contain their own key (like a book's title), checking the value is quicker than checking keys[],
+	// since it saves looking at a second array; if the key isn't in the table this returns some other key's value, or
+	// a nullptr.
+	U* findCandidateValue(const std::string& key) {
+		if (!built) {
+			return nullptr;
+		}
+		uint64_t keyHash = FNV1aHash::hash(key);
+		long long index = levelIndex(keyHash);
+		if (index < 0) {
+			int* fallbackIndex = fallbackIndexes.findValue(key);
+			if (fallbackIndex == nullptr) {
+				return nullptr;
+			}
+			index = *fallbackIndex;
+		}
+		return &values[index];
+	}
+
+	bool isExistingKey(const std::string& key) {
+		return findSlot(key) >= 0;
+	}
+
+	int getNumPairs() {
+		return static_cast<int>(keys.size());
+	}
+
+	int getNumLevels() {
+		return static_cast<int>(levels.size());
+	}
+
+	// Bits per key that the hash function itself takes (the levels' bit arrays and rank counts), not counting the
+	// keys and values
+	double getBitsPerKey() {
+		if (keys.empty()) {
+			return 0.0;
+		}
+		uint64_t bits = 0;
+		for (size_t l = 0; l < levels.size(); l++) {
+			bits += levels[l].words.size() * 64 + levels[l].rankCounts.size() * 32;
+		}
+		return static_cast<double>(bits) / keys.size();
+	}
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef PERSISTENTVECTOR_H
+#define PERSISTENTVECTOR_H
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+
+/*
++ Persistent (copy-on-write) vector: copying one is O(1), and the copy never changes afterwards, however much the
+original is changed. It's a tree of 32-way nodes (the index's bits, five at a time from the top, pick the path down to
+a leaf of 32 values), held by shared_ptr. Setting a value copies only the nodes on the path to it that are shared with a
+copy, so a write after a copy costs about log32(n) node copies, and the nodes that didn't change stay shared. A node
+that no copy shares is changed in place, so with no copies around a write is just the walk down. Old versions are freed
+by the shared_ptrs as soon as the last copy of them is gone.
+
++ NOTE: A copy can be read on another thread while the original keeps changing, since a node that's shared is never
+written. The original and its copies each still belong to one thread at a time; they're not safe to change from two.
+*/
+template <class T>
+class PersistentVector {
+private:
+	static const int bits = 5;
+	static const size_t width = size_t(1) << bits;
+	static const size_t mask = width - 1;
+
+	struct Node {
+		std::vector<std::shared_ptr<Node>> children; // inner nodes
+		std::vector<T> values; // leaves
+	};
+
+	std::shared_ptr<Node> root;
+	int shift = 0; // bits of the index below the root's; 0 when the root is a leaf
+	size_t count = 0; // one past the highest index that's been set
+
+	// Makes the node in a slot safe to change: creates it if it isn't there, and copies it if anything else shares it
+	static Node* ownedNode(std::shared_ptr<Node>& slot, bool leaf) {
+		if (!slot) {
+			slot = std::make_shared<Node>();
+			if (leaf) {
+				slot->values.resize(width);
+			} else {
+				slot->children.resize(width);
+			}
+		} else if (slot.use_count() > 1) {
+			slot = std::make_shared<Node>(*slot);
+		} else {
+			// The last copy that shared this node may have just let go of it on another thread; make sure we see
+			// everything it did before we change the node
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		return slot.get();
+	}
+
+	template <class Visitor>
+	static void visitNode(const Node* node, int level, size_t firstIndex, size_t count, Visitor& visit) {
+		if (level == 0) {
+			for (size_t i = 0; i < width && firstIndex + i < count; i++) {
+				visit(firstIndex + i, node->values[i]);
+			}
+			return;
+		}
+		for (size_t i = 0; i < width; i++) {
+			size_t childFirst = firstIndex + (i << level);
+			if (childFirst >= count) {
+				return;
+			}
+			if (node->children[i]) {
+				visitNode(node->children[i].get(), level - bits, childFirst, count, visit);
+			}
+		}
+	}
+
+public:
+	PersistentVector() {}
+
+	// Sets the value at an index, growing the vector if it's past the end; the indexes in between hold T()
+	void set(size_t index, const T& value) {
+		while (index >= (width << shift)) {
+			// Add a level on top, with the current tree as its first child
+			if (root) {
+				std::shared_ptr<Node> newRoot = std::make_shared<Node>();
+				newRoot->children.resize(width);
+				newRoot->children[0] = root;
+				root = newRoot;
+			}
+			shift += bits;
+		}
+		Node* node = ownedNode(root, shift == 0);
+		for (int level = shift; level > 0; level -= bits) {
+			node = ownedNode(node->children[(index >> level) & mask], level == bits);
+		}
+		node->values[index & mask] = value;
+		if (index >= count) {
+			count = index + 1;
+		}
+	}
+
+	// Value at an index, or T() if it was never set
+	T get(size_t index) const {
+		if (index >= count || !root) {
+			return T();
+		}
+		const Node* node = root.get();
+		for (int level = shift; level > 0; level -= bits) {
+			node = node->children[(index >> level) & mask].get();
+			if (node == nullptr) {
+				return T();
+			}
+		}
+		return node->values[index & mask];
+	}
+
+	// Calls visit(index, value) for each index in order, skipping whole blocks of 32 that were never set
+	template <class Visitor>
+	void forEach(Visitor visit) const {
+		if (root) {
+			visitNode(root.get(), shift, 0, count, visit);
+		}
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	void clear() {
+		root.reset();
+		shift = 0;
+		count = 0;
+	}
+};
+
+#endif
@@ -0,0 +1,448 @@
+#ifndef ROARINGBITMAP_H
+#define ROARINGBITMAP_H
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include "BitOps.h"
+
+/*
++ Compressed bitmap for sets of 32 bit integers, in the style of Roaring bitmaps. The integers are split into chunks
+by their upper 16 bits, and each chunk that has anything in it gets a container for the lower 16 bits:
+	- an array container, which is a sorted list of values, when the chunk has at most 4096 values
+	- a bitset container, which is 1024 64-bit words (8KB), when the chunk has more than that
+So a sparse set costs 2 bytes per value and a dense one costs 1 bit per value, and AND/OR work a container at a
+time, using merges on arrays and word-by-word operations on bitsets.
+
++ NOTE: The library uses these for sets of book IDs, like the set of books that are available.
+*/
+
+// Container for the values in one 2^16 chunk
+struct RoaringContainer {
+	static const int arrayLimit = 4096; // most values an array container holds before it turns into a bitset
+	static const int numWords = 1024; // 64-bit words in a bitset container
+	bool isBitset = false;
+	std::vector<uint16_t> values; // sorted values when it's an array container
+	std::vector<uint64_t> words; // bits when it's a bitset container
+	int cardinality = 0;
+
+	bool contains(uint16_t value) const {
+		if (isBitset) {
+			return (words[value >> 6] >> (value & 63)) & 1;
+		}
+		return std::binary_search(values.begin(), values.end(), value);
+	}
+
+	// Adds a value; returns false if it was already there
+	bool add(uint16_t value) {
+		if (isBitset) {
+			uint64_t mask = uint64_t(1) << (value & 63);
+			if (words[value >> 6] & mask) {
+				return false;
+			}
+			words[value >> 6] |= mask;
+			cardinality += 1;
+			return true;
+		}
+		std::vector<uint16_t>::iterator position = std::lower_bound(values.begin(), values.end(), value);
+		if (position != values.end() && *position == value) {
+			return false;
+		}
+		values.insert(position, value);
+		cardinality += 1;
+		if (cardinality > arrayLimit) {
+			convertToBitset();
+		}
+		return true;
+	}
+
+	// Removes a value; returns false if it wasn't there
+	bool remove(uint16_t value) {
+		if (isBitset) {
+			uint64_t mask = uint64_t(1) << (value & 63);
+			if (!(words[value >> 6] & mask)) {
+				return false;
+			}
+			words[value >> 6] &= ~mask;
+			cardinality -= 1;
+			// Wait until it's well under the limit, so adding and removing right at the limit doesn't keep converting
+			if (cardinality <= arrayLimit / 2) {
+				convertToArray();
+			}
+			return true;
+		}
+		std::vector<uint16_t>::iterator position = std::lower_bound(values.begin(), values.end(), value);
+		if (position == values.end() || *position != value) {
+			return false;
+		}
+		values.erase(position);
+		cardinality -= 1;
+		return true;
+	}
+
+	void convertToBitset() {
+		words.assign(numWords, 0);
+		for (size_t i = 0; i < values.size(); i++) {
+			words[values[i] >> 6] |= uint64_t(1) << (values[i] & 63);
+		}
+		values.clear();
+		values.shrink_to_fit();
+		isBitset = true;
+	}
+
+	void convertToArray() {
+		values.clear();
+		values.reserve(cardinality);
+		forEach([this](uint16_t value) { values.push_back(value); });
+		words.clear();
+		words.shrink_to_fit();
+		isBitset = false;
+	}
+
+	// Calls visit(value) on every value, in increasing order
+	template <class Visitor>
+	void forEach(Visitor visit) const {
+		if (!isBitset) {
+			for (size_t i = 0; i < values.size(); i++) {
+				visit(values[i]);
+			}
+			return;
+		}
+		for (int i = 0; i < numWords; i++) {
+			uint64_t word = words[i];
+			while (word != 0) {
+				int bit = countTrailingZeros(word);
+				visit(static_cast<uint16_t>(i * 64 + bit));
+				word &= word - 1;
+			}
+		}
+	}
+
+	// Same as forEach, but stops as soon as visit returns false; returns whether it got through every value
+	template <class Visitor>
+	bool forEachWhile(Visitor visit) const {
+		if (!isBitset) {
+			for (size_t i = 0; i < values.size(); i++) {
+				if (!visit(values[i])) {
+					return false;
+				}
+			}
+			return true;
+		}
+		for (int i = 0; i < numWords; i++) {
+			uint64_t word = words[i];
+			while (word != 0) {
+				int bit = countTrailingZeros(word);
+				if (!visit(static_cast<uint16_t>(i * 64 + bit))) {
+					return false;
+				}
+				word &= word - 1;
+			}
+		}
+		return true;
+	}
+
+	// Adds every value of another container to this one, without building a new container
+	void orInPlace(const RoaringContainer& other) {
+		if (!isBitset && !other.isBitset && cardinality + other.cardinality <= arrayLimit) {
+			// Merge from the back into the space at the end, then drop the values that were in both
+			size_t mine = values.size();
+			size_t theirs = other.values.size();
+			values.resize(mine + theirs);
+			size_t position = mine + theirs;
+			while (theirs > 0) {
+				if (mine > 0 && values[mine - 1] > other.values[theirs - 1]) {
+					values[--position] = values[--mine];
+				} else {
+					values[--position] = other.values[--theirs];
+				}
+			}
+			values.erase(std::unique(values.begin(), values.end()), values.end());
+			cardinality = static_cast<int>(values.size());
+			return;
+		}
+		if (!isBitset) {
+			convertToBitset();
+		}
+		if (other.isBitset) {
+			for (int i = 0; i < numWords; i++) {
+				cardinality += countBits(other.words[i] & ~words[i]);
+				words[i] |= other.words[i];
+			}
+		} else {
+			for (size_t i = 0; i < other.values.size(); i++) {
+				uint16_t value = other.values[i];
+				uint64_t mask = uint64_t(1) << (value & 63);
+				if (!(words[value >> 6] & mask)) {
+					words[value >> 6] |= mask;
+					cardinality += 1;
+				}
+			}
+		}
+	}
+
+	// Number of values that are in both containers, without building the intersection
+	static int intersectionCount(const RoaringContainer& first, const RoaringContainer& second) {
+		int count = 0;
+		if (first.isBitset && second.isBitset) {
+			for (int i = 0; i < numWords; i++) {
+				count += countBits(first.words[i] & second.words[i]);
+			}
+		} else if (first.isBitset || second.isBitset) {
+			const RoaringContainer& array = first.isBitset ? second : first;
+			const RoaringContainer& bitset = first.isBitset ? first : second;
+			for (size_t i = 0; i < array.values.size(); i++) {
+				count += bitset.contains(array.values[i]);
+			}
+		} else {
+			size_t i = 0;
+			size_t j = 0;
+			while (i < first.values.size() && j < second.values.size()) {
+				if (first.values[i] < second.values[j]) {
+					i += 1;
+				} else if (first.values[i] > second.values[j]) {
+					j += 1;
+				} else {
+					count += 1;
+					i += 1;
+					j += 1;
+				}
+			}
+		}
+		return count;
+	}
+
+	// Container with the values that are in both containers
+	static RoaringContainer intersect(const RoaringContainer& first, const RoaringContainer& second) {
+		RoaringContainer result;
+		if (first.isBitset && second.isBitset) {
+			result.words.assign(numWords, 0);
+			result.isBitset = true;
+			for (int i = 0; i < numWords; i++) {
+				result.words[i] = first.words[i] & second.words[i];
+				result.cardinality += countBits(result.words[i]);
+			}
+			if (result.cardinality <= arrayLimit) {
+				result.convertToArray();
+			}
+		} else if (first.isBitset || second.isBitset) {
+			// Check each value of the array against the bitset
+			const RoaringContainer& array = first.isBitset ? second : first;
+			const RoaringContainer& bitset = first.isBitset ? first : second;
+			for (size_t i = 0; i < array.values.size(); i++) {
+				if (bitset.contains(array.values[i])) {
+					result.values.push_back(array.values[i]);
+				}
+			}
+			result.cardinality = static_cast<int>(result.values.size());
+		} else {
+			std::set_intersection(first.values.begin(), first.values.end(), second.values.begin(), second.values.end(), std::back_inserter(result.values));
+			result.cardinality = static_cast<int>(result.values.size());
+		}
+		return result;
+	}
+
+	// Container with the values that are in either container
+	static RoaringContainer unite(const RoaringContainer& first, const RoaringContainer& second) {
+		RoaringContainer result;
+		if (!first.isBitset && !second.isBitset && first.cardinality + second.cardinality <= arrayLimit) {
+			std::set_union(first.values.begin(), first.values.end(), second.values.begin(), second.values.end(), std::back_inserter(result.values));
+			result.cardinality = static_cast<int>(result.values.size());
+			return result;
+		}
+		result.words.assign(numWords, 0);
+		result.isBitset = true;
+		const RoaringContainer* containers[2] = { &first, &second };
+		for (int c = 0; c < 2; c++) {
+			if (containers[c]->isBitset) {
+				for (int i = 0; i < numWords; i++) {
+					result.words[i] |= containers[c]->words[i];
+				}
+			} else {
+				for (size_t i = 0; i < containers[c]->values.size(); i++) {
+					uint16_t value = containers[c]->values[i];
+					result.words[value >> 6] |= uint64_t(1) << (value & 63);
+				}
+			}
+		}
+		for (int i = 0; i < numWords; i++) {
+			result.cardinality += countBits(result.words[i]);
+		}
+		if (result.cardinality <= arrayLimit) {
+			result.convertToArray();
+		}
+		return result;
+	}
+};
+
+class RoaringBitmap {
+private:
+	std::vector<uint16_t> keys; // upper 16 bits of the values in each container, sorted
+	std::vector<RoaringContainer> containers; // containers[i] holds the values whose upper bits are keys[i]
+
+	// Index of the container for a key, or -1 if there isn't one
+	int findContainer(uint16_t key) const {
+		std::vector<uint16_t>::const_iterator position = std::lower_bound(keys.begin(), keys.end(), key);
+		if (position == keys.end() || *position != key) {
+			return -1;
+		}
+		return static_cast<int>(position - keys.begin());
+	}
+
+public:
+	bool contains(uint32_t value) const {
+		int index = findContainer(static_cast<uint16_t>(value >> 16));
+		return index >= 0 && containers[index].contains(static_cast<uint16_t>(value & 0xFFFF));
+	}
+
+	// Adds a value to the set; returns false if it was already in it
+	bool add(uint32_t value) {
+		uint16_t key = static_cast<uint16_t>(value >> 16);
+		std::vector<uint16_t>::iterator position = std::lower_bound(keys.begin(), keys.end(), key);
+		size_t index = position - keys.begin();
+		if (position == keys.end() || *position != key) {
+			keys.insert(position, key);
+			containers.insert(containers.begin() + index, RoaringContainer());
+		}
+		return containers[index].add(static_cast<uint16_t>(value & 0xFFFF));
+	}
+
+	// Removes a value from the set; returns false if it wasn't in it
+	bool remove(uint32_t value) {
+		int index = findContainer(static_cast<uint16_t>(value >> 16));
+		if (index < 0 || !containers[index].remove(static_cast<uint16_t>(value & 0xFFFF))) {
+			return false;
+		}
+		// Drop containers that become empty so they don't cost anything
+		if (containers[index].cardinality == 0) {
+			keys.erase(keys.begin() + index);
+			containers.erase(containers.begin() + index);
+		}
+		return true;
+	}
+
+	// Number of values in the set
+	long long cardinality() const {
+		long long total = 0;
+		for (size_t i = 0; i < containers.size(); i++) {
+			total += containers[i].cardinality;
+		}
+		return total;
+	}
+
+	bool isEmpty() const {
+		return containers.empty();
+	}
+
+	void clear() {
+		keys.clear();
+		containers.clear();
+	}
+
+	// Calls visit(value) on every value in the set, in increasing order
+	template <class Visitor>
+	void forEach(Visitor visit) const {
+		for (size_t i = 0; i < containers.size(); i++) {
+			uint32_t high = static_cast<uint32_t>(keys[i]) << 16;
+			containers[i].forEach([&visit, high](uint16_t low) { visit(high | low); });
+		}
+	}
+
+	// Same as forEach, but stops as soon as visit returns false
+	template <class Visitor>
+	void forEachWhile(Visitor visit) const {
+		for (size_t i = 0; i < containers.size(); i++) {
+			uint32_t high = static_cast<uint32_t>(keys[i]) << 16;
+			if (!containers[i].forEachWhile([&visit, high](uint16_t low) { return visit(high | low); })) {
+				return;
+			}
+		}
+	}
+
+	// Adds every value of another bitmap to this one (bitmap OR), reusing this bitmap's containers rather than
+	// building a new bitmap, so ORing many bitmaps into one doesn't copy it each time
+	void orInPlace(const RoaringBitmap& other) {
+		size_t i = 0;
+		for (size_t j = 0; j < other.keys.size(); j++) {
+			while (i < keys.size() && keys[i] < other.keys[j]) {
+				i += 1;
+			}
+			if (i < keys.size() && keys[i] == other.keys[j]) {
+				containers[i].orInPlace(other.containers[j]);
+			} else {
+				keys.insert(keys.begin() + i, other.keys[j]);
+				containers.insert(containers.begin() + i, other.containers[j]);
+			}
+			i += 1;
+		}
+	}
+
+	// Number of values that are in both bitmaps, without building the intersection
+	static long long intersectionCount(const RoaringBitmap& first, const RoaringBitmap& second) {
+		long long count = 0;
+		size_t i = 0;
+		size_t j = 0;
+		while (i < first.keys.size() && j < second.keys.size()) {
+			if (first.keys[i] < second.keys[j]) {
+				i += 1;
+			} else if (first.keys[i] > second.keys[j]) {
+				j += 1;
+			} else {
+				count += RoaringContainer::intersectionCount(first.containers[i], second.containers[j]);
+				i += 1;
+				j += 1;
+			}
+		}
+		return count;
+	}
+
+	// Set of values that are in both bitmaps (bitmap AND)
+	static RoaringBitmap intersect(const RoaringBitmap& first, const RoaringBitmap& second) {
+		RoaringBitmap result;
+		size_t i = 0;
+		size_t j = 0;
+		// Only chunks that both bitmaps have can have anything in common
+		while (i < first.keys.size() && j < second.keys.size()) {
+			if (first.keys[i] < second.keys[j]) {
+				i += 1;
+			} else if (first.keys[i] > second.keys[j]) {
+				j += 1;
+			} else {
+				RoaringContainer container = RoaringContainer::intersect(first.containers[i], second.containers[j]);
+				if (container.cardinality > 0) {
+					result.keys.push_back(first.keys[i]);
+					result.containers.push_back(container);
+				}
+				i += 1;
+				j += 1;
+			}
+		}
+		return result;
+	}
+
+	// Set of values that are in either bitmap (bitmap OR)
+	static RoaringBitmap unite(const RoaringBitmap& first, const RoaringBitmap& second) {
+		RoaringBitmap result;
+		size_t i = 0;
+		size_t j = 0;
+		while (i < first.keys.size() || j < second.keys.size()) {
+			if (j == second.keys.size() || (i < first.keys.size() && first.keys[i] < second.keys[j])) {
+				result.keys.push_back(first.keys[i]);
+				result.containers.push_back(first.containers[i]);
+				i += 1;
+			} else if (i == first.keys.size() || second.keys[j] < first.keys[i]) {
+				result.keys.push_back(second.keys[j]);
+				result.containers.push_back(second.containers[j]);
+				j += 1;
+			} else {
+				result.keys.push_back(first.keys[i]);
+				result.containers.push_back(RoaringContainer::unite(first.containers[i], second.containers[j]));
+				i += 1;
+				j += 1;
+			}
+		}
+		return result;
+	}
+};
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef STUDENT_H
 #define STUDENT_H
+#include <iostream>
 #include <string>
+#include <utility>
 
 /*
 +  Student class: Realistically in this program, the librarian shouldn't really have 
@@ -15,12 +17,22 @@ private:
 	std::string firstName;
 	std::string lastName;
 	std::string studentID; // An 8 digit ID 
+	// firstName + " " + lastName, built whenever either name changes rather than every time it's asked for.
+	// Sorting compares names O(n log n) times, so building the string on each comparison meant that many allocations.
+	std::string fullName;
+
+	void updateFullName() {
+		fullName.clear();
+		fullName.reserve(firstName.length() + 1 + lastName.length());
+		fullName += firstName;
+		fullName += ' ';
+		fullName += lastName;
+	}
 public:
-	// Constructor
-	Student(std::string _firstName, std::string _lastName, std::string _studentID) {
-		firstName = _firstName;
-		lastName = _lastName;
-		studentID = _studentID;
+	// Constructor; the strings are taken by value and moved in, so passing temporaries doesn't copy them
+	Student(std::string _firstName, std::string _lastName, std::string _studentID)
+		: firstName(std::move(_firstName)), lastName(std::move(_lastName)), studentID(std::move(_studentID)) {
+		updateFullName();
 	}
 
 	// Default constructor
@@ -28,49 +40,52 @@ public:
 		firstName = "";
 		lastName = "";
 		studentID = "";
+		updateFullName();
 	}
 
 	void setFirstName(std::string _firstName) {
-		firstName = _firstName;
+		firstName = std::move(_firstName);
+		updateFullName();
 	}
-	void setLastName(std::string _firstName) {
-		firstName = _firstName;
+	void setLastName(std::string _lastName) {
+		lastName = std::move(_lastName);
+		updateFullName();
 	}
 	void setStudentID(std::string _studentID) {
-		studentID = _studentID;
+		studentID = std::move(_studentID);
 	}
-	std::string getFirstName() {
+	const std::string& getFirstName() const {
 		return firstName;
 	}
-	std::string getLastName() {
+	const std::string& getLastName() const {
 		return lastName;
 	}
-	std::string getName() {
-		return firstName + " " + lastName;
+	const std::string& getName() const {
+		return fullName;
 	}
-	std::string getStudentID() {
+	const std::string& getStudentID() const {
 		return studentID;
 	}
-	// Overloading the comparison operators so it lexicographically compares the titles of the Book objects
-	bool operator>(Student& other) {
-		return getName() > other.getName();
+	// Overloading the comparison operators so it lexicographically compares the names of the Student objects
+	bool operator>(const Student& other) const {
+		return fullName > other.fullName;
 	}
-	bool operator>=(Student& other) {
-		return getName() >= other.getName();
+	bool operator>=(const Student& other) const {
+		return fullName >= other.fullName;
 	}
-	bool operator<(Student& other) {
-		return getName() < other.getName();
+	bool operator<(const Student& other) const {
+		return fullName < other.fullName;
 	}
-	bool operator<=(Student& other) {
-		return getName() <= other.getName();
+	bool operator<=(const Student& other) const {
+		return fullName <= other.fullName;
 	}
 	// Overloading equality operator to check whether two objects 
-	bool operator==(Student& other) {
+	bool operator==(const Student& other) const {
 		return studentID == other.studentID;
 	}
 };
 
-std::ostream& operator<<(std::ostream& os, Student student) {
+std::ostream& operator<<(std::ostream& os, const Student& student) {
 	os << "("
 		<< student.getName()
 		<< " - ID#: "
@@ -0,0 +1,356 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "LatencyHistogram.h"
+
+/*
++ Work-stealing thread pool for the library's background jobs (exports, catalog images, sorted reports), so that the
+thread serving the desk only ever pays for handing a job off. Each worker has its own deque per priority: a job that a
+running job submits goes on the back of its worker's deque and is taken from the back again (it's likely still in
+that core's cache), while jobs from outside the pool go into a shared queue per priority that workers take from in
+order. A worker with nothing of its own takes from the shared queue, and after that steals the oldest job off another
+worker's deque, so no core sits idle while another has a backlog. Higher priority jobs always go first.
+
++ Every job records how long it waited in the queue and how long it ran. The handle has the job's own times, and the
+scheduler keeps a histogram of queue times for each priority, which is the number to watch: if low priority jobs wait
+too long, the pool needs more threads.
+
++ NOTE: On Linux the workers run under SCHED_BATCH, so the kernel favours the foreground thread whenever they compete
+for a core. The scheduler only runs the jobs; a job that touches a BookLibrary has to work on something the library
+won't change underneath it, like a LibrarySnapshot. A job shouldn't wait on another job's handle: if every worker is
+waiting, the jobs they wait for never get a thread.
+*/
+
+enum TaskPriority { PRIORITY_HIGH, PRIORITY_NORMAL, PRIORITY_LOW, NUM_TASK_PRIORITIES };
+
+enum TaskStatus { TASK_QUEUED, TASK_RUNNING, TASK_FINISHED, TASK_CANCELLED };
+
+// What the scheduler and a job's handle share about the job
+struct TaskState {
+	std::atomic<int> status{TASK_QUEUED};
+	TaskPriority priority = PRIORITY_NORMAL;
+	std::function<void()> run; // dropped without running if the job is cancelled
+	// Each is written before status moves past it, so they can be read once status says they're set
+	std::chrono::steady_clock::time_point queuedAt;
+	std::chrono::steady_clock::time_point startedAt;
+	std::chrono::steady_clock::time_point finishedAt;
+
+	// Claims the job to run it; fails if it was cancelled first
+	bool start() {
+		startedAt = std::chrono::steady_clock::now();
+		int expected = TASK_QUEUED;
+		return status.compare_exchange_strong(expected, TASK_RUNNING, std::memory_order_acq_rel);
+	}
+
+	void runAndFinish() {
+		run();
+		run = nullptr;
+		finishedAt = std::chrono::steady_clock::now();
+		status.store(TASK_FINISHED, std::memory_order_release);
+	}
+};
+
+// Handle to a submitted job: its result, its status, its queue and run times, and a way to cancel it
+template <class Result>
+class TaskHandle {
+private:
+	std::shared_ptr<TaskState> state;
+	std::shared_future<Result> result;
+
+public:
+	TaskHandle() {}
+	TaskHandle(std::shared_ptr<TaskState> _state, std::shared_future<Result> _result) : state(_state), result(_result) {}
+
+	// Cancels the job if it hasn't started yet; returns whether it did. A job that's already running runs to the end.
+	// NOTE: get() on a cancelled job throws std::future_error (broken_promise), since it never made a result
+	bool cancel() {
+		int expected = TASK_QUEUED;
+		if (!state->status.compare_exchange_strong(expected, TASK_CANCELLED, std::memory_order_acq_rel)) {
+			return false;
+		}
+		// Nothing runs the job now, so dropping it here makes the result ready (as broken) straight away
+		state->run = nullptr;
+		return true;
+	}
+
+	TaskStatus getStatus() const {
+		return static_cast<TaskStatus>(state->status.load(std::memory_order_acquire));
+	}
+
+	bool isDone() const {
+		TaskStatus status = getStatus();
+		return status == TASK_FINISHED || status == TASK_CANCELLED;
+	}
+
+	// Waits until the job has finished or been cancelled
+	void wait() const {
+		result.wait();
+	}
+
+	// Waits for the job and returns its result
+	decltype(auto) get() const {
+		return result.get();
+	}
+
+	// Nanoseconds the job waited before a worker started it, or -1 if it hasn't started
+	long long getQueueNanoseconds() const {
+		TaskStatus status = getStatus();
+		if (status != TASK_RUNNING && status != TASK_FINISHED) {
+			return -1;
+		}
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(state->startedAt - state->queuedAt).count();
+	}
+
+	// Nanoseconds the job ran for, or -1 if it hasn't finished
+	long long getRunNanoseconds() const {
+		if (getStatus() != TASK_FINISHED) {
+			return -1;
+		}
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(state->finishedAt - state->startedAt).count();
+	}
+
+	TaskPriority getPriority() const {
+		return state->priority;
+	}
+};
+
+// Wraps a function as a job that hasn't been queued yet, along with the handle to give back for it
+template <class Function>
+auto makeTask(Function function, TaskPriority priority, std::shared_ptr<TaskState>& state) -> TaskHandle<decltype(function())> {
+	typedef decltype(function()) Result;
+	std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+	state = std::make_shared<TaskState>();
+	state->priority = priority;
+	state->run = [task]() { (*task)(); };
+	return TaskHandle<Result>(state, task->get_future().share());
+}
+
+// How the jobs of one priority have fared
+struct TaskPriorityStats {
+	long long submitted = 0;
+	long long finished = 0;
+	long long cancelled = 0;
+	LatencyHistogram queueNanoseconds;
+};
+
+class TaskScheduler {
+private:
+	typedef std::shared_ptr<TaskState> Task;
+
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks[NUM_TASK_PRIORITIES];
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> workerQueues;
+	std::vector<std::thread> workers;
+	std::mutex sharedMutex; // protects sharedTasks
+	std::deque<Task> sharedTasks[NUM_TASK_PRIORITIES]; // jobs submitted from outside the pool
+	std::mutex sleepMutex; // held while changing pendingTasks or stopping, so a worker can't miss a wakeup
+	std::condition_variable taskAvailable;
+	std::atomic<long long> pendingTasks{0}; // jobs in any queue, including cancelled ones nobody's taken out yet
+	bool stopping = false;
+	std::atomic<long long> numSteals{0};
+	std::mutex statsMutex;
+	TaskPriorityStats stats[NUM_TASK_PRIORITIES];
+
+	// The scheduler and worker number of the thread we're on, when it's one of a scheduler's workers
+	static TaskScheduler*& currentScheduler() {
+		static thread_local TaskScheduler* scheduler = nullptr;
+		return scheduler;
+	}
+	static int& currentWorker() {
+		static thread_local int worker = -1;
+		return worker;
+	}
+
+	static bool takeFront(std::deque<Task>& tasks, Task& task) {
+		if (tasks.empty()) {
+			return false;
+		}
+		task = std::move(tasks.front());
+		tasks.pop_front();
+		return true;
+	}
+
+	// Finds the next job for a worker: its own newest, then the oldest shared one, then the oldest one it can steal,
+	// trying every priority in that order before moving on to the next priority
+	bool findTask(int self, Task& task) {
+		int numWorkers = static_cast<int>(workerQueues.size());
+		for (int priority = 0; priority < NUM_TASK_PRIORITIES; priority++) {
+			{
+				WorkerQueue& own = *workerQueues[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.tasks[priority].empty()) {
+					task = std::move(own.tasks[priority].back());
+					own.tasks[priority].pop_back();
+					return true;
+				}
+			}
+			{
+				std::lock_guard<std::mutex> lock(sharedMutex);
+				if (takeFront(sharedTasks[priority], task)) {
+					return true;
+				}
+			}
+			for (int i = 1; i < numWorkers; i++) {
+				WorkerQueue& victim = *workerQueues[(self + i) % numWorkers];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (takeFront(victim.tasks[priority], task)) {
+					numSteals.fetch_add(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void runTask(Task& task) {
+		bool started = task->start();
+		if (started) {
+			task->runAndFinish();
+		}
+		std::lock_guard<std::mutex> lock(statsMutex);
+		TaskPriorityStats& priorityStats = stats[task->priority];
+		if (!started) {
+			priorityStats.cancelled += 1;
+			return;
+		}
+		priorityStats.finished += 1;
+		priorityStats.queueNanoseconds.recordValue(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(task->startedAt - task->queuedAt).count()));
+	}
+
+	// Runs jobs until the scheduler is shut down and every queue is empty
+	void workerLoop(int self) {
+		currentScheduler() = this;
+		currentWorker() = self;
+		while (true) {
+			Task task;
+			if (findTask(self, task)) {
+				pendingTasks.fetch_sub(1, std::memory_order_relaxed);
+				runTask(task);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			taskAvailable.wait(lock, [this] { return stopping || pendingTasks.load(std::memory_order_relaxed) > 0; });
+			if (stopping && pendingTasks.load(std::memory_order_relaxed) == 0) {
+				return;
+			}
+		}
+	}
+
+	void enqueue(Task task) {
+		task->queuedAt = std::chrono::steady_clock::now();
+		TaskPriority priority = task->priority;
+		if (currentScheduler() == this) {
+			WorkerQueue& own = *workerQueues[currentWorker()];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			own.tasks[priority].push_back(std::move(task));
+		} else {
+			std::lock_guard<std::mutex> lock(sharedMutex);
+			sharedTasks[priority].push_back(std::move(task));
+		}
+		{
+			std::lock_guard<std::mutex> lock(statsMutex);
+			stats[priority].submitted += 1;
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			pendingTasks.fetch_add(1, std::memory_order_relaxed);
+		}
+		taskAvailable.notify_one();
+	}
+
+public:
+	// Starts the workers; by default one for every core but one, which is left for the foreground thread
+	explicit TaskScheduler(int numThreads = 0) {
+		if (numThreads <= 0) {
+			numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		}
+		for (int i = 0; i < numThreads; i++) {
+			workerQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+		}
+		for (int i = 0; i < numThreads; i++) {
+			workers.push_back(std::thread(&TaskScheduler::workerLoop, this, i));
+#ifdef __linux__
+			sched_param parameters = {};
+			pthread_setschedparam(workers.back().native_handle(), SCHED_BATCH, &parameters);
+#endif
+		}
+	}
+
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	// Finishes the jobs that were already submitted (skipping cancelled ones), then stops the workers
+	~TaskScheduler() {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+		for (size_t i = 0; i < workers.size(); i++) {
+			workers[i].join();
+		}
+	}
+
+	// Queues function() to run on a worker, and returns a handle for its result
+	template <class Function>
+	auto submit(Function function, TaskPriority priority = PRIORITY_NORMAL) -> TaskHandle<decltype(function())> {
+		std::shared_ptr<TaskState> state;
+		auto handle = makeTask(std::move(function), priority, state);
+		enqueue(state);
+		return handle;
+	}
+
+	int getNumThreads() {
+		return static_cast<int>(workers.size());
+	}
+
+	// Jobs that are waiting to start (cancelled ones count until a worker takes them out)
+	long long getNumPending() {
+		return pendingTasks.load(std::memory_order_relaxed);
+	}
+
+	// How many jobs a worker took off another worker's deque
+	long long getNumSteals() {
+		return numSteals.load(std::memory_order_relaxed);
+	}
+
+	TaskPriorityStats getStats(TaskPriority priority) {
+		std::lock_guard<std::mutex> lock(statsMutex);
+		return stats[priority];
+	}
+};
+
+// Runs function() on the scheduler, or straight away on this thread when there isn't one; either way the caller gets
+// the same kind of handle back
+template <class Function>
+auto runInBackground(TaskScheduler* scheduler, Function function, TaskPriority priority = PRIORITY_NORMAL) -> TaskHandle<decltype(function())> {
+	if (scheduler != nullptr) {
+		return scheduler->submit(std::move(function), priority);
+	}
+	std::shared_ptr<TaskState> state;
+	auto handle = makeTask(std::move(function), priority, state);
+	state->queuedAt = std::chrono::steady_clock::now();
+	state->start();
+	state->runAndFinish();
+	return handle;
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+#include <vector>
+#include <cstdint>
+#include "BitOps.h"
+
+/*
++ Hierarchical timing wheel: keeps track of when each of a set of IDs (like loans) expires, and finds the ones that
+have expired as time moves forward without looking at the ones that haven't. Time is counted in whole ticks.
+
++ There are four levels of 64 slots each. Level 0 has one slot per tick for the next 64 ticks, level 1 one slot per 64
+ticks for the next 64 * 64, and so on, so the wheel covers 64^4 ticks (about 31 years of one minute ticks). Each slot
+is a doubly linked list of IDs, so scheduling or cancelling an ID is O(1). When the wheel reaches the start of a slot at
+a higher level, that slot's IDs are moved down (cascaded) to the level that now fits them; each ID moves down at most
+once per level, so finding expired IDs is amortized O(1) per ID. A bitmap of the level 0 slots that have anything in
+them lets advance() jump straight to the next slot to expire instead of stepping through empty ticks.
+
++ NOTE: Expired IDs aren't forgotten; they move to an expired list until they're cancelled or scheduled again, so the
+owner can go through just the expired ones (e.g. for an overdue report).
+*/
+class TimingWheel {
+private:
+	static const int numLevels = 4;
+	static const int slotBits = 6;
+	static const int numSlots = 1 << slotBits;
+	static const int expiredList = numLevels * numSlots; // list index of the expired list, after every slot's list
+	static constexpr long long maxSpan = 1LL << (slotBits * numLevels); // ticks ahead the wheel can hold an ID
+
+	enum EntryState : unsigned char { UNSCHEDULED, SCHEDULED, EXPIRED };
+	struct Entry {
+		long long expiryTick = 0;
+		int prev = -1;
+		int next = -1;
+		int list = -1; // slot (level * numSlots + slot) or expiredList that the ID is in
+		EntryState state = UNSCHEDULED;
+	};
+
+	std::vector<Entry> entries; // by ID
+	std::vector<int> heads; // first ID in each slot's list and then in the expired list, or -1 if it's empty
+	uint64_t occupied = 0; // bit s is set when level 0 slot s has IDs in it
+	long long currentTick = 0;
+	int numScheduled = 0; // IDs in the slots (not counting the expired ones)
+	int numExpired = 0;
+
+	void pushFront(int list, int id) {
+		Entry& entry = entries[id];
+		entry.list = list;
+		entry.prev = -1;
+		entry.next = heads[list];
+		if (heads[list] >= 0) {
+			entries[heads[list]].prev = id;
+		}
+		heads[list] = id;
+		if (list < numSlots) {
+			occupied |= uint64_t(1) << list;
+		}
+	}
+
+	void unlink(int id) {
+		Entry& entry = entries[id];
+		if (entry.prev >= 0) {
+			entries[entry.prev].next = entry.next;
+		} else {
+			heads[entry.list] = entry.next;
+		}
+		if (entry.next >= 0) {
+			entries[entry.next].prev = entry.prev;
+		}
+		if (entry.list < numSlots && heads[entry.list] < 0) {
+			occupied &= ~(uint64_t(1) << entry.list);
+		}
+		entry.list = -1;
+	}
+
+	// Puts a scheduled ID in the slot that fits how far away its expiry is; it has to be at or after the current tick
+	void place(int id) {
+		long long expiryTick = entries[id].expiryTick;
+		long long delta = expiryTick - currentTick;
+		if (delta >= maxSpan) {
+			// Too far ahead for the wheel; park it in the farthest slot, and it gets placed again when that's cascaded
+			expiryTick = currentTick + maxSpan - 1;
+			delta = maxSpan - 1;
+		}
+		int level = 0;
+		while (delta >= (1LL << (slotBits * (level + 1)))) {
+			level += 1;
+		}
+		int slot = static_cast<int>((expiryTick >> (slotBits * level)) & (numSlots - 1));
+		pushFront(level * numSlots + slot, id);
+	}
+
+	// Moves the IDs in a slot down to the levels that fit them now
+	void cascade(int level, int slot) {
+		int list = level * numSlots + slot;
+		int id = heads[list];
+		heads[list] = -1;
+		while (id >= 0) {
+			int next = entries[id].next;
+			place(id);
+			id = next;
+		}
+	}
+
+	void expire(int id) {
+		unlink(id);
+		entries[id].state = EXPIRED;
+		pushFront(expiredList, id);
+		numScheduled -= 1;
+		numExpired += 1;
+	}
+
+public:
+	TimingWheel() {
+		heads.assign(expiredList + 1, -1);
+	}
+
+	// Forgets every ID, and starts counting from the given tick
+	void clear(long long startTick = 0) {
+		entries.clear();
+		heads.assign(expiredList + 1, -1);
+		occupied = 0;
+		currentTick = startTick;
+		numScheduled = 0;
+		numExpired = 0;
+	}
+
+	// Schedules an ID to expire at expiryTick, replacing any time it had; an ID whose tick has already passed (or is the
+	// current one) goes straight to the expired list
+	void schedule(int id, long long expiryTick) {
+		if (id >= static_cast<int>(entries.size())) {
+			entries.resize(id + 1);
+		}
+		cancel(id);
+		Entry& entry = entries[id];
+		entry.expiryTick = expiryTick;
+		if (expiryTick <= currentTick) {
+			entry.state = EXPIRED;
+			pushFront(expiredList, id);
+			numExpired += 1;
+			return;
+		}
+		entry.state = SCHEDULED;
+		numScheduled += 1;
+		place(id);
+	}
+
+	// Removes an ID from the wheel, whether it's expired or not
+	void cancel(int id) {
+		if (id < 0 || id >= static_cast<int>(entries.size()) || entries[id].state == UNSCHEDULED) {
+			return;
+		}
+		if (entries[id].state == EXPIRED) {
+			numExpired -= 1;
+		} else {
+			numScheduled -= 1;
+		}
+		unlink(id);
+		entries[id].state = UNSCHEDULED;
+	}
+
+	// Moves the wheel forward to nowTick, moving every ID that expires on the way to the expired list and calling
+	// onExpire(id) for it. Going backwards does nothing.
+	template <class Callback>
+	void advance(long long nowTick, Callback onExpire) {
+		while (currentTick < nowTick) {
+			if (numScheduled == 0) {
+				currentTick = nowTick;
+				break;
+			}
+			// Next tick with work to do: the next used level 0 slot before the end of this block of 64 ticks, or the
+			// start of the next block, where the higher levels get cascaded
+			long long target = (currentTick | (numSlots - 1)) + 1;
+			int nextSlot = static_cast<int>(currentTick & (numSlots - 1)) + 1;
+			if (nextSlot < numSlots) {
+				uint64_t later = occupied & (~uint64_t(0) << nextSlot);
+				if (later != 0) {
+					target = (currentTick & ~static_cast<long long>(numSlots - 1)) + countTrailingZeros(later);
+				}
+			}
+			if (target > nowTick) {
+				currentTick = nowTick;
+				break;
+			}
+			currentTick = target;
+			if ((currentTick & (numSlots - 1)) == 0) {
+				// Cascade from the highest level whose slot starts now, so IDs can fall through several levels
+				int topLevel = 1;
+				while (topLevel < numLevels - 1 && ((currentTick >> (slotBits * topLevel)) & (numSlots - 1)) == 0) {
+					topLevel += 1;
+				}
+				for (int level = topLevel; level >= 1; level--) {
+					cascade(level, static_cast<int>((currentTick >> (slotBits * level)) & (numSlots - 1)));
+				}
+			}
+			int slot = static_cast<int>(currentTick & (numSlots - 1));
+			while (heads[slot] >= 0) {
+				int id = heads[slot];
+				expire(id);
+				onExpire(id);
+			}
+		}
+	}
+
+	// Calls visit(id, expiryTick) for every scheduled ID that expires after the current tick and by lastTick. Only the
+	// slots that cover those ticks are looked at, so IDs that expire much later mostly aren't.
+	template <class Visitor>
+	void forEachExpiringBy(long long lastTick, Visitor visit) {
+		if (lastTick > currentTick + maxSpan) {
+			lastTick = currentTick + maxSpan;
+		}
+		for (int level = 0; level < numLevels; level++) {
+			int shift = slotBits * level;
+			long long firstBlock = currentTick >> shift;
+			long long lastBlock = lastTick >> shift;
+			long long numBlocks = lastBlock - firstBlock + 1;
+			if (numBlocks > numSlots) {
+				numBlocks = numSlots;
+			}
+			for (long long block = firstBlock; block < firstBlock + numBlocks; block++) {
+				int id = heads[level * numSlots + static_cast<int>(block & (numSlots - 1))];
+				while (id >= 0) {
+					const Entry& entry = entries[id];
+					if (entry.expiryTick > currentTick && entry.expiryTick <= lastTick) {
+						visit(id, entry.expiryTick);
+					}
+					id = entry.next;
+				}
+			}
+		}
+	}
+
+	// Calls visit(id) for every expired ID, most recently expired first
+	template <class Visitor>
+	void forEachExpired(Visitor visit) {
+		for (int id = heads[expiredList]; id >= 0; id = entries[id].next) {
+			visit(id);
+		}
+	}
+
+	bool isExpired(int id) {
+		return id >= 0 && id < static_cast<int>(entries.size()) && entries[id].state == EXPIRED;
+	}
+
+	long long getCurrentTick() {
+		return currentTick;
+	}
+
+	int getNumScheduled() {
+		return numScheduled;
+	}
+
+	int getNumExpired() {
+		return numExpired;
+	}
+};
+
+#endif
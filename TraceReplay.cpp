@@ -0,0 +1,318 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "BookLibrary.h"
+#include "dataLoader.h"
+#include "LatencyHistogram.h"
+#include "OperationTrace.h"
+#include "utilities.h"
+
+/*
++ Runs a binary operation trace (recorded with BookLibrary::startTrace, e.g. by the console program's --trace option or
+LoadDriver's --record) again against a fresh library loaded from the same data files. Operations run back to back, as
+fast as the library can go, and the library's clock is set to the time each one was recorded at, so due dates and
+overdue loans come out the same as they did when it was recorded. Each operation's result is checked against the
+recorded one, and any that differ are counted as diverged (which means the library isn't in the state it was).
+
++ Reports latency percentiles for each kind of operation, next to the ones recorded in the trace. Save a run with
+--json, and run a different build with --baseline pointing at it to see how each operation's p50 and p99 changed;
+the program exits with 1 if any of them got slower by more than the threshold.
+
++ Usage:
+	TraceReplay --trace <file> [--books bookData.txt] [--students studentData.txt] [--repeat N] [--json <outputFile>]
+	            [--baseline <earlierJSON>] [--threshold <ratio>]
+
+	--repeat     Replay the trace N times, each time against a freshly loaded library, and keep the fastest time for
+	             each operation (default 1)
+	--threshold  How much slower an operation can get before it counts as a regression (default 0.10, which is 10%)
+*/
+
+// Right aligns text in a column of the given width
+std::string padLeft(std::string text, size_t width) {
+	if (text.length() >= width) {
+		return text;
+	}
+	return std::string(width - text.length(), ' ') + text;
+}
+
+// An operation's percentiles from an earlier run's JSON
+struct BaselineLatency {
+	std::string name;
+	double p50 = 0;
+	double p99 = 0;
+};
+
+// Reads the per-operation latencies from the JSON an earlier run wrote; lines that aren't an operation are skipped
+std::vector<BaselineLatency> readBaseline(const std::string& fileName) {
+	std::vector<BaselineLatency> baseline;
+	std::ifstream baselineFile(fileName);
+	std::string currentLine;
+	const std::string p50Field = "\"p50\": ";
+	const std::string p99Field = "\"p99\": ";
+	while (std::getline(baselineFile, currentLine)) {
+		size_t nameStart = currentLine.find('"');
+		size_t p50Pos = currentLine.find(p50Field);
+		size_t p99Pos = currentLine.find(p99Field);
+		if (nameStart == std::string::npos || p50Pos == std::string::npos || p99Pos == std::string::npos) {
+			continue;
+		}
+		BaselineLatency latency;
+		latency.name = currentLine.substr(nameStart + 1, currentLine.find('"', nameStart + 1) - nameStart - 1);
+		latency.p50 = std::atof(currentLine.c_str() + p50Pos + p50Field.length());
+		latency.p99 = std::atof(currentLine.c_str() + p99Pos + p99Field.length());
+		baseline.push_back(latency);
+	}
+	return baseline;
+}
+
+// Runs one recorded operation against the library; returns whether it succeeded, and how long the library call took
+bool replayOperation(BookLibrary& library, const TraceRecord& record, uint64_t& nanoseconds) {
+	const std::vector<std::string>& arguments = record.arguments;
+	// The book and student are looked up before the clock starts, as the desk would have had them already
+	Book book;
+	Student student;
+	bool wasIssued = false;
+	if (traceArgumentCounts[record.op] == 4 && record.op != TRACE_EDIT_BOOK) {
+		book = library.getBook(arguments[0]);
+		student = Student(arguments[1], arguments[2], arguments[3]);
+		wasIssued = library.isIssuedTo(book, student);
+	}
+	// The batch operations have the student first and then the items
+	std::vector<std::string> items;
+	if (traceArgumentCounts[record.op] < 0 && arguments.size() >= 3) {
+		student = Student(arguments[0], arguments[1], arguments[2]);
+		items.assign(arguments.begin() + 3, arguments.end());
+	}
+	bool succeeded = false;
+	auto start = std::chrono::steady_clock::now();
+	switch (record.op) {
+		case TRACE_GET_BOOK:
+			succeeded = library.getBook(arguments[0]).ISBN != "";
+			break;
+		case TRACE_GET_BOOK_BY_ISBN:
+			succeeded = library.getBookByISBN(arguments[0]).ISBN != "";
+			break;
+		case TRACE_ADD_BOOK: {
+			int numBooks = library.getNumBooks();
+			library.addBook(arguments[0], arguments[1], arguments[2], static_cast<int>(record.number));
+			succeeded = library.getNumBooks() > numBooks;
+			break;
+		}
+		case TRACE_DELETE_BOOK: {
+			int numBooks = library.getNumBooks();
+			library.deleteBook(arguments[0]);
+			succeeded = library.getNumBooks() < numBooks;
+			break;
+		}
+		case TRACE_ISSUE_BOOK: {
+			int numIssued = library.getNumIssuedBooks();
+			library.issueBook(book, student);
+			succeeded = library.getNumIssuedBooks() > numIssued;
+			break;
+		}
+		case TRACE_RETURN_BOOK:
+			// A return can hand the book straight to the next student waiting for it, so the number of loans doesn't
+			// say whether it worked; it does whenever the book was issued to the student
+			library.returnBook(book, student);
+			succeeded = wasIssued;
+			break;
+		case TRACE_RENEW_LOAN:
+			succeeded = library.renewLoan(book, student);
+			break;
+		case TRACE_PLACE_HOLD:
+			succeeded = library.placeHold(book, student, static_cast<int>(record.number));
+			break;
+		case TRACE_CANCEL_HOLD:
+			succeeded = library.cancelHold(book, student);
+			break;
+		case TRACE_ADD_STUDENT: {
+			int numStudents = library.getNumStudents();
+			library.addStudent(arguments[0], arguments[1], arguments[2]);
+			succeeded = library.getNumStudents() > numStudents;
+			break;
+		}
+		case TRACE_DELETE_STUDENT: {
+			int numStudents = library.getNumStudents();
+			library.deleteStudent(arguments[0]);
+			succeeded = library.getNumStudents() < numStudents;
+			break;
+		}
+		case TRACE_FIND_STUDENT:
+			succeeded = library.isExistingStudent(arguments[0]);
+			break;
+		case TRACE_ISSUE_BOOKS:
+			succeeded = library.issueBooks(student, items).applied;
+			break;
+		case TRACE_RETURN_BOOKS:
+			succeeded = library.returnBooks(student, items).applied;
+			break;
+		case TRACE_EDIT_BOOK:
+			succeeded = library.editBook(arguments[0], arguments[1], arguments[2], arguments[3], static_cast<int>(record.number));
+			break;
+		default:
+			break;
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	return succeeded;
+}
+
+int main(int argc, char* argv[]) {
+	std::string bookFileName = "bookData.txt";
+	std::string studentFileName = "studentData.txt";
+	std::string traceFileName;
+	std::string jsonFileName;
+	std::string baselineFileName;
+	double threshold = 0.10;
+	int repeat = 1;
+	const std::string usage = " --trace file [--books file] [--students file] [--repeat N] [--json outputFile] [--baseline file] [--threshold ratio]";
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		if (arg == "--trace") {
+			traceFileName = argv[i + 1];
+		} else if (arg == "--books") {
+			bookFileName = argv[i + 1];
+		} else if (arg == "--students") {
+			studentFileName = argv[i + 1];
+		} else if (arg == "--repeat") {
+			repeat = std::max(1, std::atoi(argv[i + 1]));
+		} else if (arg == "--json") {
+			jsonFileName = argv[i + 1];
+		} else if (arg == "--baseline") {
+			baselineFileName = argv[i + 1];
+		} else if (arg == "--threshold") {
+			threshold = std::atof(argv[i + 1]);
+		} else {
+			std::cerr << "Usage: " << argv[0] << usage << std::endl;
+			return 2;
+		}
+	}
+	if (traceFileName.empty() || argc % 2 == 0) {
+		std::cerr << "Usage: " << argv[0] << usage << std::endl;
+		return 2;
+	}
+
+	// Read the whole trace before replaying it, so reading the file isn't timed
+	OperationTraceReader reader;
+	if (!reader.open(traceFileName)) {
+		std::cerr << "Trace Replay: '" << traceFileName << "' isn't a trace file!" << std::endl;
+		return 2;
+	}
+	std::vector<TraceRecord> records;
+	TraceRecord record;
+	while (reader.next(record)) {
+		records.push_back(record);
+	}
+	if (reader.hasError()) {
+		std::cerr << "Trace Replay: The trace is cut off or damaged after " << records.size() << " operations; replaying those" << std::endl;
+	}
+	if (records.empty()) {
+		std::cerr << "Trace Replay: Trace '" << traceFileName << "' has no operations!" << std::endl;
+		return 2;
+	}
+
+	std::vector<LatencyHistogram> recorded(NUM_TRACE_OPERATIONS);
+	for (size_t i = 0; i < records.size(); i++) {
+		recorded[records[i].op].recordValue(records[i].nanoseconds);
+	}
+	// Fastest time of each operation over the repeats, which takes out most of the noise from the machine
+	std::vector<uint64_t> fastest(records.size(), UINT64_MAX);
+	long long diverged = 0;
+	double replaySeconds = 0;
+	for (int run = 0; run < repeat; run++) {
+		BookLibrary library;
+		library.setVerbose(false);
+		loadBookData(library, bookFileName, ',');
+		loadStudentData(library, studentFileName, ',');
+		long long clockTime = records[0].clockTime;
+		library.setClock([&clockTime]() {
+			return clockTime;
+		});
+		diverged = 0;
+		auto replayStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < records.size(); i++) {
+			clockTime = records[i].clockTime;
+			uint64_t nanoseconds;
+			if (replayOperation(library, records[i], nanoseconds) != records[i].succeeded) {
+				diverged += 1;
+			}
+			if (nanoseconds < fastest[i]) {
+				fastest[i] = nanoseconds;
+			}
+		}
+		replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+	}
+	std::vector<LatencyHistogram> replayed(NUM_TRACE_OPERATIONS);
+	LatencyHistogram allOperations;
+	for (size_t i = 0; i < records.size(); i++) {
+		replayed[records[i].op].recordValue(fastest[i]);
+		allOperations.recordValue(fastest[i]);
+	}
+
+	std::cerr << "Trace Replay: Replayed " << records.size() << " operations in " << replaySeconds << " s ("
+		<< diverged << " diverged from the recorded results)" << std::endl;
+	std::cerr << "Latency (ns)    " << padLeft("count", 10) << " " << padLeft("rec p50", 10) << " " << padLeft("rec p99", 10)
+		<< " " << padLeft("p50", 10) << " " << padLeft("p99", 10) << " " << padLeft("max", 10) << std::endl;
+	for (int op = 0; op < NUM_TRACE_OPERATIONS; op++) {
+		if (replayed[op].getTotalCount() == 0) {
+			continue;
+		}
+		std::string name = traceOperationNames[op];
+		name.resize(16, ' ');
+		std::cerr << name << padLeft(std::to_string(replayed[op].getTotalCount()), 10);
+		uint64_t values[5] = { recorded[op].valueAtPercentile(50), recorded[op].valueAtPercentile(99), replayed[op].valueAtPercentile(50),
+			replayed[op].valueAtPercentile(99), replayed[op].getMax() };
+		for (int j = 0; j < 5; j++) {
+			std::cerr << " " << padLeft(std::to_string(values[j]), 10);
+		}
+		std::cerr << std::endl;
+	}
+
+	std::ofstream jsonFile;
+	if (!jsonFileName.empty()) {
+		jsonFile.open(jsonFileName);
+	}
+	std::ostream& os = jsonFileName.empty() ? std::cout : jsonFile;
+	os << "{\"operations\": " << records.size()
+		<< ", \"diverged\": " << diverged
+		<< ", \"replay_seconds\": " << replaySeconds
+		<< ", \"latency_ns\": {" << std::endl;
+	for (int op = 0; op < NUM_TRACE_OPERATIONS; op++) {
+		if (replayed[op].getTotalCount() > 0) {
+			os << "  \"" << traceOperationNames[op] << "\": {";
+			replayed[op].writeJSONFields(os);
+			os << "}," << std::endl;
+		}
+	}
+	os << "  \"all\": {";
+	allOperations.writeJSONFields(os);
+	os << "}" << std::endl << "}}" << std::endl;
+
+	if (baselineFileName.empty()) {
+		return 0;
+	}
+	std::vector<BaselineLatency> baseline = readBaseline(baselineFileName);
+	int numRegressions = 0;
+	std::cerr << "Comparing against baseline (threshold " << threshold * 100 << "%): " << std::endl;
+	for (int op = 0; op < NUM_TRACE_OPERATIONS; op++) {
+		for (size_t j = 0; j < baseline.size(); j++) {
+			if (baseline[j].name != traceOperationNames[op] || replayed[op].getTotalCount() == 0 || baseline[j].p50 <= 0 || baseline[j].p99 <= 0) {
+				continue;
+			}
+			double p50Change = (replayed[op].valueAtPercentile(50) - baseline[j].p50) / baseline[j].p50;
+			double p99Change = (replayed[op].valueAtPercentile(99) - baseline[j].p99) / baseline[j].p99;
+			bool isRegression = p50Change > threshold || p99Change > threshold;
+			if (isRegression) {
+				numRegressions += 1;
+			}
+			std::cerr << (isRegression ? "REGRESSION " : "ok         ") << baseline[j].name << ": p50 " << baseline[j].p50 << " -> "
+				<< replayed[op].valueAtPercentile(50) << " ns (" << (p50Change >= 0 ? "+" : "") << p50Change * 100 << "%), p99 "
+				<< baseline[j].p99 << " -> " << replayed[op].valueAtPercentile(99) << " ns (" << (p99Change >= 0 ? "+" : "") << p99Change * 100 << "%)" << std::endl;
+			break;
+		}
+	}
+	return numRegressions > 0 ? 1 : 0;
+}
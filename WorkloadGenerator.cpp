@@ -0,0 +1,297 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+/*
++ Generates synthetic data files and an operation trace, so we can run the library at production scale
+without using our real data. It writes:
+	bookData.txt     title,author,ISBN,numPages        (same format the console program loads)
+	studentData.txt  firstName,lastName,studentID      (same format the console program loads)
+	trace.txt        one operation per line, replayed by LoadDriver
+
++ Trace operations, with fields separated by commas:
+	search,<title>               look up a book that exists
+	miss,<title>                 look up a mistyped title that doesn't exist
+	issue,<title>,<studentID>    issue a book to a student
+	return,<title>,<studentID>   return a book that the trace issued earlier
+
++ How popular a title is follows a Zipf distribution (a few titles get most of the traffic, like course textbooks
+during term), and the trace goes through bursts, such as a rush of checkouts at the start of term followed by a
+rush of returns, instead of mixing operations evenly.
+
++ Usage:
+	WorkloadGenerator [--books N] [--students N] [--ops N] [--zipf exponent] [--seed N] [--out directory]
+*/
+
+const std::vector<std::string> adjectives = {
+	"Silent", "Hidden", "Broken", "Golden", "Forgotten", "Crimson", "Distant", "Endless", "Frozen", "Gentle",
+	"Hollow", "Infinite", "Last", "Lost", "Midnight", "Northern", "Pale", "Quiet", "Restless", "Secret",
+	"Shattered", "Sleeping", "Southern", "Stolen", "Strange", "Sunken", "Tangled", "Twisted", "Wandering", "Wild",
+	"Ancient", "Bitter", "Burning", "Clockwork", "Dark", "Electric", "Final", "Glass", "Iron", "Little"
+};
+const std::vector<std::string> nouns = {
+	"Garden", "River", "Kingdom", "Algorithm", "Library", "Theorem", "Empire", "Harbor", "Mountain", "Orchard",
+	"Lighthouse", "Machine", "Mirror", "Ocean", "Symphony", "Cathedral", "Compass", "Engine", "Forest", "Fortress",
+	"Island", "Journey", "Labyrinth", "Letter", "Map", "Memory", "Observatory", "Pattern", "Prophecy", "Republic",
+	"Season", "Shadow", "Signal", "Star", "Storm", "Tower", "Valley", "Voyage", "Winter", "World"
+};
+const std::vector<std::string> places = {
+	"Avalon", "Babylon", "Cordoba", "Dunmore", "Elsinore", "Florence", "Granada", "Hollowmere", "Ithaca", "Jericho",
+	"Kyoto", "Lisbon", "Marrakesh", "Nineveh", "Oxford", "Prague", "Quebec", "Ravenna", "Samarkand", "Thebes",
+	"Utrecht", "Venice", "Winterfell", "Xanadu", "York", "Zanzibar", "the North", "the Sea", "the Stars", "Tomorrow"
+};
+const std::vector<std::string> firstNames = {
+	"Ava", "Ben", "Chloe", "Daniel", "Emma", "Farah", "Gabriel", "Hana", "Isaac", "Jade", "Kevin", "Lena", "Mateo",
+	"Nora", "Omar", "Priya", "Quinn", "Rosa", "Samuel", "Tara", "Uma", "Victor", "Wen", "Ximena", "Yusuf", "Zoe",
+	"Aiden", "Bianca", "Carlos", "Dara", "Elijah", "Fatima", "Grace", "Hugo", "Ines", "Jun", "Kira", "Liam", "Mia", "Noah"
+};
+const std::vector<std::string> lastNames = {
+	"Nguyen", "Smith", "Garcia", "Kim", "Patel", "Johnson", "Chen", "Lopez", "Brown", "Singh", "Tran", "Williams",
+	"Martinez", "Lee", "Davis", "Hernandez", "Wong", "Miller", "Ali", "Wilson", "Anderson", "Thomas", "Moore", "Jackson",
+	"Martin", "Clark", "Lewis", "Walker", "Young", "Allen", "King", "Wright", "Scott", "Torres", "Hill", "Green"
+};
+
+// Builds a unique title for each index by treating the index as a mixed-radix number over the word lists
+std::string makeTitle(long long index) {
+	long long adjectiveIndex = index % adjectives.size();
+	index /= adjectives.size();
+	long long nounIndex = index % nouns.size();
+	index /= nouns.size();
+	long long placeIndex = index % places.size();
+	index /= places.size();
+	std::string title = "The " + adjectives[adjectiveIndex] + " " + nouns[nounIndex] + " of " + places[placeIndex];
+	// After every combination has been used once, further titles become numbered volumes
+	if (index > 0) {
+		title += " Volume " + std::to_string(index + 1);
+	}
+	return title;
+}
+
+// Makes a 13 digit ISBN that starts with 978 and has a valid check digit
+std::string makeISBN(long long index) {
+	std::string digits = "978" + std::to_string(100000000LL + index % 900000000LL);
+	int sum = 0;
+	for (int i = 0; i < 12; i++) {
+		sum += (digits[i] - '0') * (i % 2 == 0 ? 1 : 3);
+	}
+	digits += static_cast<char>('0' + (10 - sum % 10) % 10);
+	return digits;
+}
+
+// Swaps two neighbouring letters, which is a typical typo, so the title is no longer in the catalog
+std::string makeTypo(std::string title, std::mt19937_64& rng) {
+	if (title.length() < 6) {
+		return title + "x";
+	}
+	size_t position = 4 + rng() % (title.length() - 5);
+	if (title[position] == title[position + 1]) {
+		title[position] = 'q';
+	} else {
+		std::swap(title[position], title[position + 1]);
+	}
+	return title;
+}
+
+// Samples ranks 0 to n-1 where rank r is picked with probability proportional to 1 / (r + 1)^exponent
+class ZipfSampler {
+private:
+	std::vector<double> cumulative; // cumulative probability up to and including each rank
+public:
+	ZipfSampler(size_t n, double exponent) {
+		cumulative.resize(n);
+		double total = 0;
+		for (size_t i = 0; i < n; i++) {
+			total += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+			cumulative[i] = total;
+		}
+		for (size_t i = 0; i < n; i++) {
+			cumulative[i] /= total;
+		}
+	}
+
+	size_t sample(std::mt19937_64& rng) {
+		double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+		size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+		return rank < cumulative.size() ? rank : cumulative.size() - 1;
+	}
+};
+
+// Whether an output file was opened (or, after it's closed, written) without an error; prints one if it wasn't
+bool checkOutputFile(const std::ofstream& file, const std::string& fileName) {
+	if (!file) {
+		std::cerr << "Workload Generator: Could not write '" << fileName << "'!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Kinds of bursts the trace moves between, and how likely each operation is during them (search, miss, issue, return)
+struct BurstProfile {
+	std::string name;
+	double weights[4];
+};
+
+const std::vector<BurstProfile> burstProfiles = {
+	{ "browse", { 0.80, 0.10, 0.06, 0.04 } },
+	{ "checkoutRush", { 0.25, 0.03, 0.67, 0.05 } },
+	{ "returnRush", { 0.15, 0.02, 0.08, 0.75 } }
+};
+
+int main(int argc, char* argv[]) {
+	long long numBooks = 1000000;
+	long long numStudents = 100000;
+	long long numOps = 1000000;
+	double zipfExponent = 0.99;
+	unsigned long long seed = 42;
+	std::string outDirectory = ".";
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Usage: " << argv[0] << " [--books N] [--students N] [--ops N] [--zipf exponent] [--seed N] [--out directory]" << std::endl;
+			return 2;
+		}
+		if (arg == "--books") {
+			numBooks = std::atoll(argv[++i]);
+		} else if (arg == "--students") {
+			numStudents = std::atoll(argv[++i]);
+		} else if (arg == "--ops") {
+			numOps = std::atoll(argv[++i]);
+		} else if (arg == "--zipf") {
+			zipfExponent = std::atof(argv[++i]);
+		} else if (arg == "--seed") {
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "--out") {
+			outDirectory = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--books N] [--students N] [--ops N] [--zipf exponent] [--seed N] [--out directory]" << std::endl;
+			return 2;
+		}
+	}
+	if (numBooks < 1 || numStudents < 1) {
+		std::cerr << "Workload Generator: Need at least one book and one student!" << std::endl;
+		return 2;
+	}
+	std::mt19937_64 rng(seed);
+
+	// Books: a small pool of authors writes most of the catalog, like a real library
+	std::string bookFileName = outDirectory + "/bookData.txt";
+	std::ofstream bookFile(bookFileName);
+	if (!checkOutputFile(bookFile, bookFileName)) {
+		return 1;
+	}
+	std::vector<std::string> titles(numBooks);
+	std::lognormal_distribution<double> pageDistribution(5.6, 0.5);
+	long long numAuthors = numBooks / 8 + 1;
+	for (long long i = 0; i < numBooks; i++) {
+		titles[i] = makeTitle(i);
+		long long authorIndex = static_cast<long long>(rng() % numAuthors);
+		std::string author = firstNames[authorIndex % firstNames.size()] + " " + lastNames[(authorIndex / firstNames.size()) % lastNames.size()];
+		if (authorIndex >= static_cast<long long>(firstNames.size() * lastNames.size())) {
+			author += " " + std::to_string(authorIndex / (firstNames.size() * lastNames.size()));
+		}
+		int numPages = static_cast<int>(pageDistribution(rng));
+		numPages = std::max(24, std::min(numPages, 2400));
+		bookFile << titles[i] << "," << author << "," << makeISBN(i) << "," << numPages << "\n";
+	}
+	bookFile.close();
+	if (!checkOutputFile(bookFile, bookFileName)) {
+		return 1;
+	}
+
+	// Students: IDs are 8 digits and unique
+	std::string studentFileName = outDirectory + "/studentData.txt";
+	std::ofstream studentFile(studentFileName);
+	if (!checkOutputFile(studentFile, studentFileName)) {
+		return 1;
+	}
+	std::vector<std::string> studentIDs(numStudents);
+	for (long long i = 0; i < numStudents; i++) {
+		studentIDs[i] = std::to_string(10000000 + i);
+		studentFile << firstNames[rng() % firstNames.size()] << "," << lastNames[rng() % lastNames.size()] << "," << studentIDs[i] << "\n";
+	}
+	studentFile.close();
+	if (!checkOutputFile(studentFile, studentFileName)) {
+		return 1;
+	}
+
+	// Popularity ranks are shuffled onto books, so the popular titles aren't all neighbours in the data file
+	std::vector<long long> bookForRank(numBooks);
+	for (long long i = 0; i < numBooks; i++) {
+		bookForRank[i] = i;
+	}
+	std::shuffle(bookForRank.begin(), bookForRank.end(), rng);
+	ZipfSampler popularity(static_cast<size_t>(numBooks), zipfExponent);
+
+	// Loans the trace has made, so returns always refer to a real loan
+	std::vector<std::pair<long long, long long>> activeLoans; // (book index, student index)
+	std::vector<bool> onLoan(numBooks, false);
+
+	std::string traceFileName = outDirectory + "/trace.txt";
+	std::ofstream traceFile(traceFileName);
+	if (!checkOutputFile(traceFile, traceFileName)) {
+		return 1;
+	}
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	size_t currentProfile = 0;
+	long long burstRemaining = 0;
+	long long opCounts[4] = { 0, 0, 0, 0 };
+	for (long long op = 0; op < numOps; op++) {
+		// Start a new burst once the current one is over
+		if (burstRemaining == 0) {
+			currentProfile = rng() % burstProfiles.size();
+			burstRemaining = 50 + static_cast<long long>(rng() % 5000);
+		}
+		burstRemaining -= 1;
+		const BurstProfile& profile = burstProfiles[currentProfile];
+		double u = unit(rng);
+		int kind = 0;
+		while (kind < 3 && u >= profile.weights[kind]) {
+			u -= profile.weights[kind];
+			kind += 1;
+		}
+		// Can't return anything if nothing is on loan, so browse instead
+		if (kind == 3 && activeLoans.empty()) {
+			kind = 0;
+		}
+		if (kind == 0) {
+			traceFile << "search," << titles[bookForRank[popularity.sample(rng)]] << "\n";
+		} else if (kind == 1) {
+			traceFile << "miss," << makeTypo(titles[bookForRank[popularity.sample(rng)]], rng) << "\n";
+		} else if (kind == 2) {
+			// A few tries to find a copy that's on the shelf; popular books are often already out, and the
+			// library then refuses the checkout, which is also worth measuring
+			long long bookIndex = bookForRank[popularity.sample(rng)];
+			for (int attempt = 0; attempt < 3 && onLoan[bookIndex]; attempt++) {
+				bookIndex = bookForRank[popularity.sample(rng)];
+			}
+			long long studentIndex = static_cast<long long>(rng() % numStudents);
+			traceFile << "issue," << titles[bookIndex] << "," << studentIDs[studentIndex] << "\n";
+			if (!onLoan[bookIndex]) {
+				onLoan[bookIndex] = true;
+				activeLoans.push_back(std::make_pair(bookIndex, studentIndex));
+			}
+		} else {
+			size_t loanIndex = rng() % activeLoans.size();
+			std::pair<long long, long long> loan = activeLoans[loanIndex];
+			activeLoans[loanIndex] = activeLoans.back();
+			activeLoans.pop_back();
+			onLoan[loan.first] = false;
+			traceFile << "return," << titles[loan.first] << "," << studentIDs[loan.second] << "\n";
+		}
+		opCounts[kind] += 1;
+	}
+	traceFile.close();
+	if (!checkOutputFile(traceFile, traceFileName)) {
+		return 1;
+	}
+
+	std::cout << "Workload Generator: Wrote " << numBooks << " books, " << numStudents << " students and " << numOps
+		<< " operations (" << opCounts[0] << " search, " << opCounts[1] << " miss, " << opCounts[2] << " issue, "
+		<< opCounts[3] << " return) to " << outDirectory << std::endl;
+	return 0;
+}
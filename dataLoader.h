@@ -0,0 +1,36 @@
+#ifndef DATALOADER_H
+#define DATALOADER_H
+#include <fstream>
+#include <string>
+#include <vector>
+#include "BookLibrary.h"
+#include "utilities.h"
+
+// Functions for loading the library's data files, which have one record per line and the fields separated
+// by a delimiter. Shared by the console program and the tools that need a library built from the same files.
+
+// Each line is: title, author, ISBN, number of pages
+void loadBookData(BookLibrary& someLibrary, std::string fileName, char delimiter) {
+	std::ifstream bookDataFile;
+	std::string currentLine; 
+	bookDataFile.open(fileName);
+	while (readRecord(bookDataFile, currentLine, delimiter)) {
+		// book attributes put into vector form, we convert bookVector[3] in the data-file it represents an integer, but was converted into a string in the vector
+		// Now we convert it back into a vector
+		std::vector<std::string> bookVector = splitLine(currentLine, delimiter);	
+		someLibrary.addBook(bookVector[0], bookVector[1], bookVector[2], std::stoi(bookVector[3]));
+	}
+}
+
+// Each line is: first name, last name, student ID
+void loadStudentData(BookLibrary& someLibrary, std::string fileName, char delimiter) {
+	std::ifstream studentDataFile;
+	std::string currentLine;
+	studentDataFile.open(fileName);
+	while (readRecord(studentDataFile, currentLine, delimiter)) {
+		std::vector<std::string> studentVector = splitLine(currentLine, delimiter);
+		someLibrary.addStudent(studentVector[0], studentVector[1], studentVector[2]);
+	}
+}
+
+#endif
@@ -2,6 +2,8 @@
 #define linkedList_H
 #include <iostream>
 #include <string>
+#include <vector>
+#include <utility>
 
 // File that contains linked list and nodes specialized for using in hashtables; for collision resolution of chaining.
 
@@ -21,6 +23,9 @@ private:
 	HTNode<T, U>* head;
 	HTNode<T, U>* tail;
 	int count;
+#ifdef BOOKLIBRARY_METRICS
+	int lastSearchLength = 0; // nodes looked at by the most recent searchNode or isExistingNode
+#endif
 public:
 	HTLinkedList() {
 		head = nullptr;
@@ -59,11 +64,12 @@ public:
 
 	NOTE: Before Insertion we should check if the key already exists in the linked list
 	*/
+	// NOTE: key and info are taken by value and moved into the node, so passing temporaries doesn't copy them
 	void insertFirst(T key, U info) {
 		// Create new node and fill in the data
 		HTNode<T, U>* newNode = new HTNode<T, U>();
-		newNode->key = key;
-		newNode->info = info;
+		newNode->key = std::move(key);
+		newNode->info = std::move(info);
 
 		// Empty linked list, so we're actually adding the first node, so redirect both head and tail as the new node
 		if (isEmpty()) {
@@ -79,12 +85,12 @@ public:
 		count += 1;
 	}
 
-	// Inserts new node at tail 
-	void insertLast(T key, U info) {
+	// Inserts new node at tail, and returns it
+	HTNode<T, U>* insertLast(T key, U info) {
 		// Create new node and fill in the data
 		HTNode<T, U>* newNode = new HTNode<T, U>();
-		newNode->key = key;
-		newNode->info = info;
+		newNode->key = std::move(key);
+		newNode->info = std::move(info);
 		newNode->link = nullptr;
 
 		// If the list is initialily empty, put both head and tail as the new node
@@ -99,12 +105,19 @@ public:
 			tail = newNode;
 		}
 		count += 1;
+		return newNode;
 	}
 
 	// Search linked list and returns a node with matching key; if it's not found it'll return a nullptr
-	HTNode<T, U>* searchNode(T key) {
+	HTNode<T, U>* searchNode(const T& key) {
 		HTNode<T, U>* current = head;
+#ifdef BOOKLIBRARY_METRICS
+		lastSearchLength = 0;
+#endif
 		while (current != nullptr) {
+#ifdef BOOKLIBRARY_METRICS
+			lastSearchLength += 1;
+#endif
 			// If the keys match, it's the node we're looking for
 			if (current->key == key) {
 				break;
@@ -122,7 +135,7 @@ public:
 	3. If we are deleting the head. And if deleting the head lead to an empty list.
 	4. If We are deleting a node that isn't the head.
 	*/
-	void deleteNode(T key) {
+	void deleteNode(const T& key) {
 		HTNode<T, U>* previous = nullptr; // node after the current node in linked list
 		HTNode<T, U>* current = head; // represents current node in linked list,
 
@@ -171,10 +184,16 @@ public:
 	}
 
 	// Check if a node, which is a key-value pair, exists already in the linked list given the key
-	bool isExistingNode(T key) {
+	bool isExistingNode(const T& key) {
 		HTNode<T, U>* current = head;
 		bool found = false;
+#ifdef BOOKLIBRARY_METRICS
+		lastSearchLength = 0;
+#endif
 		while (current != nullptr) {
+#ifdef BOOKLIBRARY_METRICS
+			lastSearchLength += 1;
+#endif
 			if (current->key == key) {
 				found = true;
 				break;
@@ -195,6 +214,26 @@ public:
 		return nodeValues;
 	}
 
+	// Calls visit(value) on every node's value, in order, without copying anything
+	template <class Visitor>
+	void forEachNode(Visitor visit) {
+		HTNode<T, U>* current = head;
+		while (current != nullptr) {
+			visit(current->info);
+			current = current->link;
+		}
+	}
+
+	// Calls visit(key, info) on every node, from head to tail
+	template <class Visitor>
+	void forEachPair(Visitor visit) {
+		HTNode<T, U>* current = head;
+		while (current != nullptr) {
+			visit(current->key, current->info);
+			current = current->link;
+		}
+	}
+
 	// Function prints the linked list
 	// NOTE: Assumes current->info has its output stream overloaded with a custom print fucntion
 	void print() {
@@ -216,6 +255,68 @@ public:
 		return count;
 	}
 
+#ifdef BOOKLIBRARY_METRICS
+	// Number of nodes the most recent search looked at, including the matching node
+	int getLastSearchLength() {
+		return lastSearchLength;
+	}
+#endif
+
+	// Unlinks the head node and hands it to the caller without deleting it; returns a nullptr if the list is empty.
+	// Used with attachLast() to move nodes between lists (like when the hash table grows) without copying them,
+	// so a node and the value inside it stay at the same address.
+	HTNode<T, U>* detachHead() {
+		if (isEmpty()) {
+			return nullptr;
+		}
+		HTNode<T, U>* node = head;
+		head = head->link;
+		if (head == nullptr) {
+			tail = nullptr;
+		}
+		node->link = nullptr;
+		count -= 1;
+		return node;
+	}
+
+	// Unlinks the node with the given key and hands it to the caller without deleting it, like detachHead(); returns a
+	// nullptr if there isn't one
+	HTNode<T, U>* detachNode(const T& key) {
+		HTNode<T, U>* previous = nullptr;
+		HTNode<T, U>* current = head;
+		while (current != nullptr && !(current->key == key)) {
+			previous = current;
+			current = current->link;
+		}
+		if (current == nullptr) {
+			return nullptr;
+		}
+		if (previous == nullptr) {
+			head = current->link;
+		} else {
+			previous->link = current->link;
+		}
+		if (current == tail) {
+			tail = previous;
+		}
+		current->link = nullptr;
+		count -= 1;
+		return current;
+	}
+
+	// Links an existing node, such as one from detachHead(), onto the tail of the list
+	void attachLast(HTNode<T, U>* node) {
+		node->link = nullptr;
+		if (isEmpty()) {
+			head = node;
+			tail = node;
+		} else {
+			tail->link = node;
+			tail = node;
+		}
+		count += 1;
+	}
+
 	// NOTE: These, and any other functions that return an HTNode will also return a nullptr if the node in 
 	// question doesn't exist.
 
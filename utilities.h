@@ -3,17 +3,125 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <ctime>
 // Returns a lower cased version of the string
-std::string lowerCaseString(std::string inputStr) {
-	std::string newStr;
-	for (int i = 0; i < inputStr.length(); i++) {
-		newStr += tolower(inputStr[i]);
+std::string lowerCaseString(const std::string& inputStr) {
+	std::string newStr(inputStr.length(), ' ');
+	for (size_t i = 0; i < inputStr.length(); i++) {
+		newStr[i] = static_cast<char>(tolower(static_cast<unsigned char>(inputStr[i])));
 	}
 	return newStr;
 }
 
+// Returns whether a string is equal to an already lower cased string, ignoring case; the same as
+// lowerCaseString(str) == lowerStr, without building a new string
+bool equalsIgnoringCase(const std::string& str, const std::string& lowerStr) {
+	if (str.length() != lowerStr.length()) {
+		return false;
+	}
+	for (size_t i = 0; i < str.length(); i++) {
+		if (tolower(static_cast<unsigned char>(str[i])) != static_cast<unsigned char>(lowerStr[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Formats a time in seconds since the epoch as a local date and time, like "2024-05-01 13:45"
+std::string formatDate(long long seconds) {
+	std::time_t time = static_cast<std::time_t>(seconds);
+	std::tm localTime = *std::localtime(&time);
+	char text[32];
+	std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &localTime);
+	return text;
+}
+
+// Scans part of a record for quoted fields and returns whether it ends inside one, i.e. the record goes on past the
+// line break. inQuotes is whether the text before it ended inside one. A field is only quoted when its first character
+// is a double quote, so a quote in the middle of an unquoted field (like The 12" Single) is just a character.
+bool endsInQuotedField(const char* text, size_t length, char delimiter, bool inQuotes) {
+    bool atFieldStart = !inQuotes;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (inQuotes) {
+            if (c == '"' && i + 1 < length && text[i + 1] == '"') {
+                i += 1;
+            } else if (c == '"') {
+                inQuotes = false;
+            }
+        } else if (c == delimiter) {
+            atFieldStart = true;
+            continue;
+        } else if (c == '"' && atFieldStart) {
+            inQuotes = true;
+        }
+        atFieldStart = false;
+    }
+    return inQuotes;
+}
+
+// Splits a line where a field can be wrapped in double quotes, so it can have the delimiter, quotes (doubled) or line
+// breaks in it. Only a field that starts with a quote is quoted; anything after its closing quote is kept as it is.
+// Like splitLine, an empty last field isn't returned unless it's quoted ("").
+std::vector<std::string> splitQuotedLine(const std::string& myStr, char delimiter) {
+    std::vector<std::string> currentLine;
+    std::string field;
+    bool inQuotes = false;
+    bool wasQuoted = false;
+    bool atFieldStart = true;
+    for (size_t i = 0; i < myStr.length(); i++) {
+        char c = myStr[i];
+        if (inQuotes) {
+            if (c == '"' && i + 1 < myStr.length() && myStr[i + 1] == '"') {
+                field += '"';
+                i += 1;
+            } else if (c == '"') {
+                inQuotes = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"' && atFieldStart) {
+            inQuotes = true;
+            wasQuoted = true;
+        } else if (c == delimiter) {
+            currentLine.push_back(field);
+            field.clear();
+            wasQuoted = false;
+            atFieldStart = true;
+            continue;
+        } else {
+            field += c;
+        }
+        atFieldStart = false;
+    }
+    if (!field.empty() || wasQuoted) {
+        currentLine.push_back(field);
+    }
+    return currentLine;
+}
+
+// Whether a line has a field that starts with a quote, and so needs splitQuotedLine
+bool hasQuotedField(const std::string& myStr, char delimiter) {
+    if (!myStr.empty() && myStr[0] == '"') {
+        return true;
+    }
+    for (size_t i = myStr.find('"'); i != std::string::npos; i = myStr.find('"', i + 1)) {
+        if (i > 0 && myStr[i - 1] == delimiter) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Splits a line of text by its delimiter, then a vector of data
-std::vector<std::string> splitLine(std::string myStr, char delimiter) {
+std::vector<std::string> splitLine(const std::string& myStr, char delimiter) {
+    // Lines with quoted fields (like the ones the CSV export writes) need the slower parse
+    if (hasQuotedField(myStr, delimiter)) {
+        return splitQuotedLine(myStr, delimiter);
+    }
     std::vector<std::string> currentLine;
     int position = 0;
     int count = 0;
@@ -37,6 +145,22 @@ std::vector<std::string> splitLine(std::string myStr, char delimiter) {
     return currentLine;
 }
 
+// Reads one record from a data file into line. A record is normally one line, but a quoted field can have line breaks
+// in it, so lines are joined while a quoted field is still open. Returns false at the end of the file.
+bool readRecord(std::istream& dataFile, std::string& line, char delimiter) {
+    if (!std::getline(dataFile, line)) {
+        return false;
+    }
+    bool inQuotes = endsInQuotedField(line.data(), line.length(), delimiter, false);
+    std::string nextLine;
+    while (inQuotes && std::getline(dataFile, nextLine)) {
+        line += '\n';
+        line += nextLine;
+        inQuotes = endsInQuotedField(nextLine.data(), nextLine.length(), delimiter, true);
+    }
+    return true;
+}
+
 // Continues to prompt menu input for a user so that their input value is in range
 int validateMenuInput(int inputValue, int minValue, int maxValue) {
     while (inputValue < minValue || inputValue > maxValue) {
@@ -48,6 +172,48 @@ int validateMenuInput(int inputValue, int minValue, int maxValue) {
     return inputValue;
 }
 
+// Keeps the k items that come first according to comesBefore out of everything pushed into it. The items kept are
+// stored in a heap whose top is the one that comes last, so each push is O(log k) and picking the first k out of
+// n items costs O(n log k), rather than the O(n log n) of sorting all n of them.
+template <class T, class Compare>
+class TopKSelector {
+private:
+    size_t k;
+    Compare comesBefore;
+    std::vector<T> heap;
+public:
+    TopKSelector(size_t _k, Compare _comesBefore) : k(_k), comesBefore(_comesBefore) {}
+
+    void push(const T& item) {
+        if (k == 0) {
+            return;
+        }
+        if (heap.size() < k) {
+            heap.push_back(item);
+            std::push_heap(heap.begin(), heap.end(), comesBefore);
+        } else if (comesBefore(item, heap.front())) {
+            // The new item comes before the last one we're keeping, so swap them
+            std::pop_heap(heap.begin(), heap.end(), comesBefore);
+            heap.back() = item;
+            std::push_heap(heap.begin(), heap.end(), comesBefore);
+        }
+    }
+
+    // Returns the items kept, in order; the selector is empty afterwards
+    std::vector<T> takeSorted() {
+        std::sort_heap(heap.begin(), heap.end(), comesBefore);
+        std::vector<T> result;
+        result.swap(heap);
+        return result;
+    }
+};
+
+// Helper so the compiler can work out the comparison type, like std::make_pair
+template <class T, class Compare>
+TopKSelector<T, Compare> makeTopKSelector(size_t k, Compare comesBefore) {
+    return TopKSelector<T, Compare>(k, comesBefore);
+}
+
 // Merge Sort:
 // divideList, firstList should contain the items, and we are sharing it with the second list
 template <class T>
@@ -56,8 +222,8 @@ void divideList(std::vector<T>& firstList, std::vector<T>& secondList) {
         return;
     }
     int mid = firstList.size() / 2;
-    // Assigns the secondList with the firstList's items from the middle to the end
-    secondList.assign(firstList.begin() + mid, firstList.end());
+    // Moves the firstList's items from the middle to the end into the secondList
+    secondList.assign(std::make_move_iterator(firstList.begin() + mid), std::make_move_iterator(firstList.end()));
     // Since we allocated those elements from firstList, we have to delete those elemenst
     firstList.erase(firstList.begin() + mid, firstList.end());
 }
@@ -65,7 +231,9 @@ void divideList(std::vector<T>& firstList, std::vector<T>& secondList) {
 // Merge part of merge sort
 template <class T>
 std::vector<T> mergeList(std::vector<T>& firstList, std::vector<T>& secondList, bool ascending) {
+    // NOTE: Items are moved out of the two halves, since they're thrown away after the merge
     std::vector<T> mergedList;
+    mergedList.reserve(firstList.size() + secondList.size());
     size_t i = 0; // index for first list
     size_t j = 0; // index for second list
     // Start putting sorted items in the merged list
@@ -73,52 +241,59 @@ std::vector<T> mergeList(std::vector<T>& firstList, std::vector<T>& secondList,
         // The logic if we're sorting in ascending order; so we're pushing in the smaller values first
         if (ascending) {
             if (firstList[i] < secondList[j]) {
-                mergedList.push_back(firstList[i]);
+                mergedList.push_back(std::move(firstList[i]));
                 i += 1;
             } else {
-                mergedList.push_back(secondList[j]);
+                mergedList.push_back(std::move(secondList[j]));
                 j += 1;
             }
         } else {
             // It's putting in descending order, so we prioritize pushing the larger items first
             // First item is larger so push it
             if (firstList[i] > secondList[j]) {
-                mergedList.push_back(firstList[i]);
+                mergedList.push_back(std::move(firstList[i]));
                 i += 1;
             } else {
                 // Second item is larger or equal so push it
-                mergedList.push_back(secondList[j]);
+                mergedList.push_back(std::move(secondList[j]));
                 j += 1;
             }
         }
     }
     // Now put the remaining items at the end of the mergedList vector
     for (size_t index = i; index < firstList.size(); index++) {
-        mergedList.push_back(firstList[index]);
+        mergedList.push_back(std::move(firstList[index]));
     }
     for (size_t index = j; index < secondList.size(); index++) {
-        mergedList.push_back(secondList[index]);
+        mergedList.push_back(std::move(secondList[index]));
     }
     // return the merged list
     return mergedList;
 }
 
+// Sorts items in place; each level moves the items into its halves and the merged list back, without copying them
 template <class T>
-std::vector<T> mergeSort(std::vector<T>& items, bool ascending = true) {
-    // If the list is empty or there's only one thing, just return the list/stop procedure for that call
+void mergeSortInPlace(std::vector<T>& items, bool ascending = true) {
+    // If the list is empty or there's only one thing, it's already sorted
     if (items.size() <= 1) {
-        return items;
+        return;
     }
     // Create a second branch or sublist
     std::vector<T> items2;
     // Divide the list
     divideList(items, items2);
-    // call merge sort
-    items = mergeSort(items, ascending);
-    // call merge sort
-    items2 = mergeSort(items2, ascending);
-    // mergeList: combine the lists and return the result up the stack
+    // Sort both halves
+    mergeSortInPlace(items, ascending);
+    mergeSortInPlace(items2, ascending);
+    // mergeList: combine the lists; the merged list is moved into items
     items = mergeList(items, items2, ascending);
+}
+
+// Sorts items in place and returns a copy of them
+// NOTE: The copy is the only one made; callers that don't need it should use mergeSortInPlace
+template <class T>
+std::vector<T> mergeSort(std::vector<T>& items, bool ascending = true) {
+    mergeSortInPlace(items, ascending);
     return items;
 }
 